@@ -1,4 +1,4 @@
-QT       += core gui sql
+QT       += core gui sql concurrent network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 
@@ -9,21 +9,72 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    src/AccountList.cpp \
+    src/AnomalyDetector.cpp \
+    src/BalanceForecaster.cpp \
+    src/BudgetTableModel.cpp \
+    src/BudgetTargets.cpp \
     src/BudgetTracker.cpp \
+    src/CategoryIndex.cpp \
+    src/ColumnSizer.cpp \
+    src/EntryImporter.cpp \
+    src/EntryJournal.cpp \
+    src/EntryLog.cpp \
+    src/ExchangeRates.cpp \
     src/ForgotLoginDialog.cpp \
+    src/LedgerBench.cpp \
+    src/LedgerCipher.cpp \
+    src/LedgerExporter.cpp \
+    src/LedgerQuery.cpp \
+    src/LedgerSession.cpp \
+    src/LedgerStress.cpp \
+    src/LoginAudit.cpp \
     src/LoginDatabaseManager.cpp \
+    src/LoginThrottle.cpp \
+    src/RecurringDialog.cpp \
+    src/RecurringSchedule.cpp \
     src/RegistrationDialog.cpp \
+    src/ReportGenerator.cpp \
+    src/SchemaMigrator.cpp \
+    src/SessionManager.cpp \
+    src/StartupProfile.cpp \
     src/User.cpp \
     src/main.cpp \
     src/LoginDialog.cpp \
     src/qcustomplot.cpp
 
 HEADERS += \
+    src/AccountList.h \
+    src/AnomalyDetector.h \
+    src/BalanceForecaster.h \
+    src/BudgetTableModel.h \
+    src/BudgetTargets.h \
     src/BudgetTracker.h \
+    src/CategoryIndex.h \
+    src/ColumnSizer.h \
+    src/EntryImporter.h \
+    src/EntryJournal.h \
+    src/EntryLog.h \
+    src/ExchangeRates.h \
     src/ForgotLoginDialog.h \
+    src/LedgerBench.h \
+    src/LedgerCipher.h \
+    src/LedgerExporter.h \
+    src/LedgerQuery.h \
+    src/LedgerSession.h \
+    src/LedgerStress.h \
+    src/LoginAudit.h \
     src/LoginDatabaseManager.h \
     src/LoginDialog.h \
+    src/LoginThrottle.h \
+    src/RecurringDialog.h \
+    src/RecurringSchedule.h \
     src/RegistrationDialog.h \
+    src/ReportGenerator.h \
+    src/SchemaMigrator.h \
+    src/SessionManager.h \
+    src/StartupProfile.h \
+    src/Transaction.h \
     src/User.h \
     src/qcustomplot.h
 
@@ -31,6 +82,7 @@ FORMS += \
     src/BudgetTracker.ui \
     src/ForgotLoginDialog.ui \
     src/LoginDialog.ui \
+    src/RecurringDialog.ui \
     src/RegistrationDialog.ui
 
 # Default rules for deployment.
@@ -0,0 +1,97 @@
+#include "AccountList.h"
+
+#include <QSqlQuery>
+
+/**
+ * @brief AccountList::AccountList
+ *        Default constructor. List is empty until load() is called.
+ */
+AccountList::AccountList() {}
+
+/**
+ * @brief AccountList::load
+ *        Loads all accounts from account table.
+ *
+ *        Accounts added afterwards are stored on the same database.
+ * @param database open user database
+ */
+void AccountList::load(const QSqlDatabase &database)
+{
+    m_database = database;
+    m_accounts.clear();
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.exec("SELECT accountID, name "
+               "FROM account "
+               "ORDER BY accountID");
+    while (query.next()) {
+        Account account;
+        account.accountID = query.value(0).toLongLong();
+        account.name = query.value(1).toString();
+        m_accounts.append(account);
+    }
+}
+
+/**
+ * @brief AccountList::addAccount
+ *        Stores new account.
+ * @param name account name; must not be in use
+ * @return accountID of new account; 0 if it could not be stored
+ */
+qint64 AccountList::addAccount(const QString &name)
+{
+    if (name.isEmpty() || accountID(name) != 0)
+        return 0;
+
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO account "
+                  "(accountID, name) "
+                  "VALUES (NULL, ?)");
+    query.bindValue(0, name);
+    if (!query.exec())
+        return 0;
+
+    Account account;
+    account.accountID = query.lastInsertId().toLongLong();
+    account.name = name;
+    m_accounts.append(account);
+    return account.accountID;
+}
+
+/**
+ * @brief AccountList::accounts
+ * @return all loaded accounts, ordered by accountID
+ */
+QVector<Account> AccountList::accounts() const
+{
+    return m_accounts;
+}
+
+/**
+ * @brief AccountList::name
+ * @param accountID ID of account
+ * @return account name; empty if unknown
+ */
+QString AccountList::name(qint64 accountID) const
+{
+    for (const Account &account : m_accounts) {
+        if (account.accountID == accountID)
+            return account.name;
+    }
+    return QString();
+}
+
+/**
+ * @brief AccountList::accountID
+ * @param name account name
+ * @return ID of account with name; 0 if unknown
+ */
+qint64 AccountList::accountID(const QString &name) const
+{
+    for (const Account &account : m_accounts) {
+        if (account.name == name)
+            return account.accountID;
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The Account struct
+ *        One row of the account table.
+ */
+struct Account {
+    qint64 accountID = 0;
+    QString name;
+};
+
+/**
+ * @brief The AccountList class
+ *        Accounts of the current user (checking, savings, cards, ...).
+ *
+ *        Every budget and recurring row belongs to one account. The list is
+ *        small, so it is loaded once and looked up in memory.
+ */
+class AccountList {
+public:
+    // constructor
+    AccountList();
+
+    // account management
+    void load(const QSqlDatabase &database);
+    qint64 addAccount(const QString &name);
+    QVector<Account> accounts() const;
+
+    // lookups
+    QString name(qint64 accountID) const;
+    qint64 accountID(const QString &name) const;
+
+    static const qint64 DefaultAccountID = 1;   // account of entries made before accounts existed
+
+private:
+    QSqlDatabase m_database;
+    QVector<Account> m_accounts;    // ordered by accountID
+};
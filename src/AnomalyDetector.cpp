@@ -0,0 +1,314 @@
+#include "AnomalyDetector.h"
+
+#include <QSqlQuery>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief AnomalyDetector::AnomalyDetector
+ *        Default constructor. Nothing is flagged until load() is called.
+ */
+AnomalyDetector::AnomalyDetector() {}
+
+/**
+ * @brief AnomalyDetector::load
+ *        Rebuilds statistics of all categories from the ledger.
+ *
+ *        Rows are read and converted on the calling thread, since the
+ *        rates' factor cache is not thread-safe. Statistics and unusual
+ *        entries of each category are then computed in parallel.
+ *        Reload after rates or display currency changed.
+ * @param database open user database
+ * @param rates exchange rates amounts are converted with
+ */
+void AnomalyDetector::load(const QSqlDatabase &database, const ExchangeRates *rates)
+{
+    m_rates = rates;
+    m_stats.clear();
+    m_flagged.clear();
+
+    QHash<Key, Group> groups;
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    query.exec("SELECT transactionID, date, category, subcategory, amount, currency, accountID "
+               "FROM budget");
+    while (query.next()) {
+        Transaction entry;
+        entry.transactionID = query.value(0).toLongLong();
+        entry.date = query.value(1).toString();
+        entry.category = query.value(2).toString();
+        entry.subcategory = query.value(3).toString();
+        entry.amount = query.value(4).toDouble();
+        entry.currency = query.value(5).toString();
+        entry.accountID = query.value(6).toLongLong();
+        Group &group = groups[Key(entry.category, entry.subcategory)];
+        group.amounts.append(m_rates->convert(entry));
+        group.entries.append(entry);
+    }
+
+    QVector<Group> work;
+    QVector<Key> keys;
+    work.reserve(groups.size());
+    keys.reserve(groups.size());
+    for (auto it = groups.begin(); it != groups.end(); ++it) {
+        keys.append(it.key());
+        work.append(std::move(it.value()));
+    }
+    groups.clear();
+    QtConcurrent::blockingMap(work, &AnomalyDetector::buildGroup);
+
+    for (int i = 0; i < work.size(); ++i) {
+        m_stats.insert(keys.at(i), work.at(i).stats);
+        if (!work.at(i).flagged.isEmpty())
+            m_flagged.insert(keys.at(i), work.at(i).flagged);
+    }
+}
+
+/**
+ * @brief AnomalyDetector::addEntry
+ *        Adds amount of stored entry to its category's statistics, and
+ *        remembers entry if it is unusual.
+ * @param entry added entry
+ */
+void AnomalyDetector::addEntry(const Transaction &entry)
+{
+    if (entry.ruleID != 0 || !m_rates)
+        return;
+    Key key(entry.category, entry.subcategory);
+    Stats &stats = m_stats[key];
+    double amount = m_rates->convert(entry);
+    stats.add(amount);
+    if (stats.isAnomaly(amount))
+        m_flagged[key].append(entry);
+}
+
+/**
+ * @brief AnomalyDetector::removeEntry
+ *        Removes amount of stored entry from its category's statistics.
+ * @param entry removed entry
+ */
+void AnomalyDetector::removeEntry(const Transaction &entry)
+{
+    if (entry.ruleID != 0 || !m_rates)
+        return;
+    Key key(entry.category, entry.subcategory);
+    auto it = m_stats.find(key);
+    if (it == m_stats.end())
+        return;
+    it->remove(m_rates->convert(entry));
+
+    auto flaggedIt = m_flagged.find(key);
+    if (flaggedIt == m_flagged.end())
+        return;
+    for (int i = 0; i < flaggedIt->size(); ++i) {
+        if (flaggedIt->at(i).transactionID == entry.transactionID) {
+            flaggedIt->removeAt(i);
+            break;
+        }
+    }
+    if (flaggedIt->isEmpty())
+        m_flagged.erase(flaggedIt);
+}
+
+/**
+ * @brief AnomalyDetector::isAnomaly
+ * @param category entry category
+ * @param subcategory entry subcategory
+ * @param amount entry amount in display currency
+ * @return true if amount is unusual for the category
+ */
+bool AnomalyDetector::isAnomaly(const QString &category, const QString &subcategory,
+                                double amount) const
+{
+    auto it = m_stats.constFind(Key(category, subcategory));
+    return it != m_stats.constEnd() && it->isAnomaly(amount);
+}
+
+/**
+ * @brief AnomalyDetector::typicalAmount
+ * @param category category
+ * @param subcategory subcategory
+ * @return estimated median amount in display currency; 0 if unknown
+ */
+double AnomalyDetector::typicalAmount(const QString &category, const QString &subcategory) const
+{
+    auto it = m_stats.constFind(Key(category, subcategory));
+    return it != m_stats.constEnd() ? it->median() : 0;
+}
+
+/**
+ * @brief AnomalyDetector::anomalies
+ *        Lists remembered entries that are still unusual.
+ * @param category category filter; empty for all entries
+ * @param subcategory subcategory filter; ignored if category is empty
+ * @return unusual entries, unordered
+ */
+QVector<Transaction> AnomalyDetector::anomalies(const QString &category,
+                                                const QString &subcategory) const
+{
+    QVector<Transaction> anomalies;
+    for (auto it = m_flagged.constBegin(); it != m_flagged.constEnd(); ++it) {
+        if (!category.isEmpty() && it.key().first != category)
+            continue;
+        if (!category.isEmpty() && !subcategory.isEmpty() && it.key().second != subcategory)
+            continue;
+        const Stats stats = m_stats.value(it.key());
+        for (const Transaction &entry : it.value()) {
+            if (stats.isAnomaly(m_rates->convert(entry)))
+                anomalies.append(entry);
+        }
+    }
+    return anomalies;
+}
+
+/**
+ * @brief AnomalyDetector::buildGroup
+ *        Worker: streams a category's amounts into its statistics, then
+ *        flags its entries against the final statistics.
+ * @param group loaded category
+ */
+void AnomalyDetector::buildGroup(Group &group)
+{
+    for (double amount : group.amounts)
+        group.stats.add(amount);
+    for (int i = 0; i < group.entries.size(); ++i) {
+        if (group.stats.isAnomaly(group.amounts.at(i)))
+            group.flagged.append(group.entries.at(i));
+    }
+    group.entries.clear();
+    group.amounts.clear();
+}
+
+/**
+ * @brief AnomalyDetector::Stats::add
+ *        Adds amount to mean, variance and median sketch.
+ *
+ *        The sketch is the P² algorithm: five markers track the minimum,
+ *        quartiles, median and maximum, and each new amount moves markers
+ *        towards their desired positions by parabolic interpolation.
+ * @param amount amount in display currency
+ */
+void AnomalyDetector::Stats::add(double amount)
+{
+    ++count;
+    double delta = amount - mean;
+    mean += delta / count;
+    m2 += delta * (amount - mean);
+
+    // first five amounts are kept as they are
+    if (sketchCount < 5) {
+        heights[sketchCount++] = amount;
+        if (sketchCount == 5) {
+            std::sort(heights, heights + 5);
+            for (int i = 0; i < 5; ++i)
+                positions[i] = i;
+            desired[0] = 0;
+            desired[1] = 1;
+            desired[2] = 2;
+            desired[3] = 3;
+            desired[4] = 4;
+        }
+        return;
+    }
+    ++sketchCount;
+
+    // cell of amount, extending the extremes if needed
+    int cell;
+    if (amount < heights[0]) {
+        heights[0] = amount;
+        cell = 0;
+    } else if (amount >= heights[4]) {
+        heights[4] = amount;
+        cell = 3;
+    } else {
+        cell = 0;
+        while (amount >= heights[cell + 1])
+            ++cell;
+    }
+    for (int i = cell + 1; i < 5; ++i)
+        positions[i] += 1;
+    // desired positions of minimum, quartiles, median and maximum
+    const double increments[5] = {0, 0.25, 0.5, 0.75, 1};
+    for (int i = 0; i < 5; ++i)
+        desired[i] += increments[i];
+
+    for (int i = 1; i < 4; ++i) {
+        double offset = desired[i] - positions[i];
+        if ((offset >= 1 && positions[i + 1] - positions[i] > 1)
+            || (offset <= -1 && positions[i - 1] - positions[i] < -1)) {
+            int step = offset > 0 ? 1 : -1;
+            double parabolic = heights[i] + step / (positions[i + 1] - positions[i - 1])
+                * ((positions[i] - positions[i - 1] + step) * (heights[i + 1] - heights[i])
+                       / (positions[i + 1] - positions[i])
+                   + (positions[i + 1] - positions[i] - step) * (heights[i] - heights[i - 1])
+                       / (positions[i] - positions[i - 1]));
+            if (heights[i - 1] < parabolic && parabolic < heights[i + 1]) {
+                heights[i] = parabolic;
+            } else {
+                heights[i] += step * (heights[i + step] - heights[i])
+                              / (positions[i + step] - positions[i]);
+            }
+            positions[i] += step;
+        }
+    }
+}
+
+/**
+ * @brief AnomalyDetector::Stats::remove
+ *        Takes amount back out of mean and variance.
+ * @param amount amount in display currency, as it was added
+ */
+void AnomalyDetector::Stats::remove(double amount)
+{
+    if (count <= 1) {
+        count = 0;
+        mean = 0;
+        m2 = 0;
+        return;
+    }
+    double previousMean = mean;
+    mean = (count * mean - amount) / (count - 1);
+    m2 = std::max(0.0, m2 - (amount - previousMean) * (amount - mean));
+    --count;
+}
+
+/**
+ * @brief AnomalyDetector::Stats::deviation
+ * @return sample standard deviation; 0 below two amounts
+ */
+double AnomalyDetector::Stats::deviation() const
+{
+    return count > 1 ? std::sqrt(m2 / (count - 1)) : 0;
+}
+
+/**
+ * @brief AnomalyDetector::Stats::median
+ * @return estimated median; exact below five amounts
+ */
+double AnomalyDetector::Stats::median() const
+{
+    if (sketchCount >= 5)
+        return heights[2];
+    if (sketchCount == 0)
+        return 0;
+    double sorted[5];
+    std::copy(heights, heights + sketchCount, sorted);
+    std::sort(sorted, sorted + sketchCount);
+    return sketchCount % 2 ? sorted[sketchCount / 2]
+                           : (sorted[sketchCount / 2 - 1] + sorted[sketchCount / 2]) / 2;
+}
+
+/**
+ * @brief AnomalyDetector::Stats::isAnomaly
+ * @param amount amount in display currency
+ * @return true if amount lies more than Threshold deviations from the median
+ */
+bool AnomalyDetector::Stats::isAnomaly(double amount) const
+{
+    if (count < MinSamples)
+        return false;
+    double deviation = this->deviation();
+    return deviation > 0 && std::abs(amount - median()) > Threshold * deviation;
+}
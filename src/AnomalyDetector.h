@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ExchangeRates.h"
+#include "Transaction.h"
+
+#include <QHash>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QVector>
+
+/**
+ * @brief The AnomalyDetector class
+ *        Streaming amount statistics per category and subcategory, used to
+ *        flag unusual transactions.
+ *
+ *        Each category/subcategory keeps an online mean and variance
+ *        (Welford) and a P² median sketch of its amounts in display
+ *        currency, so adding an entry is O(1) and no history is kept. An
+ *        amount is unusual once its category has MinSamples entries and it
+ *        lies more than Threshold standard deviations from the median.
+ *
+ *        Entries found unusual are remembered per category for the plot and
+ *        rechecked against current statistics when listed. load() rebuilds
+ *        everything, computing categories in parallel.
+ */
+class AnomalyDetector
+{
+public:
+    static const int MinSamples = 10;               // entries before a category flags anything
+    static constexpr double Threshold = 3.0;        // distance from median, in standard deviations
+
+    // constructor
+    AnomalyDetector();
+
+    // loading
+    void load(const QSqlDatabase &database, const ExchangeRates *rates);
+
+    // incremental updates
+    void addEntry(const Transaction &entry);
+    void removeEntry(const Transaction &entry);
+
+    // lookups
+    bool isAnomaly(const QString &category, const QString &subcategory, double amount) const;
+    double typicalAmount(const QString &category, const QString &subcategory) const;
+    QVector<Transaction> anomalies(const QString &category, const QString &subcategory) const;
+
+private:
+    /**
+     * @brief The Stats struct
+     *        Online mean/variance and P² median sketch of one category.
+     *
+     *        Removals are undone exactly in mean and variance; the median
+     *        sketch cannot forget values and keeps them until the next load.
+     */
+    struct Stats {
+        qint64 count = 0;           // amounts in mean and variance
+        double mean = 0;
+        double m2 = 0;              // sum of squared deviations from mean
+        int sketchCount = 0;        // amounts seen by the median sketch
+        double heights[5] = {};     // P² marker heights; first amounts until five are seen
+        double positions[5] = {};   // P² marker positions
+        double desired[5] = {};     // P² desired marker positions
+
+        void add(double amount);
+        void remove(double amount);
+        double deviation() const;
+        double median() const;
+        bool isAnomaly(double amount) const;
+    };
+
+    /**
+     * @brief The Group struct
+     *        Entries of one category loaded for a parallel rebuild.
+     */
+    struct Group {
+        QVector<Transaction> entries;
+        QVector<double> amounts;        // entry amounts in display currency
+        Stats stats;
+        QVector<Transaction> flagged;
+    };
+
+    typedef QPair<QString, QString> Key;
+
+    const ExchangeRates *m_rates = nullptr;
+    QHash<Key, Stats> m_stats;                      // statistics by category and subcategory
+    QHash<Key, QVector<Transaction>> m_flagged;     // entries unusual when added
+
+    static void buildGroup(Group &group);
+};
@@ -0,0 +1,252 @@
+#include "BalanceForecaster.h"
+#include "LedgerCipher.h"
+#include "LedgerQuery.h"
+
+#include <QDebug>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace {
+const int MovingAverageMonths = 3;  // complete months averaged per category
+
+/**
+ * @brief monthIndex
+ * @return months since year 0, used as ForecastState::monthlySums key
+ */
+int monthIndex(const QDate &date)
+{
+    return date.year() * 12 + date.month() - 1;
+}
+
+/**
+ * @brief dateToKey
+ * @return plot key of date (seconds since epoch, as QCPAxisTickerDateTime uses)
+ */
+double dateToKey(const QDate &date)
+{
+    return date.startOfDay().toMSecsSinceEpoch() / 1000.0;
+}
+}
+
+/**
+ * @brief BalanceForecaster::BalanceForecaster
+ *        Creates forecaster reading from clones of a database connection.
+ * @param connectionName name of open user database connection
+ * @param key raw ledger key; empty for an unencrypted ledger
+ * @param parent pointer to QObject parent object
+ */
+BalanceForecaster::BalanceForecaster(const QString &connectionName, const QByteArray &key,
+                                     QObject *parent)
+    : QObject(parent)
+    , m_connectionName(connectionName)
+    , m_key(key)
+{
+    connect(&m_watcher, &QFutureWatcher<ForecastResult>::finished,
+            this, &BalanceForecaster::finished);
+}
+
+/**
+ * @brief BalanceForecaster::~BalanceForecaster
+ *        Waits for running forecast, so its connection is closed first.
+ */
+BalanceForecaster::~BalanceForecaster()
+{
+    m_watcher.waitForFinished();
+}
+
+/**
+ * @brief BalanceForecaster::request
+ *        Starts forecast for filter, or queues it behind the running one.
+ *
+ *        Only the latest queued request per filter is kept, so windows
+ *        sharing the forecaster with different filters all get an answer.
+ * @param category plot category filter; empty for all transactions
+ * @param subcategory plot subcategory filter
+ * @param recurring projected recurring entries up to end of forecast, ordered by date
+ */
+void BalanceForecaster::request(const QString &category, const QString &subcategory,
+                                const QVector<Transaction> &recurring)
+{
+    Request request{category, subcategory, recurring};
+    if (m_watcher.isRunning()) {
+        m_queued.insert(filterKey(category, subcategory), request);
+        return;
+    }
+    start(request);
+}
+
+/**
+ * @brief BalanceForecaster::invalidate
+ *        Drops all cached aggregates.
+ *
+ *        Needed when existing entries were edited or removed, since
+ *        aggregates only fold in entries with a newer transactionID.
+ */
+void BalanceForecaster::invalidate()
+{
+    m_cache.clear();
+    ++m_generation;
+}
+
+/**
+ * @brief BalanceForecaster::setRates
+ *        Sets exchange rates used by later runs.
+ *
+ *        Cached aggregates hold converted sums, so they are dropped.
+ * @param rates exchange rates with display currency
+ */
+void BalanceForecaster::setRates(const ExchangeRates &rates)
+{
+    m_rates = rates;
+    invalidate();
+}
+
+/**
+ * @brief BalanceForecaster::finished
+ *        Caches aggregate of finished run and reports its curve,
+ *        then starts a queued request, if any.
+ */
+void BalanceForecaster::finished()
+{
+    ForecastResult result = m_watcher.result();
+
+    if (m_runningGeneration == m_generation) {
+        m_cache.insert(result.filterKey, result.state);
+        emit forecastReady(m_running.category, m_running.subcategory,
+                           result.keys, result.balances);
+    } else if (!m_queued.contains(result.filterKey)) {
+        // cache was invalidated mid-run, so rerun from scratch
+        m_queued.insert(result.filterKey, m_running);
+    }
+
+    if (!m_queued.isEmpty())
+        start(m_queued.take(m_queued.firstKey()));
+}
+
+/**
+ * @brief BalanceForecaster::start
+ *        Runs request on the thread pool with a copy of its cached aggregate.
+ * @param request forecast request
+ */
+void BalanceForecaster::start(const Request &request)
+{
+    m_running = request;
+    m_runningGeneration = m_generation;
+    ForecastState state = m_cache.value(filterKey(request.category, request.subcategory));
+    m_watcher.setFuture(QtConcurrent::run(&BalanceForecaster::run, m_connectionName, m_key, m_rates,
+                                          request.category, request.subcategory,
+                                          state, request.recurring));
+}
+
+/**
+ * @brief BalanceForecaster::filterKey
+ * @return cache key for category/subcategory filter
+ */
+QString BalanceForecaster::filterKey(const QString &category, const QString &subcategory)
+{
+    return category + QChar('\x1f') + subcategory;
+}
+
+/**
+ * @brief BalanceForecaster::run
+ *        Worker: folds entries newer than state's watermark into the
+ *        aggregate, then projects monthly balance points.
+ *
+ *        Categories with recurring rules are projected from their rule
+ *        occurrences instead of their moving average.
+ * @param connectionName connection to clone for this thread
+ * @param key raw ledger key; empty for an unencrypted ledger
+ * @param rates exchange rates to convert amounts with
+ * @param category plot category filter; empty for all transactions
+ * @param subcategory plot subcategory filter
+ * @param state cached aggregate (empty for a full rebuild)
+ * @param recurring projected recurring entries up to end of forecast, ordered by date
+ * @return updated aggregate and projected curve
+ */
+ForecastResult BalanceForecaster::run(const QString &connectionName, const QByteArray &key,
+                                      const ExchangeRates &rates,
+                                      const QString &category, const QString &subcategory,
+                                      ForecastState state, const QVector<Transaction> &recurring)
+{
+    ForecastResult result;
+    result.filterKey = filterKey(category, subcategory);
+
+    // fold in new entries on a connection owned by this thread
+    QString workerConnection = QString("forecast_%1")
+                                   .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    {
+        QSqlDatabase database = QSqlDatabase::cloneDatabase(connectionName, workerConnection);
+        if (LedgerCipher::open(database, key)) {
+            QSqlQuery query(database);
+            query.setForwardOnly(true);
+            LedgerFilter filter;
+            filter.category = category;
+            filter.subcategory = subcategory;
+            LedgerQuery::prepare<LedgerQuery::NewEntries>(query, filter);
+            query.bindValue(0, state.lastTransactionID);
+            // on failure the state is not advanced, so the next request reads the rows again
+            if (!query.exec())
+                qWarning() << "Forecast query failed:" << query.lastError().text();
+            while (query.next()) {
+                Transaction entry = LedgerQuery::readEntry(query);
+                QDate date = QDate::fromString(entry.date, "yyyy/MM/dd");
+                double amount = rates.convert(entry);
+                state.monthlySums[monthIndex(date)][entry.category] += amount;
+                state.balance += amount;
+                state.lastTransactionID = std::max(state.lastTransactionID, entry.transactionID);
+            }
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(workerConnection);
+
+    // moving average of the last complete months, per non-recurring category
+    QSet<QString> recurringCategories;
+    for (const Transaction &entry : recurring)
+        recurringCategories.insert(entry.category);
+
+    QDate today = QDate::currentDate();
+    int currentMonth = monthIndex(today);
+    double monthlyTrend = 0;
+    for (int month = currentMonth - MovingAverageMonths; month < currentMonth; ++month) {
+        auto monthIt = state.monthlySums.constFind(month);
+        if (monthIt == state.monthlySums.constEnd())
+            continue;
+        for (auto it = monthIt->constBegin(); it != monthIt->constEnd(); ++it) {
+            if (!recurringCategories.contains(it.key()))
+                monthlyTrend += it.value() / MovingAverageMonths;
+        }
+    }
+
+    // start from today's balance, which includes past recurring occurrences
+    double balance = state.balance;
+    int next = 0;
+    while (next < recurring.size()
+           && QDate::fromString(recurring.at(next).date, "yyyy/MM/dd") <= today) {
+        balance += rates.convert(recurring.at(next));
+        ++next;
+    }
+    result.keys.append(dateToKey(today));
+    result.balances.append(balance);
+
+    // project one point per month, adding recurring occurrences as they fall due
+    for (int month = 1; month <= ForecastMonths; ++month) {
+        QDate date = today.addMonths(month);
+        balance += monthlyTrend;
+        while (next < recurring.size()
+               && QDate::fromString(recurring.at(next).date, "yyyy/MM/dd") <= date) {
+            balance += rates.convert(recurring.at(next));
+            ++next;
+        }
+        result.keys.append(dateToKey(date));
+        result.balances.append(balance);
+    }
+
+    result.state = state;
+    return result;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ExchangeRates.h"
+#include "Transaction.h"
+
+#include <QDate>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+/**
+ * @brief The ForecastState struct
+ *        Incremental ledger aggregate for one plot filter.
+ *
+ *        Holds per-month, per-category sums of every stored entry up to
+ *        lastTransactionID, so new entries only need to be folded in.
+ */
+struct ForecastState {
+    QMap<int, QHash<QString, double>> monthlySums;  // keyed by year * 12 + month - 1
+    double balance = 0;                             // sum of all aggregated entries
+    qint64 lastTransactionID = 0;                   // highest transactionID aggregated
+};
+
+/**
+ * @brief The ForecastResult struct
+ *        Output of one forecast run.
+ */
+struct ForecastResult {
+    QString filterKey;
+    ForecastState state;
+    QVector<double> keys;       // plot keys of projected balance points
+    QVector<double> balances;   // projected balance at each key
+};
+
+/**
+ * @brief The BalanceForecaster class
+ *        Projects balance curve from ledger history on a worker thread.
+ *
+ *        Per-category moving averages of monthly totals are combined with
+ *        recurring rule occurrences, all in the display currency. Aggregates are cached per filter, and
+ *        each run only reads entries newer than the cached watermark on its
+ *        own database connection, so the GUI thread never waits on it.
+ */
+class BalanceForecaster : public QObject
+{
+    Q_OBJECT
+
+public:
+    // constructor and destructor
+    BalanceForecaster(const QString &connectionName, const QByteArray &key,
+                      QObject *parent = nullptr);
+    ~BalanceForecaster();
+
+    // forecast requests
+    void request(const QString &category, const QString &subcategory,
+                 const QVector<Transaction> &recurring);
+    void invalidate();
+    void setRates(const ExchangeRates &rates);
+
+    static const int ForecastMonths = 6;
+
+signals:
+    void forecastReady(const QString &category, const QString &subcategory,
+                       const QVector<double> &keys, const QVector<double> &balances);
+
+private slots:
+    void finished();
+
+private:
+    /**
+     * @brief The Request struct
+     *        Parameters of a queued forecast run.
+     */
+    struct Request {
+        QString category;
+        QString subcategory;
+        QVector<Transaction> recurring;
+    };
+
+    QString m_connectionName;                   // connection that workers clone
+    QByteArray m_key;                           // ledger key applied to each clone
+    ExchangeRates m_rates;                      // copy handed to each run for conversion
+    QHash<QString, ForecastState> m_cache;      // aggregate per filter key
+    QFutureWatcher<ForecastResult> m_watcher;
+    Request m_running;                          // request currently on the worker
+    QMap<QString, Request> m_queued;            // latest request per filter key made while running
+    int m_generation = 0;                       // bumped by invalidate() to drop stale results
+    int m_runningGeneration = 0;
+
+    void start(const Request &request);
+
+    static QString filterKey(const QString &category, const QString &subcategory);
+    static ForecastResult run(const QString &connectionName, const QByteArray &key,
+                              const ExchangeRates &rates,
+                              const QString &category, const QString &subcategory,
+                              ForecastState state, const QVector<Transaction> &recurring);
+};
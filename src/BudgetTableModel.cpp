@@ -0,0 +1,837 @@
+#include "BudgetTableModel.h"
+#include "LedgerQuery.h"
+
+#include <QBrush>
+#include <QDate>
+#include <QDebug>
+#include <QFont>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+namespace {
+/**
+ * @brief entryLessThan
+ *        Table ordering: by date, then stored entries before projected
+ *        entries (by ruleID), then by transactionID.
+ */
+bool entryLessThan(const Transaction &a, const Transaction &b)
+{
+    if (a.date != b.date)
+        return a.date < b.date;
+    if (a.ruleID != b.ruleID)
+        return a.ruleID < b.ruleID;
+    return a.transactionID < b.transactionID;
+}
+}
+
+/**
+ * @brief BudgetTableModel::BudgetTableModel
+ *        Connects model to entry journal. Model is empty until setFilter() or reload().
+ * @param database open user database
+ * @param journal entry journal that all edits go through
+ * @param schedule recurring rules to project entries from
+ * @param rates exchange rates balances are converted with
+ * @param accounts accounts entries belong to
+ * @param anomalies amount statistics unusual entries are flagged with
+ * @param parent pointer to QObject parent object
+ */
+BudgetTableModel::BudgetTableModel(const QSqlDatabase &database, EntryJournal *journal,
+                                   const RecurringSchedule *schedule, const ExchangeRates *rates,
+                                   const AccountList *accounts, const AnomalyDetector *anomalies,
+                                   QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_database(database)
+    , m_journal(journal)
+    , m_schedule(schedule)
+    , m_rates(rates)
+    , m_accounts(accounts)
+    , m_anomalies(anomalies)
+    , loadTimer(new QTimer(this))
+{
+    connect(loadTimer, &QTimer::timeout,
+            this, &BudgetTableModel::loadNextChunk);
+    connect(m_journal, &EntryJournal::entryAdded,
+            this, &BudgetTableModel::insertEntry);
+    connect(m_journal, &EntryJournal::entryRemoved,
+            this, &BudgetTableModel::removeEntry);
+    connect(m_journal, &EntryJournal::entryChanged,
+            this, &BudgetTableModel::changeEntry);
+    connect(m_journal, &EntryJournal::submitted,
+            this, &BudgetTableModel::entriesSubmitted);
+    connect(m_journal, &EntryJournal::discarded,
+            this, &BudgetTableModel::reload);
+    connect(m_journal, &EntryJournal::logged,
+            this, &BudgetTableModel::entriesLogged);
+}
+
+/**
+ * @brief BudgetTableModel::setFilter
+ *        Sets category and subcategory filters and reloads model.
+ * @param category category filter; empty for all transactions
+ * @param subcategory subcategory filter; ignored if category is empty
+ */
+void BudgetTableModel::setFilter(const QString &category, const QString &subcategory)
+{
+    m_category = category;
+    m_subcategory = category.isEmpty() ? QString() : subcategory;
+    reload();
+}
+
+/**
+ * @brief BudgetTableModel::setAccount
+ *        Shows one account, or all accounts consolidated.
+ *
+ *        Rebuilt from the loaded per-account streams, without a query;
+ *        rows still being loaded are appended as they arrive.
+ * @param accountID account to show; 0 for all accounts
+ */
+void BudgetTableModel::setAccount(qint64 accountID)
+{
+    if (accountID == m_accountID)
+        return;
+    m_accountID = accountID;
+    beginResetModel();
+    buildView();
+    endResetModel();
+}
+
+/**
+ * @brief BudgetTableModel::reload
+ *        Reloads rows matching current filter, starting with the first
+ *        page; the remaining rows follow from the event loop.
+ */
+void BudgetTableModel::reload()
+{
+    beginResetModel();
+    loadTimer->stop();
+    m_streams.clear();
+    m_entries.clear();
+    m_amounts.clear();
+    m_balances.clear();
+    m_loadedDate.clear();
+    m_loadedID = 0;
+    m_merged = m_schedule->occurrences(m_schedule->earliestStart(),
+                                       RecurringSchedule::projectionHorizon(),
+                                       m_category, m_subcategory);
+    for (const Transaction &entry : m_journal->pendingEntries()) {
+        if (matchesFilter(entry))
+            m_merged.append(entry);
+    }
+    std::sort(m_merged.begin(), m_merged.end(), entryLessThan);
+    m_mergedIndex = 0;
+
+    bool more = false;
+    appendRows(loadChunk(FirstPageRows, &more));
+    endResetModel();
+
+    if (more)
+        loadTimer->start();
+    else
+        emit loadingFinished();
+}
+
+/**
+ * @brief BudgetTableModel::finishLoading
+ *        Reads all remaining rows now, e.g. before the whole view is needed.
+ */
+void BudgetTableModel::finishLoading()
+{
+    while (loadTimer->isActive())
+        loadNextChunk();
+}
+
+/**
+ * @brief BudgetTableModel::isLoading
+ * @return true while rows of the current filter are still being read
+ */
+bool BudgetTableModel::isLoading() const
+{
+    return loadTimer->isActive();
+}
+
+/**
+ * @brief BudgetTableModel::loadNextChunk
+ *        Appends the next chunk of rows to the view.
+ *
+ *        Connected to loadTimer timeout signal.
+ */
+void BudgetTableModel::loadNextChunk()
+{
+    bool more = false;
+    QVector<Transaction> entries = loadChunk(ChunkRows, &more);
+    if (!entries.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_entries.size(), m_entries.size() + entries.size() - 1);
+        appendRows(entries);
+        endInsertRows();
+    }
+    if (!more) {
+        loadTimer->stop();
+        emit loadingFinished();
+    }
+}
+
+/**
+ * @brief BudgetTableModel::loadChunk
+ *        Reads the next stored rows after the last loaded one into their
+ *        account streams, merging in projected and pending entries ordered
+ *        before them.
+ *
+ *        Stored rows are paged by (date, transactionID), so each chunk is
+ *        an index range scan that starts where the previous one ended.
+ *        Rows replaced by pending edits and removes are skipped. Once the
+ *        last chunk is read, the remaining merged entries follow.
+ * @param rows maximum number of stored rows to read
+ * @param more set to true if stored rows may remain
+ * @return newly loaded entries that are shown, in view order
+ */
+QVector<Transaction> BudgetTableModel::loadChunk(int rows, bool *more)
+{
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    LedgerFilter filter;
+    filter.category = m_category;
+    filter.subcategory = m_subcategory;
+    int limitIndex = LedgerQuery::prepare<LedgerQuery::TableChunk>(query, filter);
+    query.bindValue(0, m_loadedDate);
+    query.bindValue(1, m_loadedDate);
+    query.bindValue(2, m_loadedID);
+    query.bindValue(limitIndex, rows);
+    // a failed chunk ends loading with the rows read so far
+    if (!query.exec())
+        qWarning() << "Table rows could not be loaded:" << query.lastError().text();
+
+    // rows arrive in view order, so both streams and view are appended to
+    QVector<Transaction> shown;
+    int count = 0;
+    while (query.next()) {
+        Transaction entry = LedgerQuery::readEntry(query);
+        while (m_mergedIndex < m_merged.size()
+               && entryLessThan(m_merged.at(m_mergedIndex), entry)) {
+            const Transaction &merged = m_merged.at(m_mergedIndex++);
+            m_streams[merged.accountID].append(merged);
+            if (isShown(merged))
+                shown.append(merged);
+        }
+        m_loadedDate = entry.date;
+        m_loadedID = entry.transactionID;
+        ++count;
+        if (m_journal->isReplaced(entry.transactionID))
+            continue;
+        m_streams[entry.accountID].append(entry);
+        if (isShown(entry))
+            shown.append(entry);
+    }
+
+    *more = count == rows;
+    if (!*more) {
+        while (m_mergedIndex < m_merged.size()) {
+            const Transaction &merged = m_merged.at(m_mergedIndex++);
+            m_streams[merged.accountID].append(merged);
+            if (isShown(merged))
+                shown.append(merged);
+        }
+        m_merged.clear();
+    }
+    return shown;
+}
+
+/**
+ * @brief BudgetTableModel::appendRows
+ *        Appends loaded entries to the view, converting them in one batch
+ *        and continuing the running balance.
+ * @param entries entries ordered after all shown rows
+ */
+void BudgetTableModel::appendRows(const QVector<Transaction> &entries)
+{
+    double balance = m_balances.isEmpty() ? 0 : m_balances.last();
+    m_entries.append(entries);
+    for (double amount : m_rates->convert(entries)) {
+        balance += amount;
+        m_amounts.append(amount);
+        m_balances.append(balance);
+    }
+}
+
+/**
+ * @brief BudgetTableModel::buildView
+ *        Fills shown rows from the per-account streams, then converts all
+ *        amounts in one batch and computes balances.
+ *
+ *        A single account is its stream as is. All accounts are combined by
+ *        a k-way merge over the stream heads, which is linear in the number
+ *        of rows (times log of the number of accounts).
+ */
+void BudgetTableModel::buildView()
+{
+    m_entries.clear();
+    m_amounts.clear();
+    m_balances.clear();
+
+    if (m_accountID != 0) {
+        m_entries = m_streams.value(m_accountID);
+    } else {
+        struct Head {
+            const QVector<Transaction> *stream;
+            int index;
+        };
+        auto later = [](const Head &a, const Head &b) {
+            return entryLessThan(b.stream->at(b.index), a.stream->at(a.index));
+        };
+        std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+        int size = 0;
+        for (const QVector<Transaction> &stream : m_streams) {
+            if (!stream.isEmpty())
+                heads.push(Head{&stream, 0});
+            size += stream.size();
+        }
+        m_entries.reserve(size);
+        while (!heads.empty()) {
+            Head head = heads.top();
+            heads.pop();
+            m_entries.append(head.stream->at(head.index));
+            if (++head.index < head.stream->size())
+                heads.push(head);
+        }
+    }
+
+    m_amounts = m_rates->convert(m_entries);
+    double balance = 0;
+    m_balances.reserve(m_entries.size());
+    for (double amount : m_amounts) {
+        balance += amount;
+        m_balances.append(balance);
+    }
+}
+
+/**
+ * @brief BudgetTableModel::updateConversion
+ *        Reconverts all shown amounts after rates or display currency
+ *        changed, without reloading rows.
+ */
+void BudgetTableModel::updateConversion()
+{
+    if (m_entries.isEmpty())
+        return;
+    m_amounts = m_rates->convert(m_entries);
+    emit headerDataChanged(Qt::Horizontal, BalanceColumn, BalanceColumn);
+    updateBalances(0);
+}
+
+/**
+ * @brief BudgetTableModel::entry
+ * @param row model row
+ * @return transaction shown in row
+ */
+Transaction BudgetTableModel::entry(int row) const
+{
+    return m_entries.at(row);
+}
+
+/**
+ * @brief BudgetTableModel::balance
+ * @param row model row
+ * @return running balance at row
+ */
+double BudgetTableModel::balance(int row) const
+{
+    return m_balances.at(row);
+}
+
+/**
+ * @brief BudgetTableModel::rowForEntry
+ *        Looks up row of entry by its date, ruleID and transactionID.
+ * @param entry entry to find
+ * @return row; -1 if entry is not shown
+ */
+int BudgetTableModel::rowForEntry(const Transaction &entry) const
+{
+    return findRow(entry);
+}
+
+/**
+ * @brief BudgetTableModel::rowsForDate
+ *        Binary searches rows dated on date.
+ * @param date date as "yyyy/MM/dd"
+ * @return [first, last) row range; empty if no row has that date
+ */
+std::pair<int, int> BudgetTableModel::rowsForDate(const QString &date) const
+{
+    auto first = std::lower_bound(m_entries.cbegin(), m_entries.cend(), date,
+                                  [](const Transaction &entry, const QString &value) {
+                                      return entry.date < value;
+                                  });
+    auto last = std::upper_bound(first, m_entries.cend(), date,
+                                 [](const QString &value, const Transaction &entry) {
+                                     return value < entry.date;
+                                 });
+    return {int(first - m_entries.cbegin()), int(last - m_entries.cbegin())};
+}
+
+int BudgetTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+int BudgetTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant BudgetTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const Transaction &entry = m_entries.at(index.row());
+    // projected entries are drawn in grey italics
+    if (entry.ruleID != 0 && role == Qt::ForegroundRole)
+        return QBrush(Qt::gray);
+    if (entry.ruleID != 0 && role == Qt::FontRole) {
+        QFont font;
+        font.setItalic(true);
+        return font;
+    }
+    // pending entries a crash could still lose are drawn in orange until logged
+    if (entry.ruleID == 0 && (role == Qt::ForegroundRole
+                              || (role == Qt::ToolTipRole && index.column() == TransactionIDColumn))
+        && m_journal->isUnlogged(entry.transactionID)) {
+        if (role == Qt::ForegroundRole)
+            return QBrush(QColor(200, 100, 0));
+        return QString("Not saved yet; may be lost if the program stops unexpectedly");
+    }
+    // unusual amounts are highlighted, with their category's typical amount on hover
+    if (index.column() == AmountColumn && entry.ruleID == 0
+        && (role == Qt::BackgroundRole || role == Qt::ToolTipRole)
+        && m_anomalies->isAnomaly(entry.category, entry.subcategory, m_amounts.at(index.row()))) {
+        if (role == Qt::BackgroundRole)
+            return QBrush(QColor(255, 215, 215));
+        return QString("Unusual amount: %1 %2, typically %3 %2")
+            .arg(m_amounts.at(index.row()))
+            .arg(m_rates->displayCurrency())
+            .arg(m_anomalies->typicalAmount(entry.category, entry.subcategory));
+    }
+    // amounts in other currencies show their converted value on hover
+    if (role == Qt::ToolTipRole && index.column() == AmountColumn
+        && entry.currency != m_rates->displayCurrency()) {
+        return QString("%1 %2").arg(m_amounts.at(index.row())).arg(m_rates->displayCurrency());
+    }
+    if (role != Qt::DisplayRole && role != Qt::EditRole)
+        return QVariant();
+
+    switch (index.column()) {
+    case TransactionIDColumn:
+        return entry.ruleID != 0 ? QVariant("recurring") : QVariant(entry.transactionID);
+    case DateColumn:
+        return entry.date;
+    case AccountColumn:
+        return m_accounts->name(entry.accountID);
+    case CategoryColumn:
+        return entry.category;
+    case SubcategoryColumn:
+        return entry.subcategory;
+    case AmountColumn:
+        return entry.amount;
+    case CurrencyColumn:
+        return entry.currency;
+    case BalanceColumn:
+        return m_balances.at(index.row());
+    default:
+        return QVariant();
+    }
+}
+
+QVariant BudgetTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (section) {
+    case TransactionIDColumn:
+        return "transactionID";
+    case DateColumn:
+        return "Date";
+    case AccountColumn:
+        return "Account";
+    case CategoryColumn:
+        return "Category";
+    case SubcategoryColumn:
+        return "Subcategory";
+    case AmountColumn:
+        return "Amount";
+    case CurrencyColumn:
+        return "Currency";
+    case BalanceColumn:
+        return QString("Balance (%1)").arg(m_rates->displayCurrency());
+    default:
+        return QVariant();
+    }
+}
+
+/**
+ * @brief BudgetTableModel::flags
+ *        Date, account, category, subcategory, amount and currency of stored entries are editable;
+ *        transactionID, balance and projected entries are read-only.
+ */
+Qt::ItemFlags BudgetTableModel::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags flags = QAbstractTableModel::flags(index);
+    if (index.isValid()
+        && m_entries.at(index.row()).ruleID == 0
+        && index.column() != TransactionIDColumn
+        && index.column() != BalanceColumn) {
+        flags |= Qt::ItemIsEditable;
+    }
+    return flags;
+}
+
+/**
+ * @brief BudgetTableModel::setData
+ *        Validates single-cell edit and passes it to the entry journal,
+ *        which stores it as a targeted UPDATE of this transactionID on submit.
+ *
+ *        The model itself is updated when the journal reports the change.
+ * @return true if edit was accepted
+ */
+bool BudgetTableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || role != Qt::EditRole)
+        return false;
+
+    const Transaction before = m_entries.at(index.row());
+    if (before.ruleID != 0)
+        return false;
+    Transaction after = before;
+    switch (index.column()) {
+    case DateColumn: {
+        QDate date = QDate::fromString(value.toString(), "yyyy/MM/dd");
+        if (!date.isValid())
+            return false;
+        after.date = date.toString("yyyy/MM/dd");
+        break;
+    }
+    case AccountColumn:
+        after.accountID = m_accounts->accountID(value.toString().trimmed());
+        if (after.accountID == 0)
+            return false;
+        break;
+    case CategoryColumn:
+        after.category = value.toString().trimmed();
+        if (after.category.isEmpty())
+            return false;
+        break;
+    case SubcategoryColumn:
+        after.subcategory = value.toString().trimmed();
+        if (after.subcategory.isEmpty())
+            return false;
+        break;
+    case AmountColumn: {
+        bool ok = false;
+        after.amount = value.toDouble(&ok);
+        if (!ok || after.amount == 0)
+            return false;
+        break;
+    }
+    case CurrencyColumn:
+        after.currency = value.toString().trimmed().toUpper();
+        if (after.currency.size() != 3)
+            return false;
+        break;
+    default:
+        return false;
+    }
+
+    if (after.date == before.date && after.category == before.category
+        && after.subcategory == before.subcategory && after.amount == before.amount
+        && after.currency == before.currency && after.accountID == before.accountID) {
+        return true;
+    }
+    return m_journal->editEntry(before, after);
+}
+
+/**
+ * @brief BudgetTableModel::insertEntry
+ *        Adds journaled entry to its account stream, and inserts it at its
+ *        ordered position if it is shown.
+ * @param entry added entry
+ */
+void BudgetTableModel::insertEntry(const Transaction &entry)
+{
+    addToStream(entry);
+    insertShownRow(entry);
+}
+
+/**
+ * @brief BudgetTableModel::removeEntry
+ *        Removes journaled entry from its account stream and from the
+ *        shown rows.
+ * @param entry removed entry
+ */
+void BudgetTableModel::removeEntry(const Transaction &entry)
+{
+    removeFromStream(entry);
+    removeShownRow(entry);
+}
+
+/**
+ * @brief BudgetTableModel::changeEntry
+ *        Applies journaled edit in place.
+ *
+ *        Edits that keep the row's position only touch that row and the
+ *        balances after it; date edits move the row; edits that move the
+ *        entry into or out of the shown rows insert or remove it.
+ * @param before entry before edit
+ * @param after entry after edit
+ */
+void BudgetTableModel::changeEntry(const Transaction &before, const Transaction &after)
+{
+    removeFromStream(before);
+    addToStream(after);
+
+    int oldRow = findRow(before);
+    if (oldRow < 0) {
+        insertShownRow(after);
+        return;
+    }
+    if (!isShown(after) || !isLoaded(after)) {
+        removeShownRow(before);
+        return;
+    }
+
+    int newRow = oldRow;
+    if (after.date != before.date) {
+        // destination as understood by beginMoveRows (row still in place)
+        int destination = lowerBound(after);
+        if (destination != oldRow && destination != oldRow + 1) {
+            beginMoveRows(QModelIndex(), oldRow, oldRow, QModelIndex(), destination);
+            m_entries.removeAt(oldRow);
+            m_amounts.removeAt(oldRow);
+            m_balances.removeAt(oldRow);
+            newRow = destination > oldRow ? destination - 1 : destination;
+            m_entries.insert(newRow, after);
+            m_amounts.insert(newRow, 0);
+            m_balances.insert(newRow, 0);
+            endMoveRows();
+        }
+    }
+    // date and currency edits change the conversion factor as well
+    double oldAmount = m_amounts.at(newRow);
+    m_entries[newRow] = after;
+    m_amounts[newRow] = m_rates->convert(after);
+    emit dataChanged(index(newRow, TransactionIDColumn), index(newRow, CurrencyColumn));
+
+    if (newRow != oldRow || m_amounts.at(newRow) != oldAmount)
+        updateBalances(std::min(oldRow, newRow));
+}
+
+/**
+ * @brief BudgetTableModel::entriesSubmitted
+ *        Drops pending entries not loaded yet from the merged entries, as
+ *        the remaining chunks now read them from the ledger, and redraws
+ *        the not-saved marks of the submitted ones.
+ *
+ *        Connected to EntryJournal submitted signal.
+ */
+void BudgetTableModel::entriesSubmitted()
+{
+    m_merged.erase(std::remove_if(m_merged.begin() + m_mergedIndex, m_merged.end(),
+                                  [](const Transaction &entry) { return entry.ruleID == 0; }),
+                   m_merged.end());
+    entriesLogged();
+}
+
+/**
+ * @brief BudgetTableModel::entriesLogged
+ *        Redraws rows once pending entries are durable, dropping their
+ *        not-saved marks.
+ *
+ *        Connected to EntryJournal logged signal.
+ */
+void BudgetTableModel::entriesLogged()
+{
+    if (m_entries.isEmpty())
+        return;
+    emit dataChanged(index(0, TransactionIDColumn), index(m_entries.size() - 1, BalanceColumn),
+                     {Qt::ForegroundRole, Qt::ToolTipRole});
+}
+
+/**
+ * @brief BudgetTableModel::matchesFilter
+ * @param entry entry to test
+ * @return true if entry belongs in the current category/subcategory filter
+ */
+bool BudgetTableModel::matchesFilter(const Transaction &entry) const
+{
+    if (m_category.isEmpty())
+        return true;
+    if (entry.category != m_category)
+        return false;
+    return m_subcategory.isEmpty() || entry.subcategory == m_subcategory;
+}
+
+/**
+ * @brief BudgetTableModel::isShown
+ * @param entry entry to test
+ * @return true if entry matches the filter and belongs to the shown account
+ */
+bool BudgetTableModel::isShown(const Transaction &entry) const
+{
+    return matchesFilter(entry) && (m_accountID == 0 || entry.accountID == m_accountID);
+}
+
+/**
+ * @brief BudgetTableModel::isLoaded
+ *        Tells whether entry falls within the rows loaded so far.
+ *
+ *        Stored entries after the last loaded row are read by the remaining
+ *        chunks, and pending ones are merged in with them.
+ * @param entry entry to test
+ * @return true if entry is ordered at or before the last loaded row
+ */
+bool BudgetTableModel::isLoaded(const Transaction &entry) const
+{
+    if (!loadTimer->isActive() || entry.ruleID != 0)
+        return true;
+    if (entry.date != m_loadedDate)
+        return entry.date < m_loadedDate;
+    return entry.transactionID <= m_loadedID;
+}
+
+/**
+ * @brief BudgetTableModel::addToStream
+ *        Inserts entry into its account stream by binary search, if it
+ *        matches the filter and falls within the loaded rows. Pending
+ *        entries past them are queued for merging instead.
+ * @param entry entry to add
+ */
+void BudgetTableModel::addToStream(const Transaction &entry)
+{
+    if (!matchesFilter(entry))
+        return;
+    if (!isLoaded(entry)) {
+        if (m_journal->isPending(entry.transactionID)) {
+            m_merged.insert(std::lower_bound(m_merged.begin() + m_mergedIndex, m_merged.end(),
+                                             entry, entryLessThan),
+                            entry);
+        }
+        return;
+    }
+    QVector<Transaction> &stream = m_streams[entry.accountID];
+    stream.insert(std::lower_bound(stream.begin(), stream.end(), entry, entryLessThan), entry);
+}
+
+/**
+ * @brief BudgetTableModel::removeFromStream
+ *        Removes entry from its account stream, or from the entries still
+ *        to be merged, if it is there.
+ * @param entry entry to remove
+ */
+void BudgetTableModel::removeFromStream(const Transaction &entry)
+{
+    if (!isLoaded(entry)) {
+        auto it = std::lower_bound(m_merged.begin() + m_mergedIndex, m_merged.end(),
+                                   entry, entryLessThan);
+        if (it != m_merged.end() && it->transactionID == entry.transactionID && it->ruleID == 0)
+            m_merged.erase(it);
+        return;
+    }
+    auto streamIt = m_streams.find(entry.accountID);
+    if (streamIt == m_streams.end())
+        return;
+    auto it = std::lower_bound(streamIt->begin(), streamIt->end(), entry, entryLessThan);
+    if (it != streamIt->end()
+        && it->ruleID == entry.ruleID
+        && it->transactionID == entry.transactionID) {
+        streamIt->erase(it);
+    }
+}
+
+/**
+ * @brief BudgetTableModel::insertShownRow
+ *        Inserts entry at its ordered position if it is shown and loaded.
+ * @param entry entry to insert
+ */
+void BudgetTableModel::insertShownRow(const Transaction &entry)
+{
+    if (!isShown(entry) || !isLoaded(entry))
+        return;
+
+    int row = lowerBound(entry);
+    beginInsertRows(QModelIndex(), row, row);
+    m_entries.insert(row, entry);
+    m_amounts.insert(row, m_rates->convert(entry));
+    m_balances.insert(row, 0);
+    endInsertRows();
+    updateBalances(row);
+}
+
+/**
+ * @brief BudgetTableModel::removeShownRow
+ *        Removes entry's row if it is shown.
+ * @param entry entry to remove
+ */
+void BudgetTableModel::removeShownRow(const Transaction &entry)
+{
+    int row = findRow(entry);
+    if (row < 0)
+        return;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_entries.removeAt(row);
+    m_amounts.removeAt(row);
+    m_balances.removeAt(row);
+    endRemoveRows();
+    updateBalances(row);
+}
+
+/**
+ * @brief BudgetTableModel::lowerBound
+ *        Binary searches first row not ordered before entry.
+ * @param entry entry to position
+ * @return insertion row
+ */
+int BudgetTableModel::lowerBound(const Transaction &entry) const
+{
+    return std::lower_bound(m_entries.cbegin(), m_entries.cend(), entry, entryLessThan)
+           - m_entries.cbegin();
+}
+
+/**
+ * @brief BudgetTableModel::findRow
+ *        Binary searches row of entry by date, ruleID and transactionID.
+ * @param entry entry to find
+ * @return row; -1 if entry is not shown
+ */
+int BudgetTableModel::findRow(const Transaction &entry) const
+{
+    int row = lowerBound(entry);
+    if (row < m_entries.size()
+        && m_entries.at(row).ruleID == entry.ruleID
+        && m_entries.at(row).transactionID == entry.transactionID) {
+        return row;
+    }
+    return -1;
+}
+
+/**
+ * @brief BudgetTableModel::updateBalances
+ *        Recomputes running balance from firstRow onwards and reports
+ *        only that balance range as changed.
+ * @param firstRow first row whose balance may have changed
+ */
+void BudgetTableModel::updateBalances(int firstRow)
+{
+    if (firstRow >= m_entries.size())
+        return;
+
+    double balance = firstRow > 0 ? m_balances.at(firstRow - 1) : 0;
+    for (int row = firstRow; row < m_entries.size(); ++row) {
+        balance += m_amounts.at(row);
+        m_balances[row] = balance;
+    }
+    emit dataChanged(index(firstRow, BalanceColumn),
+                     index(m_entries.size() - 1, BalanceColumn));
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "AccountList.h"
+#include "AnomalyDetector.h"
+#include "EntryJournal.h"
+#include "ExchangeRates.h"
+#include "RecurringSchedule.h"
+#include "Transaction.h"
+
+#include <QAbstractTableModel>
+#include <QMap>
+#include <QSqlDatabase>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @brief The BudgetTableModel class
+ *        Editable table model of budget transactions with running balance.
+ *
+ *        Rows for the current category/subcategory filter are loaded once,
+ *        ordered by date and transactionID. Afterwards the model follows the
+ *        entry journal: each added, removed or edited entry is spliced into
+ *        place with a binary search, and only the affected row and the balance
+ *        cells after it are reported as changed.
+ *
+ *        Projected entries of recurring rules are merged in up to the
+ *        projection horizon; they count towards the balance but are read-only.
+ *        Amounts are shown in their own currency, while balances are in the
+ *        display currency of the exchange rates. Amounts that are unusual
+ *        for their category are highlighted.
+ *
+ *        Rows are kept in one date-ordered stream per account. A single
+ *        account view shows its stream and running balance as is, while the
+ *        consolidated view k-way merges all streams, so switching between
+ *        them never re-queries or re-sorts.
+ *
+ *        Rows are loaded progressively: reload() reads only the first page
+ *        and returns, and the rest is read in date order in chunks from the
+ *        event loop, paged by (date, transactionID) so no statement stays
+ *        open between chunks. Each chunk is appended to the view, so rows
+ *        and their balances are final as soon as they are shown. Journal
+ *        changes past the last loaded row are left to the remaining chunks.
+ *
+ *        Pending entries are not in the ledger yet: they are merged in
+ *        while loading like projected entries, and the stored rows they
+ *        replace are skipped.
+ */
+class BudgetTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    static const int FirstPageRows = 256;   // rows read before reload() returns
+    static const int ChunkRows = 8192;      // rows read per event loop pass afterwards
+
+    enum Column {
+        TransactionIDColumn,
+        DateColumn,
+        AccountColumn,
+        CategoryColumn,
+        SubcategoryColumn,
+        AmountColumn,
+        CurrencyColumn,
+        BalanceColumn,
+        ColumnCount
+    };
+
+    // constructor
+    BudgetTableModel(const QSqlDatabase &database, EntryJournal *journal,
+                     const RecurringSchedule *schedule, const ExchangeRates *rates,
+                     const AccountList *accounts, const AnomalyDetector *anomalies,
+                     QObject *parent = nullptr);
+
+    // filtering
+    void setFilter(const QString &category, const QString &subcategory);
+    void setAccount(qint64 accountID);
+    void reload();
+    void finishLoading();
+    bool isLoading() const;
+    void updateConversion();
+
+    // getters
+    Transaction entry(int row) const;
+    double balance(int row) const;
+    int rowForEntry(const Transaction &entry) const;
+    std::pair<int, int> rowsForDate(const QString &date) const;
+
+    // QAbstractTableModel interface
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool setData(const QModelIndex &index, const QVariant &value,
+                 int role = Qt::EditRole) override;
+
+signals:
+    void loadingFinished();
+
+private slots:
+    void loadNextChunk();
+    void insertEntry(const Transaction &entry);
+    void removeEntry(const Transaction &entry);
+    void changeEntry(const Transaction &before, const Transaction &after);
+    void entriesSubmitted();
+    void entriesLogged();
+
+private:
+    QSqlDatabase m_database;
+    EntryJournal *m_journal;
+    const RecurringSchedule *m_schedule;
+    const ExchangeRates *m_rates;
+    const AccountList *m_accounts;
+    const AnomalyDetector *m_anomalies;
+    qint64 m_accountID = 0;             // shown account; 0 for all accounts
+    QString m_category;                 // current category filter; empty for all
+    QString m_subcategory;              // current subcategory filter; empty for all
+    QMap<qint64, QVector<Transaction>> m_streams;   // filtered entries per account, each ordered like m_entries
+    QVector<Transaction> m_entries;     // shown entries, ordered by date, ruleID and transactionID
+    QVector<double> m_amounts;          // amount per row in display currency
+    QVector<double> m_balances;         // running balance per row
+    QTimer *loadTimer;                  // reads the next chunk while rows remain
+    QVector<Transaction> m_merged;      // projected and pending entries, ordered; merged in while loading
+    int m_mergedIndex = 0;              // first entry of m_merged not yet merged in
+    QString m_loadedDate;               // date of the last loaded stored entry
+    qint64 m_loadedID = 0;              // transactionID of the last loaded stored entry
+
+    bool matchesFilter(const Transaction &entry) const;
+    bool isShown(const Transaction &entry) const;
+    bool isLoaded(const Transaction &entry) const;
+    QVector<Transaction> loadChunk(int rows, bool *more);
+    void appendRows(const QVector<Transaction> &entries);
+    void buildView();
+    void addToStream(const Transaction &entry);
+    void removeFromStream(const Transaction &entry);
+    void insertShownRow(const Transaction &entry);
+    void removeShownRow(const Transaction &entry);
+    int lowerBound(const Transaction &entry) const;
+    int findRow(const Transaction &entry) const;
+    void updateBalances(int firstRow);
+};
@@ -0,0 +1,167 @@
+#include "BudgetTargets.h"
+
+#include <QSqlQuery>
+
+/**
+ * @brief BudgetTargets::BudgetTargets
+ *        Default constructor. No targets are known until load() is called.
+ */
+BudgetTargets::BudgetTargets() {}
+
+/**
+ * @brief BudgetTargets::load
+ *        Loads targets and accumulates net spending per month and category.
+ *
+ *        Spending is summed by the query per day, category and currency, so
+ *        each sum is converted with the same daily rate addEntry() uses.
+ *        Reload after rates or display currency changed.
+ * @param database open user database
+ * @param rates exchange rates spending is converted with
+ */
+void BudgetTargets::load(const QSqlDatabase &database, const ExchangeRates *rates)
+{
+    m_database = database;
+    m_rates = rates;
+    m_targets.clear();
+    m_spending.clear();
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.exec("SELECT category, amount, currency "
+               "FROM target");
+    while (query.next()) {
+        Target target;
+        target.amount = query.value(1).toDouble();
+        target.currency = query.value(2).toString();
+        m_targets.insert(query.value(0).toString(), target);
+    }
+
+    query.exec("SELECT date, category, currency, SUM(amount) "
+               "FROM budget "
+               "GROUP BY date, category, currency");
+    while (query.next()) {
+        Transaction sum;
+        sum.date = query.value(0).toString();
+        sum.category = query.value(1).toString();
+        sum.currency = query.value(2).toString();
+        sum.amount = query.value(3).toDouble();
+        addEntry(sum);
+    }
+}
+
+/**
+ * @brief BudgetTargets::setTarget
+ *        Stores monthly target for category, replacing any previous one.
+ * @param category category to limit
+ * @param amount monthly limit on net spending
+ * @param currency ISO 4217 code of amount
+ * @return true if target was stored
+ */
+bool BudgetTargets::setTarget(const QString &category, double amount, const QString &currency)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT OR REPLACE INTO target "
+                  "(category, amount, currency) "
+                  "VALUES (?, ?, ?)");
+    query.bindValue(0, category);
+    query.bindValue(1, amount);
+    query.bindValue(2, currency);
+    if (!query.exec())
+        return false;
+
+    m_targets.insert(category, Target{amount, currency});
+    return true;
+}
+
+/**
+ * @brief BudgetTargets::removeTarget
+ *        Deletes target of category.
+ * @param category category whose target to delete
+ * @return true if target was deleted
+ */
+bool BudgetTargets::removeTarget(const QString &category)
+{
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM target "
+                  "WHERE category = ?");
+    query.bindValue(0, category);
+    if (!query.exec())
+        return false;
+
+    m_targets.remove(category);
+    return true;
+}
+
+/**
+ * @brief BudgetTargets::addEntry
+ *        Counts entry towards its month's spending in its category.
+ *
+ *        Negative amounts are spending, positive amounts (refunds) reduce it.
+ *        Projected entries are not counted until they are actually entered.
+ * @param entry added entry
+ */
+void BudgetTargets::addEntry(const Transaction &entry)
+{
+    if (entry.ruleID != 0)
+        return;
+    m_spending[monthIndex(entry.date)][entry.category] -= m_rates->convert(entry);
+}
+
+/**
+ * @brief BudgetTargets::removeEntry
+ *        Uncounts entry from its month's spending in its category.
+ * @param entry removed entry
+ */
+void BudgetTargets::removeEntry(const Transaction &entry)
+{
+    if (entry.ruleID != 0)
+        return;
+    m_spending[monthIndex(entry.date)][entry.category] += m_rates->convert(entry);
+}
+
+/**
+ * @brief BudgetTargets::status
+ * @param category category to evaluate
+ * @return spending against target of category in the current month
+ */
+BudgetStatus BudgetTargets::status(const QString &category) const
+{
+    BudgetStatus status;
+    status.category = category;
+    status.spent = m_spending.value(monthIndex(QDate::currentDate().toString("yyyy/MM/dd")))
+                       .value(category);
+
+    auto it = m_targets.constFind(category);
+    if (it == m_targets.constEnd())
+        return status;
+    status.target = it->amount * m_rates->factor(it->currency, QDate::currentDate());
+    if (status.spent > status.target)
+        status.state = BudgetStatus::Over;
+    else if (status.spent >= NearFraction * status.target)
+        status.state = BudgetStatus::Near;
+    return status;
+}
+
+/**
+ * @brief BudgetTargets::summary
+ * @return status of every category with a target in the current month,
+ *         ordered by category
+ */
+QVector<BudgetStatus> BudgetTargets::summary() const
+{
+    QVector<BudgetStatus> statuses;
+    statuses.reserve(m_targets.size());
+    for (auto it = m_targets.constBegin(); it != m_targets.constEnd(); ++it)
+        statuses.append(status(it.key()));
+    return statuses;
+}
+
+/**
+ * @brief BudgetTargets::monthIndex
+ * @param date date as "yyyy/MM/dd"
+ * @return months since year 0, used as m_spending key
+ */
+int BudgetTargets::monthIndex(const QString &date)
+{
+    return date.left(4).toInt() * 12 + date.mid(5, 2).toInt() - 1;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ExchangeRates.h"
+#include "Transaction.h"
+
+#include <QHash>
+#include <QMap>
+#include <QSqlDatabase>
+#include <QVector>
+
+/**
+ * @brief The BudgetStatus struct
+ *        Spending against the monthly target of one category.
+ */
+struct BudgetStatus {
+    enum State { Under, Near, Over };
+
+    QString category;
+    double target = 0;      // monthly target in display currency; 0 if none
+    double spent = 0;       // net spending this month in display currency
+    State state = Under;
+};
+
+/**
+ * @brief The BudgetTargets class
+ *        Monthly spending targets per category, with spending tracked
+ *        incrementally.
+ *
+ *        Net spending is accumulated per month and category once on load;
+ *        afterwards each journaled entry adjusts its single accumulator, so
+ *        evaluating a category never re-sums its history and the summary
+ *        only depends on the number of targets.
+ */
+class BudgetTargets
+{
+public:
+    // constructor
+    BudgetTargets();
+
+    // loading and target management
+    void load(const QSqlDatabase &database, const ExchangeRates *rates);
+    bool setTarget(const QString &category, double amount, const QString &currency);
+    bool removeTarget(const QString &category);
+
+    // incremental updates
+    void addEntry(const Transaction &entry);
+    void removeEntry(const Transaction &entry);
+
+    // current month lookups
+    BudgetStatus status(const QString &category) const;
+    QVector<BudgetStatus> summary() const;
+
+    static constexpr double NearFraction = 0.8;   // share of target at which a category is near it
+
+private:
+    /**
+     * @brief The Target struct
+     *        Stored target amount in the currency it was set in.
+     */
+    struct Target {
+        double amount = 0;
+        QString currency;
+    };
+
+    QSqlDatabase m_database;
+    const ExchangeRates *m_rates = nullptr;
+    QMap<QString, Target> m_targets;                    // target per category
+    QHash<int, QHash<QString, double>> m_spending;      // net spending by month index and category
+
+    static int monthIndex(const QString &date);
+};
@@ -1,49 +1,172 @@
 #include "BudgetTracker.h"
 #include "ui_BudgetTracker.h"
 
+#include "LedgerQuery.h"
+#include "RecurringDialog.h"
+#include "StartupProfile.h"
+
+#include <QCloseEvent>
 #include <QDebug>
-#include <QDir>
+#include <QFileDialog>
+#include <QHash>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QPrintDialog>
+#include <QSet>
 #include <QSqlDatabase>
+#include <QSqlError>
 #include <QSqlQuery>
-#include <QStandardPaths>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double PlotBarWidth = 0.8 * 24 * 60 * 60;    // daily bar width in plot (seconds) coordinates
+const int HoverIntervalMs = 16;                     // minimum time between hover repaints
+const double HoverDistancePx = 30;                  // max cursor distance from hovered day
+}
 
 /**
  * @brief BudgetTracker::BudgetTracker
  *        Sets up UI and connects signals and slots.
  *
- *        Sets up database and initializes transaction table and plot.
- * @param user logged in user
+ *        Initializes transaction table and plot from the session's shared
+ *        ledger; table and plot filters are per window.
+ *
+ *        Only the first page of table rows is read before the window shows.
+ *        The plot is drawn right after the first paint, and the remaining
+ *        table rows stream in from the event loop.
+ * @param session logged in user's ledger session
  * @param parent pointer to QWiget parent object
  */
-BudgetTracker::BudgetTracker(std::shared_ptr<User> user, QWidget *parent)
+BudgetTracker::BudgetTracker(LedgerSession *session, QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::BudgetTracker)
-    , transactionModel(new QSqlQueryModel(this))
-    , m_user(user)
+    , session(session)
+    , transactionModel(nullptr)
+    , columnSizer(nullptr)
+    , ledgerExporter(nullptr)
+    , exportProgress(nullptr)
+    , reportGenerator(new ReportGenerator(this))
+    , reportProgress(nullptr)
+    , entryJournal(session->journal())
+    , transactionBars(nullptr)
+    , projectedBars(nullptr)
+    , balanceGraph(nullptr)
+    , forecastGraph(nullptr)
+    , anomalyGraph(nullptr)
+    , balanceForecaster(session->forecaster())
+    , hoverTracer(nullptr)
+    , hoverLabel(nullptr)
+    , hoverTimer(new QTimer(this))
+    , categoryCompleter(new QCompleter(this))
+    , subcategoryCompleter(new QCompleter(this))
+    , categoryListModel(new QStringListModel(this))
+    , subcategoryListModel(new QStringListModel(this))
 {
     ui->setupUi(this);
+    session->attachWindow();
 
     // manual ui setup
+    std::shared_ptr<User> user = session->user();
     ui->entryDateDateEdit->setDate(QDate::currentDate());
+    ui->entryCurrencyLineEdit->setText(ExchangeRates::homeCurrency());
     this->setWindowTitle(QString("BudgetTracker | Username: %1 | userID: %2")
                              .arg(user->getUsername(), QString::number(user->getUserID())));
 
-    // database, table, plot initialization
-    setupDatabase(user);
+    // table, plot initialization
+    connect(balanceForecaster, &BalanceForecaster::forecastReady,
+            this, &BudgetTracker::drawForecast);
+    ledgerExporter = new LedgerExporter(session->database().connectionName(),
+                                        session->ledgerKey(), this);
+    connect(ledgerExporter, &LedgerExporter::progress,
+            this, &BudgetTracker::showExportProgress);
+    connect(ledgerExporter, &LedgerExporter::finished,
+            this, &BudgetTracker::finishExport);
+    connect(reportGenerator, &ReportGenerator::progress,
+            this, &BudgetTracker::showReportProgress);
+    connect(reportGenerator, &ReportGenerator::finished,
+            this, &BudgetTracker::finishReport);
+    transactionModel = new BudgetTableModel(session->database(), entryJournal, session->schedule(),
+                                            session->rates(), session->accounts(),
+                                            session->anomalies(), this);
+    initializeCompleters();
+    initializeCurrencies();
+    initializeAccounts();
     initializeTable();
+    StartupProfile::mark("first table page loaded");
     initializePlot();
+    drawBudget();
 
     // entry connections
     connect(ui->entryCategoryLineEdit, &QLineEdit::textChanged,
             this, &BudgetTracker::verifyEntry);
+    connect(ui->entryCategoryLineEdit, &QLineEdit::textChanged,
+            this, &BudgetTracker::updateSubcategoryCompleter);
     connect(ui->entrySubcategoryLineEdit, &QLineEdit::textChanged,
             this, &BudgetTracker::verifyEntry);
     connect(ui->entryAmountLineEdit, &QLineEdit::textChanged,
             this, &BudgetTracker::verifyEntry);
+    connect(ui->entryCurrencyLineEdit, &QLineEdit::textChanged,
+            this, &BudgetTracker::verifyEntry);
     connect(ui->entryAddButton, &QPushButton::clicked,
             this, &BudgetTracker::addEntry);
     connect(ui->entryRemoveButton, &QPushButton::clicked,
             this, &BudgetTracker::removeEntry);
+    connect(ui->entryRecurringButton, &QPushButton::clicked,
+            this, &BudgetTracker::editRecurring);
+    connect(ui->entryAccountAddButton, &QPushButton::clicked,
+            this, &BudgetTracker::addAccount);
+    connect(ui->displayCurrencyComboBox, &QComboBox::currentTextChanged,
+            this, &BudgetTracker::changeDisplayCurrency);
+    connect(ui->ratesImportButton, &QPushButton::clicked,
+            this, &BudgetTracker::importRates);
+    connect(ui->budgetSetButton, &QPushButton::clicked,
+            this, &BudgetTracker::setBudgetTarget);
+    connect(ui->budgetRemoveButton, &QPushButton::clicked,
+            this, &BudgetTracker::removeBudgetTarget);
+    connect(ui->budgetListWidget, &QListWidget::itemSelectionChanged,
+            this, &BudgetTracker::verifyBudgetRemove);
+    connect(ui->transactionTableView->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &BudgetTracker::verifyRemove);
+    connect(ui->transactionTableView->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &BudgetTracker::selectPlotFromTable);
+
+    // journal connections
+    ui->entryUndoButton->setShortcut(QKeySequence::Undo);
+    ui->entryRedoButton->setShortcut(QKeySequence::Redo);
+    connect(ui->entryUndoButton, &QPushButton::clicked,
+            this, &BudgetTracker::undoEntry);
+    connect(ui->entryRedoButton, &QPushButton::clicked,
+            this, &BudgetTracker::redoEntry);
+    connect(ui->entrySubmitButton, &QPushButton::clicked,
+            this, &BudgetTracker::submitEntries);
+    connect(entryJournal, &EntryJournal::pendingCountChanged,
+            this, &BudgetTracker::updateJournalButtons);
+    connect(entryJournal, &EntryJournal::submitted,
+            this, &BudgetTracker::drawPlot);
+    connect(session, &LedgerSession::logFailed,
+            this, &BudgetTracker::reportLogFailure);
+    updateJournalButtons();
+
+    // session connections
+    connect(session, &LedgerSession::categoriesChanged,
+            this, &BudgetTracker::updateCategoryCompleter);
+    connect(session, &LedgerSession::budgetChanged,
+            this, &BudgetTracker::updateBudget);
+    connect(session, &LedgerSession::ratesChanged,
+            this, &BudgetTracker::applyRates);
+    connect(session, &LedgerSession::entriesImported,
+            this, &BudgetTracker::applyImport);
+    connect(session, &LedgerSession::accountsChanged,
+            this, &BudgetTracker::initializeAccounts);
+    connect(session, &LedgerSession::scheduleChanged,
+            this, &BudgetTracker::redraw);
+    connect(ui->sessionNewWindowButton, &QPushButton::clicked,
+            this, &BudgetTracker::requestNewWindow);
+    connect(ui->sessionSwitchUserButton, &QPushButton::clicked,
+            this, &BudgetTracker::requestSwitchUser);
 
     // plot connections
     connect(ui->plotFilterCategoryLineEdit, &QLineEdit::textChanged,
@@ -52,8 +175,24 @@ BudgetTracker::BudgetTracker(std::shared_ptr<User> user, QWidget *parent)
             this, &BudgetTracker::filterPlot);
     connect(ui->plotFilterClearButton, &QPushButton::clicked,
             this, &BudgetTracker::clearPlotFilter);
+    connect(ui->plotFilterCompareLineEdit, &QLineEdit::textChanged,
+            this, &BudgetTracker::verifyPlotFilter);
+    connect(ui->plotFilterCompareButton, &QPushButton::clicked,
+            this, &BudgetTracker::comparePlot);
     connect(ui->transactionPlot, &QCustomPlot::mouseDoubleClick,
             this, &BudgetTracker::drawPlot);
+    connect(ui->transactionPlot->xAxis, QOverload<const QCPRange &>::of(&QCPAxis::rangeChanged),
+            this, &BudgetTracker::extendProjection);
+    connect(ui->transactionPlot, &QCustomPlot::mouseMove,
+            this, &BudgetTracker::trackHover);
+    connect(ui->transactionPlot, &QCustomPlot::mousePress,
+            this, &BudgetTracker::setPlotSelectionMode);
+    connect(transactionBars, QOverload<const QCPDataSelection &>::of(&QCPAbstractPlottable::selectionChanged),
+            this, &BudgetTracker::selectTableFromPlot);
+    connect(projectedBars, QOverload<const QCPDataSelection &>::of(&QCPAbstractPlottable::selectionChanged),
+            this, &BudgetTracker::selectTableFromPlot);
+    connect(hoverTimer, &QTimer::timeout,
+            this, &BudgetTracker::showHover);
 
     // table connections
     connect(ui->tableFilterCategoryLineEdit, &QLineEdit::textChanged,
@@ -62,109 +201,321 @@ BudgetTracker::BudgetTracker(std::shared_ptr<User> user, QWidget *parent)
             this, &BudgetTracker::filterTable);
     connect(ui->tableFilterClearButton, &QPushButton::clicked,
             this, &BudgetTracker::clearTableFilter);
+    connect(ui->tableFilterAccountComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &BudgetTracker::changeTableAccount);
+    connect(ui->tableImportButton, &QPushButton::clicked,
+            this, &BudgetTracker::importTable);
+    connect(ui->tableExportButton, &QPushButton::clicked,
+            this, &BudgetTracker::exportTable);
+    connect(ui->tableReportButton, &QPushButton::clicked,
+            this, &BudgetTracker::generateReport);
+    connect(transactionModel, &BudgetTableModel::loadingFinished,
+            this, &BudgetTracker::finishTableLoading);
 
+    // the first window reports what happened while opening the ledger
+    if (session->windowCount() == 1)
+        reportRecovery();
+    StartupProfile::mark("window constructed");
 }
 
 /**
  * @brief BudgetTracker::~BudgetTracker
- *        Deallocates UI memory.
+ *        Deallocates UI memory and detaches from session.
  */
 BudgetTracker::~BudgetTracker()
 {
     delete ui;
+    session->detachWindow();
+}
+
+/**
+ * @brief BudgetTracker::closeEvent
+ *        Asks whether pending entries should be submitted before closing
+ *        the session's last window.
+ * @param event close event
+ */
+void BudgetTracker::closeEvent(QCloseEvent *event)
+{
+    // pending entries stay with the session while other windows show them
+    if (entryJournal->pendingCount() == 0 || session->windowCount() > 1) {
+        event->accept();
+        return;
+    }
+
+    QMessageBox::StandardButton button =
+        QMessageBox::question(this, "Pending Entries",
+                              QString("Submit %1 pending change(s) before closing?")
+                                  .arg(entryJournal->pendingCount()),
+                              QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel);
+    if (button == QMessageBox::Save && !entryJournal->submit()) {
+        QMessageBox::warning(this, "Submit Failed", entryJournal->lastError());
+        event->ignore();
+    } else if (button == QMessageBox::Cancel) {
+        event->ignore();
+    } else {
+        if (button == QMessageBox::Discard)
+            entryJournal->discard();
+        event->accept();
+    }
+}
+
+/**
+ * @brief BudgetTracker::paintEvent
+ *        Schedules the deferred part of startup after the first paint.
+ * @param event paint event
+ */
+void BudgetTracker::paintEvent(QPaintEvent *event)
+{
+    QWidget::paintEvent(event);
+    if (m_painted)
+        return;
+    m_painted = true;
+    StartupProfile::markFirstPaint();
+    QTimer::singleShot(0, this, &BudgetTracker::finishStartup);
+}
+
+/**
+ * @brief BudgetTracker::finishStartup
+ *        Draws the plot once the window is on screen.
+ *
+ *        Ends the startup profile here, unless table rows are still
+ *        loading; then finishTableLoading() ends it.
+ */
+void BudgetTracker::finishStartup()
+{
+    drawPlot();
+    StartupProfile::mark("plot drawn");
+    if (!transactionModel->isLoading())
+        StartupProfile::finish("startup complete");
 }
 
 /**
- * @brief BudgetTracker::setupDatabase
- *        Sets up connection to SQLite user database,
- *        creates table for current user.
- * @param user current user whose database should be opened
+ * @brief BudgetTracker::initializeCurrencies
+ *        Fills display currency box with currencies that have rates.
  */
-void BudgetTracker::setupDatabase(const std::shared_ptr<const User> user)
+void BudgetTracker::initializeCurrencies()
 {
-    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
-    QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    db.setDatabaseName(path + QDir::separator() + QString("%1.sqlite")
-                                                      .arg(user->getUsername()));
-    db.open();
+    QSignalBlocker blocker(ui->displayCurrencyComboBox);
+    ui->displayCurrencyComboBox->clear();
+    ui->displayCurrencyComboBox->addItems(session->rates()->currencies());
+    ui->displayCurrencyComboBox->setCurrentText(session->rates()->displayCurrency());
+}
 
-    QSqlQuery query;
-    query.exec("CREATE TABLE IF NOT EXISTS budget ("
-               "transactionID INTEGER PRIMARY KEY, "
-               "date VARCHAR(20), "
-               "category VARCHAR(20), "
-               "subcategory VARCHAR(20),"
-               "amount DOUBLE)");
+/**
+ * @brief BudgetTracker::initializeAccounts
+ *        Fills entry and table account boxes, keeping their selections.
+ */
+void BudgetTracker::initializeAccounts()
+{
+    qint64 entryAccountID = ui->entryAccountComboBox->currentData().toLongLong();
+    QSignalBlocker entryBlocker(ui->entryAccountComboBox);
+    QSignalBlocker tableBlocker(ui->tableFilterAccountComboBox);
+    ui->entryAccountComboBox->clear();
+    ui->tableFilterAccountComboBox->clear();
+    ui->tableFilterAccountComboBox->addItem("All Accounts", qint64(0));
+    for (const Account &account : session->accounts()->accounts()) {
+        ui->entryAccountComboBox->addItem(account.name, account.accountID);
+        ui->tableFilterAccountComboBox->addItem(account.name, account.accountID);
+    }
+    int entryIndex = ui->entryAccountComboBox->findData(entryAccountID);
+    ui->entryAccountComboBox->setCurrentIndex(std::max(0, entryIndex));
+    ui->tableFilterAccountComboBox->setCurrentIndex(
+        std::max(0, ui->tableFilterAccountComboBox->findData(m_currentTableAccountID)));
+}
+
+/**
+ * @brief BudgetTracker::applyRates
+ *        Reconverts table balances, budget and plot after rates or
+ *        display currency changed.
+ *
+ *        Connected to LedgerSession ratesChanged signal.
+ */
+void BudgetTracker::applyRates()
+{
+    initializeCurrencies();
+    transactionModel->updateConversion();
+    drawBudget();
+    drawPlot();
+}
+
+/**
+ * @brief BudgetTracker::applyImport
+ *        Reloads table, budget and plot after entries were imported.
+ *
+ *        Connected to LedgerSession entriesImported signal.
+ */
+void BudgetTracker::applyImport()
+{
+    drawBudget();
+    redraw();
+}
+
+/**
+ * @brief BudgetTracker::drawBudget
+ *        Lists this month's spending against target of each budgeted category.
+ *
+ *        Spending is kept up to date by m_budgetTargets, so this only walks
+ *        the targets and does not depend on the size of the ledger.
+ */
+void BudgetTracker::drawBudget()
+{
+    QString selected;
+    if (ui->budgetListWidget->currentItem())
+        selected = ui->budgetListWidget->currentItem()->data(Qt::UserRole).toString();
+
+    ui->budgetListWidget->clear();
+    for (const BudgetStatus &status : session->budgetTargets()->summary()) {
+        QListWidgetItem *item = new QListWidgetItem(
+            QString("%1: %2 / %3 %4")
+                .arg(status.category)
+                .arg(status.spent, 0, 'f', 2)
+                .arg(status.target, 0, 'f', 2)
+                .arg(session->rates()->displayCurrency()),
+            ui->budgetListWidget);
+        item->setData(Qt::UserRole, status.category);
+        if (status.state == BudgetStatus::Over)
+            item->setForeground(Qt::red);
+        else if (status.state == BudgetStatus::Near)
+            item->setForeground(QColor(255, 140, 0));
+        if (status.category == selected)
+            ui->budgetListWidget->setCurrentItem(item);
+    }
+    verifyBudgetRemove();
+}
+
+/**
+ * @brief BudgetTracker::alertBudget
+ *        Shows an alert if category got closer to or over its target.
+ * @param category category an entry was counted in
+ * @param previous state of category before the entry
+ */
+void BudgetTracker::alertBudget(const QString &category, BudgetStatus::State previous)
+{
+    BudgetStatus status = session->budgetTargets()->status(category);
+    if (status.state <= previous)
+        return;
+
+    if (status.state == BudgetStatus::Over) {
+        ui->budgetAlertLabel->setStyleSheet("color: red");
+        ui->budgetAlertLabel->setText(QString("%1 is over budget by %2 %3 this month.")
+                                          .arg(category)
+                                          .arg(status.spent - status.target, 0, 'f', 2)
+                                          .arg(session->rates()->displayCurrency()));
+    } else {
+        ui->budgetAlertLabel->setStyleSheet("color: rgb(255, 140, 0)");
+        ui->budgetAlertLabel->setText(QString("%1 has used %2% of its budget this month.")
+                                          .arg(category)
+                                          .arg(qRound(100 * status.spent / status.target)));
+    }
+}
+
+/**
+ * @brief BudgetTracker::initializeCompleters
+ *        Attaches completers fed by the session's category index to entry fields.
+ *
+ *        Completers are ordered by entry frequency rather than alphabetically,
+ *        so the most used spelling of a category is suggested first.
+ */
+void BudgetTracker::initializeCompleters()
+{
+    categoryListModel->setStringList(session->categoryIndex()->categories());
+    categoryCompleter->setModel(categoryListModel);
+    categoryCompleter->setCaseSensitivity(Qt::CaseInsensitive);
+    categoryCompleter->setModelSorting(QCompleter::UnsortedModel);
+    ui->entryCategoryLineEdit->setCompleter(categoryCompleter);
+
+    subcategoryCompleter->setModel(subcategoryListModel);
+    subcategoryCompleter->setCaseSensitivity(Qt::CaseInsensitive);
+    subcategoryCompleter->setModelSorting(QCompleter::UnsortedModel);
+    ui->entrySubcategoryLineEdit->setCompleter(subcategoryCompleter);
+}
+
+/**
+ * @brief BudgetTracker::updateSubcategoryCompleter
+ *        Repopulates subcategory completer for the current entry category.
+ *
+ *        Connected to entryCategoryLineEdit textChanged signal.
+ */
+void BudgetTracker::updateSubcategoryCompleter()
+{
+    subcategoryListModel->setStringList(
+        session->categoryIndex()->subcategories(ui->entryCategoryLineEdit->text()));
 }
 
 /**
  * @brief BudgetTracker::initializeTable
- *        Initializes table view. Calls drawTable
+ *        Initializes table view and its column sizing. Calls drawTable
  *        with no filter.
  */
 void BudgetTracker::initializeTable()
 {
     ui->transactionTableView->setModel(transactionModel);
-    drawTable();
     ui->transactionTableView->horizontalHeader()->setStretchLastSection(true);
+    columnSizer = new ColumnSizer(ui->transactionTableView, this);
+    // dates and currency codes have a fixed format, so need no measuring
+    columnSizer->setFormat(BudgetTableModel::DateColumn, "0000/00/00");
+    columnSizer->setFormat(BudgetTableModel::CurrencyColumn, "WWW");
+    drawTable();
 }
 
 /**
  * @brief BudgetTracker::drawTable
  *        Draws table based on current table category and subcategory criteria.
+ *
+ *        Reloads the model; entry changes afterwards are applied
+ *        to the model in place and do not go through here.
  */
 void BudgetTracker::drawTable()
 {
-    QSqlQuery query;
-    // if currentTableCategory is empty, show all transactions
+    transactionModel->setFilter(m_currentTableCategory, m_currentTableSubcategory);
+
+    // filtered columns are constant, so hide them
+    ui->transactionTableView->setColumnHidden(BudgetTableModel::CategoryColumn,
+                                              m_currentTableCategory != "");
+    ui->transactionTableView->setColumnHidden(BudgetTableModel::SubcategoryColumn,
+                                              m_currentTableSubcategory != "");
+    updateTableTitle();
+    fitTableColumns();
+}
+
+/**
+ * @brief BudgetTracker::fitTableColumns
+ *        Sizes table columns for the current filter and account.
+ *
+ *        Widths are cached per filter and account, since those decide
+ *        both the visible columns and the values shown in them.
+ */
+void BudgetTracker::fitTableColumns()
+{
+    columnSizer->fit(QStringList{m_currentTableCategory, m_currentTableSubcategory,
+                                 QString::number(m_currentTableAccountID)}.join('\n'));
+}
+
+/**
+ * @brief BudgetTracker::updateTableTitle
+ *        Sets table group box title from current table filters
+ *        and number of pending entries.
+ */
+void BudgetTracker::updateTableTitle()
+{
+    QString title;
+    // if currentTableCategory is empty, all transactions are shown
     if (m_currentTableCategory == "") {
-        transactionModel->setQuery("SELECT transactionID, date, category, subcategory, amount, SUM(amount) "
-                                   "OVER (ORDER BY date, transactionID ROWS UNBOUNDED PRECEDING) "
-                                   "AS balance FROM budget ORDER BY date, transactionID");
-        transactionModel->setHeaderData(0, Qt::Horizontal, "transactionID");
-        transactionModel->setHeaderData(1, Qt::Horizontal, "Date");
-        transactionModel->setHeaderData(2, Qt::Horizontal, "Category");
-        transactionModel->setHeaderData(3, Qt::Horizontal, "Subcategory");
-        transactionModel->setHeaderData(4, Qt::Horizontal, "Amount");
-        transactionModel->setHeaderData(5, Qt::Horizontal, "Balance");
-        ui->transactionGroupBox->setTitle(QString("Table: All Transactions"));
-    // else if currentTableSubcategory is empty, show all transactions matching category filter
-    } else if (m_currentTableSubcategory == ""){
-        query.prepare("SELECT transactionID, date, subcategory, amount, SUM(amount) "
-                      "OVER (ORDER BY date, transactionID ROWS UNBOUNDED PRECEDING) "
-                      "AS balance FROM budget "
-                      "WHERE category = ? "
-                      "ORDER BY date, transactionID" );
-        query.bindValue(0, m_currentTableCategory);
-        query.exec();
-        transactionModel->setQuery(std::move(query));
-        transactionModel->setHeaderData(0, Qt::Horizontal, "transactionID");
-        transactionModel->setHeaderData(1, Qt::Horizontal, "Date");
-        transactionModel->setHeaderData(2, Qt::Horizontal, "Subcategory");
-        transactionModel->setHeaderData(3, Qt::Horizontal, "Amount");
-        transactionModel->setHeaderData(4, Qt::Horizontal, "Balance");
-        ui->transactionGroupBox->setTitle(QString("Table: %1 Transactions")
-                                              .arg(m_currentTableCategory));
-    // else show all transactions matching category and subcategory filters
+        title = QString("Table: All Transactions");
+    // else if currentTableSubcategory is empty, transactions matching category filter are shown
+    } else if (m_currentTableSubcategory == "") {
+        title = QString("Table: %1 Transactions").arg(m_currentTableCategory);
+    // else transactions matching category and subcategory filters are shown
     } else {
-        query.prepare("SELECT transactionID, date, amount, SUM(amount) "
-                      "OVER (ORDER BY date, transactionID ROWS UNBOUNDED PRECEDING) "
-                      "AS balance FROM budget "
-                      "WHERE category = ? "
-                      "AND subcategory = ? "
-                      "ORDER BY date, transactionID" );
-        query.bindValue(0, m_currentTableCategory);
-        query.bindValue(1, m_currentTableSubcategory);
-        query.exec();
-        transactionModel->setQuery(std::move(query));
-        transactionModel->setHeaderData(0, Qt::Horizontal, "transactionID");
-        transactionModel->setHeaderData(1, Qt::Horizontal, "Date");
-        transactionModel->setHeaderData(2, Qt::Horizontal, "Amount");
-        transactionModel->setHeaderData(3, Qt::Horizontal, "Balance");
-        ui->transactionGroupBox->setTitle(QString("Table: %1 - %2 Transactions")
-                                              .arg(m_currentTableCategory, m_currentTableSubcategory));
-    }
-    ui->transactionTableView->resizeColumnsToContents();
+        title = QString("Table: %1 - %2 Transactions")
+                    .arg(m_currentTableCategory, m_currentTableSubcategory);
+    }
+    if (m_currentTableAccountID != 0)
+        title += QString(" in %1").arg(session->accounts()->name(m_currentTableAccountID));
+    // pending entries are shown in the table, but flagged until submitted
+    if (entryJournal->pendingCount() > 0)
+        title += QString(" (%1 pending)").arg(entryJournal->pendingCount());
+    ui->transactionGroupBox->setTitle(title);
 }
 
 /**
@@ -198,6 +549,262 @@ void BudgetTracker::verifyTableFilter()
     }
 }
 
+/**
+ * @brief BudgetTracker::changeTableAccount
+ *        Shows selected account in table, or all accounts consolidated.
+ *
+ *        Connected to tableFilterAccountComboBox currentIndexChanged signal.
+ * @param index index of selected account
+ */
+void BudgetTracker::changeTableAccount(int index)
+{
+    m_currentTableAccountID = ui->tableFilterAccountComboBox->itemData(index).toLongLong();
+    transactionModel->setAccount(m_currentTableAccountID);
+    ui->transactionTableView->setColumnHidden(BudgetTableModel::AccountColumn,
+                                              m_currentTableAccountID != 0);
+    updateTableTitle();
+    fitTableColumns();
+}
+
+/**
+ * @brief BudgetTracker::finishTableLoading
+ *        Ends the startup profile once the table is complete.
+ *
+ *        Connected to BudgetTableModel loadingFinished signal.
+ */
+void BudgetTracker::finishTableLoading()
+{
+    // before the first paint, finishStartup() still follows
+    if (m_painted) {
+        StartupProfile::mark("table rows loaded");
+        StartupProfile::finish("startup complete");
+    }
+}
+
+/**
+ * @brief BudgetTracker::importTable
+ *        Imports entries from a CSV bank export into the shown account,
+ *        skipping entries already in the ledger.
+ *
+ *        Entries are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ */
+void BudgetTracker::importTable()
+{
+    if (entryJournal->pendingCount() > 0) {
+        QMessageBox::information(this, "Import",
+                                 "Submit or discard pending entries before importing.");
+        return;
+    }
+    QString path = QFileDialog::getOpenFileName(this, "Import Transactions", QString(),
+                                                "CSV files (*.csv);;All files (*)");
+    if (path.isEmpty())
+        return;
+
+    qint64 accountID = m_currentTableAccountID != 0 ? m_currentTableAccountID
+                                                    : AccountList::DefaultAccountID;
+    ImportResult result = session->importEntries(path, accountID);
+    if (!result.error.isEmpty()) {
+        QMessageBox::warning(this, "Import Failed", result.error);
+        return;
+    }
+    QMessageBox::information(this, "Import",
+                             QString("%1 entries imported, %2 already in the ledger, "
+                                     "%3 lines skipped.")
+                                 .arg(result.imported).arg(result.duplicates).arg(result.skipped));
+}
+
+/**
+ * @brief BudgetTracker::exportTable
+ *        Exports entries of the current table filter to a file in the
+ *        background; the format follows the chosen file type.
+ *
+ *        The export reads submitted entries only, so pending entries must
+ *        be submitted or discarded first.
+ */
+void BudgetTracker::exportTable()
+{
+    if (ledgerExporter->isRunning()) {
+        QMessageBox::information(this, "Export", "An export is already running.");
+        return;
+    }
+    if (entryJournal->pendingCount() > 0) {
+        QMessageBox::information(this, "Export",
+                                 "Submit or discard pending entries before exporting.");
+        return;
+    }
+    QString path = QFileDialog::getSaveFileName(this, "Export Transactions", QString(),
+                                                "CSV files (*.csv);;"
+                                                "JSON Lines files (*.jsonl);;"
+                                                "Columnar files (*.btcol)");
+    if (path.isEmpty())
+        return;
+
+    QHash<qint64, QString> accountNames;
+    for (const Account &account : session->accounts()->accounts())
+        accountNames.insert(account.accountID, account.name);
+    ledgerExporter->start(path, LedgerExporter::formatForPath(path),
+                          m_currentTableCategory, m_currentTableSubcategory,
+                          m_currentTableAccountID, accountNames);
+
+    // non-modal, so the table stays usable while exporting
+    exportProgress = new QProgressDialog("Exporting transactions...", "Cancel", 0, 0, this);
+    exportProgress->setAttribute(Qt::WA_DeleteOnClose);
+    exportProgress->setWindowModality(Qt::NonModal);
+    exportProgress->setMinimumDuration(500);
+    connect(exportProgress, &QProgressDialog::canceled,
+            ledgerExporter, &LedgerExporter::cancel);
+    ui->tableExportButton->setEnabled(false);
+}
+
+/**
+ * @brief BudgetTracker::showExportProgress
+ *        Shows number of rows written so far.
+ *
+ *        Connected to LedgerExporter progress signal.
+ * @param rows rows written
+ */
+void BudgetTracker::showExportProgress(qint64 rows)
+{
+    if (exportProgress)
+        exportProgress->setLabelText(QString("Exporting transactions... %1 rows").arg(rows));
+}
+
+/**
+ * @brief BudgetTracker::finishExport
+ *        Closes export progress and reports the result.
+ *
+ *        Connected to LedgerExporter finished signal.
+ * @param rows rows written
+ * @param error failure description; empty on success
+ */
+void BudgetTracker::finishExport(qint64 rows, const QString &error)
+{
+    if (exportProgress) {
+        // the dialog may emit canceled() while closing, so disconnect first
+        exportProgress->disconnect(ledgerExporter);
+        exportProgress->close();
+        exportProgress = nullptr;
+    }
+    ui->tableExportButton->setEnabled(true);
+    if (!error.isEmpty())
+        QMessageBox::warning(this, "Export Failed", error);
+    else
+        QMessageBox::information(this, "Export", QString("%1 transactions exported.").arg(rows));
+}
+
+/**
+ * @brief BudgetTracker::generateReport
+ *        Renders a statement report of the current table filter to PDF
+ *        or a printer in the background.
+ *
+ *        The shown rows and the plot are snapshotted here; the worker
+ *        never touches the model or widgets. Projected recurring entries
+ *        are left out of the statement.
+ */
+void BudgetTracker::generateReport()
+{
+    if (reportGenerator->isRunning()) {
+        QMessageBox::information(this, "Report", "A report is already being generated.");
+        return;
+    }
+    QMessageBox target(QMessageBox::Question, "Report", "Save the report as PDF or print it?",
+                       QMessageBox::Cancel, this);
+    QPushButton *pdfButton = target.addButton("PDF...", QMessageBox::AcceptRole);
+    QPushButton *printButton = target.addButton("Print...", QMessageBox::AcceptRole);
+    target.exec();
+
+    QString path;
+    std::shared_ptr<QPrinter> printer;
+    if (target.clickedButton() == pdfButton) {
+        path = QFileDialog::getSaveFileName(this, "Save Report", QString(), "PDF files (*.pdf)");
+        if (path.isEmpty())
+            return;
+    } else if (target.clickedButton() == printButton) {
+        printer = std::make_shared<QPrinter>(QPrinter::HighResolution);
+        QPrintDialog printDialog(printer.get(), this);
+        if (printDialog.exec() != QDialog::Accepted)
+            return;
+    } else {
+        return;
+    }
+
+    transactionModel->finishLoading();
+    ReportSnapshot snapshot;
+    snapshot.title = m_currentTableCategory.isEmpty() ? QString("All Transactions")
+                                                      : m_currentTableCategory;
+    if (!m_currentTableSubcategory.isEmpty())
+        snapshot.title += QString(" / %1").arg(m_currentTableSubcategory);
+    snapshot.currency = session->rates()->displayCurrency();
+    for (const Account &account : session->accounts()->accounts())
+        snapshot.accountNames.insert(account.accountID, account.name);
+    int rows = transactionModel->rowCount();
+    snapshot.entries.reserve(rows);
+    snapshot.converted.reserve(rows);
+    snapshot.balances.reserve(rows);
+    double previousBalance = 0;
+    for (int row = 0; row < rows; ++row) {
+        Transaction entry = transactionModel->entry(row);
+        double balance = transactionModel->balance(row);
+        if (entry.ruleID == 0) {
+            snapshot.entries.append(entry);
+            snapshot.converted.append(balance - previousBalance);
+            snapshot.balances.append(balance);
+        }
+        previousBalance = balance;
+    }
+    // QCustomPlot renders through QPixmap, which is GUI-thread only
+    snapshot.chart = ui->transactionPlot->toPixmap(1600, 1000).toImage();
+
+    if (printer)
+        reportGenerator->startPrint(snapshot, printer);
+    else
+        reportGenerator->startPdf(snapshot, path);
+
+    reportProgress = new QProgressDialog("Generating report...", "Cancel", 0, 0, this);
+    reportProgress->setAttribute(Qt::WA_DeleteOnClose);
+    reportProgress->setWindowModality(Qt::NonModal);
+    reportProgress->setMinimumDuration(500);
+    connect(reportProgress, &QProgressDialog::canceled,
+            reportGenerator, &ReportGenerator::cancel);
+    ui->tableReportButton->setEnabled(false);
+}
+
+/**
+ * @brief BudgetTracker::showReportProgress
+ *        Shows number of pages rendered so far.
+ *
+ *        Connected to ReportGenerator progress signal.
+ * @param pages pages rendered
+ */
+void BudgetTracker::showReportProgress(int pages)
+{
+    if (reportProgress)
+        reportProgress->setLabelText(QString("Generating report... %1 pages").arg(pages));
+}
+
+/**
+ * @brief BudgetTracker::finishReport
+ *        Closes report progress and reports the result.
+ *
+ *        Connected to ReportGenerator finished signal.
+ * @param pages pages rendered
+ * @param error failure description; empty on success
+ */
+void BudgetTracker::finishReport(int pages, const QString &error)
+{
+    if (reportProgress) {
+        reportProgress->disconnect(reportGenerator);
+        reportProgress->close();
+        reportProgress = nullptr;
+    }
+    ui->tableReportButton->setEnabled(true);
+    if (!error.isEmpty())
+        QMessageBox::warning(this, "Report Failed", error);
+    else
+        QMessageBox::information(this, "Report", QString("Report of %1 pages generated.").arg(pages));
+}
+
 /**
  * @brief BudgetTracker::clearTableFilter
  *        Sets table category and subcategory filters to empty string,
@@ -208,11 +815,6 @@ void BudgetTracker::clearTableFilter()
     m_currentTableCategory = "";
     m_currentTableSubcategory = "";
     drawTable();
-    // for some reason this needs to be called again
-    /// BUG: columns are resized, but last column header section does not
-    /// stretch (as set in initializeTable()) until any header has its size
-    /// adjusted (only happens on clearTableFilter())
-    ui->transactionTableView->resizeColumnsToContents();
 
     ui->tableFilterCategoryLineEdit->clear();
     ui->tableFilterSubcategoryLineEdit->clear();
@@ -222,8 +824,13 @@ void BudgetTracker::clearTableFilter()
 
 /**
  * @brief BudgetTracker::initializePlot
- *        Sets up transaction plot axis information and graph settings,
- *        then calls drawPlot with no filters.
+ *        Sets up transaction plot axis information and graph settings.
+ *        Data is drawn by drawPlot(), first from finishStartup().
+ *
+ *        Daily net amounts are drawn as bars with the running balance as a
+ *        line on top. Plottables live on the main layer, while interactive
+ *        items go on the buffered overlay layer, which can be repainted on
+ *        its own without re-rendering the data.
  */
 void BudgetTracker::initializePlot()
 {
@@ -236,81 +843,233 @@ void BudgetTracker::initializePlot()
     // setup axes
     ui->transactionPlot->xAxis->setLabel("Date");
     ui->transactionPlot->xAxis->setTicker(dateTimeTicker);
-    ui->transactionPlot->yAxis->setLabel("Amount");
+    ui->transactionPlot->yAxis->setLabel("Daily Amount");
+    // balance is on its own axis, since it is not a transaction amount
+    ui->transactionPlot->yAxis2->setVisible(true);
+    ui->transactionPlot->yAxis2->setLabel("Balance");
+
+    // rendering setup: cached overlay layer, fast polylines, no antialiasing while dragging
+    ui->transactionPlot->layer("overlay")->setMode(QCPLayer::lmBuffered);
+    ui->transactionPlot->setPlottingHints(QCP::phFastPolylines | QCP::phCacheLabels);
+    ui->transactionPlot->setNoAntialiasingOnDrag(true);
+    // only comparison series are listed in the legend
+    ui->transactionPlot->setAutoAddPlottableToLegend(false);
+    ui->transactionPlot->axisRect()->insetLayout()->setInsetAlignment(0, Qt::AlignTop | Qt::AlignLeft);
 
     // initialize plot
-    ui->transactionPlot->addGraph();
-    ui->transactionPlot->graph()->setLineStyle(QCPGraph::lsNone);
-    ui->transactionPlot->graph()->setScatterStyle(QCPScatterStyle::ScatterShape::ssDisc);
-    ui->transactionPlot->setInteractions(QCP::iRangeZoom | QCP::iRangeDrag);
-    drawPlot();
+    transactionBars = new QCPBars(ui->transactionPlot->xAxis, ui->transactionPlot->yAxis);
+    transactionBars->setWidth(PlotBarWidth);
+    transactionBars->setPen(Qt::NoPen);
+    transactionBars->setBrush(QColor(40, 110, 200, 170));
+    // projected entries of recurring rules are drawn faded
+    projectedBars = new QCPBars(ui->transactionPlot->xAxis, ui->transactionPlot->yAxis);
+    projectedBars->setWidth(PlotBarWidth);
+    projectedBars->setPen(QPen(QColor(40, 110, 200), 1, Qt::DotLine));
+    projectedBars->setBrush(QColor(40, 110, 200, 50));
+    balanceGraph = ui->transactionPlot->addGraph(ui->transactionPlot->xAxis,
+                                                 ui->transactionPlot->yAxis2);
+    balanceGraph->setLineStyle(QCPGraph::lsStepLeft);
+    balanceGraph->setPen(QPen(Qt::darkGreen, 2));
+    balanceGraph->setAdaptiveSampling(true);
+    forecastGraph = ui->transactionPlot->addGraph(ui->transactionPlot->xAxis,
+                                                  ui->transactionPlot->yAxis2);
+    forecastGraph->setPen(QPen(Qt::darkGreen, 2, Qt::DashLine));
+    anomalyGraph = ui->transactionPlot->addGraph(ui->transactionPlot->xAxis,
+                                                 ui->transactionPlot->yAxis);
+    anomalyGraph->setLineStyle(QCPGraph::lsNone);
+    anomalyGraph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle,
+                                                  QPen(Qt::red, 1.5), Qt::NoBrush, 9));
+    anomalyGraph->setSelectable(QCP::stNone);
+    // bars are selectable and linked to the table selection; shift-drag selects a range
+    transactionBars->setSelectable(QCP::stMultipleDataRanges);
+    projectedBars->setSelectable(QCP::stMultipleDataRanges);
+    ui->transactionPlot->setInteractions(QCP::iRangeZoom | QCP::iRangeDrag
+                                         | QCP::iSelectPlottables | QCP::iMultiSelect);
+
+    // hover items live on the buffered overlay layer, so moving them never re-renders data
+    hoverTracer = new QCPItemTracer(ui->transactionPlot);
+    hoverTracer->setLayer("overlay");
+    hoverTracer->position->setAxes(ui->transactionPlot->xAxis, ui->transactionPlot->yAxis2);
+    hoverTracer->setStyle(QCPItemTracer::tsCircle);
+    hoverTracer->setSize(8);
+    hoverTracer->setPen(QPen(Qt::black, 1.5));
+    hoverTracer->setVisible(false);
+    hoverLabel = new QCPItemText(ui->transactionPlot);
+    hoverLabel->setLayer("overlay");
+    hoverLabel->position->setParentAnchor(hoverTracer->position);
+    hoverLabel->position->setCoords(0, -10);
+    hoverLabel->setPositionAlignment(Qt::AlignBottom | Qt::AlignHCenter);
+    hoverLabel->setTextAlignment(Qt::AlignLeft);
+    hoverLabel->setPadding(QMargins(4, 2, 4, 2));
+    hoverLabel->setPen(QPen(Qt::gray));
+    hoverLabel->setBrush(QColor(255, 255, 255, 230));
+    hoverLabel->setClipToAxisRect(false);
+    hoverLabel->setVisible(false);
+    hoverTimer->setSingleShot(true);
+    hoverTimer->setInterval(HoverIntervalMs);
 }
 
 /**
  * @brief BudgetTracker::drawPlot
  *        Draws plot base on current plot category and subcategory filters.
+ *
+ *        Entries are bucketed per day by the query itself, so the number of
+ *        plotted points depends on the number of days, not transactions.
+ *        Pending entries are added to the stored sums.
+ *        Entries unusual for their category are marked on top.
+ *        In comparison mode, drawComparison() is drawn instead.
  */
 void BudgetTracker::drawPlot()
 {
-    QSqlQuery query;
+    if (!m_comparisonCategories.isEmpty()) {
+        drawComparison();
+        return;
+    }
+    clearComparison();
+
+    QSqlQuery query(session->database());
+    query.setForwardOnly(true);
+    LedgerFilter filter;
+    filter.category = m_currentPlotCategory;
+    filter.subcategory = m_currentPlotSubcategory;
+    LedgerQuery::prepare<LedgerQuery::PlotSums>(query, filter);
     // if currentPlotCategory is empty, plot all transactions
     if (m_currentPlotCategory == "") {
-        query.prepare("SELECT date, amount "
-                      "FROM budget "
-                      "ORDER BY date, transactionID");
         ui->plotGroupBox->setTitle(QString("Plot: All Transactions"));
     // else if currentPlotSubcategory is empty, plot transactions matching category filter
     } else if (m_currentPlotSubcategory == ""){
-        query.prepare("SELECT date, amount "
-                      "FROM budget "
-                      "WHERE category = ? "
-                      "ORDER BY date, transactionID");
-        query.bindValue(0, m_currentPlotCategory);
         ui->plotGroupBox->setTitle(QString("Plot: %1 Transactions").arg(m_currentPlotCategory));
     // else plot transactions matching category and subcategory filters
     } else {
-        query.prepare("SELECT date, amount "
-                      "FROM budget "
-                      "WHERE category = ? "
-                      "AND subcategory = ? "
-                      "ORDER BY date, transactionID");
-        query.bindValue(0, m_currentPlotCategory);
-        query.bindValue(1, m_currentPlotSubcategory);
         ui->plotGroupBox->setTitle(QString("Plot: %1 - %2 Transactions").arg(m_currentPlotCategory, m_currentPlotSubcategory));
     }
-    query.exec();
+    // e.g. locked by another instance past the busy timeout; keep the last plot
+    if (!query.exec()) {
+        qWarning() << "Plot query failed:" << query.lastError().text();
+        return;
+    }
 
-    // populate data vectors with relevant sql info
+    // convert per-currency daily sums in one batch
+    QVector<Transaction> sums;
+    while (query.next()) {
+        Transaction sum;
+        sum.date = query.value(0).toString();
+        sum.currency = query.value(1).toString();
+        sum.amount = query.value(2).toDouble();
+        sums.push_back(sum);
+    }
+    const QVector<Transaction> delta = entryJournal->pendingDelta(filter);
+    if (!delta.isEmpty()) {
+        sums.append(delta);
+        std::stable_sort(sums.begin(), sums.end(), [](const Transaction &a, const Transaction &b) {
+            return a.date < b.date;
+        });
+    }
+    const QVector<double> converted = session->rates()->convert(sums);
+
+    // populate daily buckets with converted sums
     QVector<double> dates;
     QVector<double> amounts;
-    while (query.next()) {
-        dates.push_back(QCPAxisTickerDateTime::dateTimeToKey(QDateTime::fromString(query.value(0).toString(), "yyyy/MM/dd")));
-        amounts.push_back(query.value(1).toDouble());
+    for (int i = 0; i < sums.size(); ++i) {
+        double date = QCPAxisTickerDateTime::dateTimeToKey(QDateTime::fromString(sums.at(i).date, "yyyy/MM/dd"));
+        if (!dates.isEmpty() && dates.last() == date) {
+            amounts.last() += converted.at(i);
+        } else {
+            dates.push_back(date);
+            amounts.push_back(converted.at(i));
+        }
     }
 
-    // determine ranges for x (date) and y (amount)
-    if (m_currentPlotCategory == "") {
-        query.prepare("SELECT MIN(date), MAX(date), MIN(amount), MAX(amount) "
-                      "FROM budget");
-    } else if (m_currentPlotSubcategory == ""){
-        query.prepare("SELECT MIN(date), MAX(date), MIN(amount), MAX(amount) "
-                      "FROM budget "
-                      "WHERE category = ?");
-        query.bindValue(0, m_currentPlotCategory);
-    } else {
-        query.prepare("SELECT MIN(date), MAX(date), MIN(amount), MAX(amount) "
-                      "FROM budget "
-                      "WHERE category = ? "
-                      "AND subcategory = ?");
-        query.bindValue(0, m_currentPlotCategory);
-        query.bindValue(1, m_currentPlotSubcategory);
-    }
-    query.exec();
-    query.next();
-    QDateTime minDate = QDateTime::fromString(query.value(0).toString(), "yyyy/MM/dd");
-    QDateTime maxDate = QDateTime::fromString(query.value(1).toString(), "yyyy/MM/dd");
-    double minAmount = query.value(2).toDouble();
-    double maxAmount = query.value(3).toDouble();
+    // bucket projected entries up to projection horizon; panning further extends them
+    m_projectedUntil = RecurringSchedule::projectionHorizon();
+    QVector<double> projectedDates;
+    QVector<double> projectedAmounts;
+    const QVector<Transaction> projected = session->schedule()->occurrences(session->schedule()->earliestStart(),
+                                                                           m_projectedUntil,
+                                                                           m_currentPlotCategory,
+                                                                           m_currentPlotSubcategory);
+    const QVector<double> projectedConverted = session->rates()->convert(projected);
+    for (int i = 0; i < projected.size(); ++i) {
+        double date = QCPAxisTickerDateTime::dateTimeToKey(QDateTime::fromString(projected.at(i).date, "yyyy/MM/dd"));
+        if (!projectedDates.isEmpty() && projectedDates.last() == date) {
+            projectedAmounts.last() += projectedConverted.at(i);
+        } else {
+            projectedDates.push_back(date);
+            projectedAmounts.push_back(projectedConverted.at(i));
+        }
+    }
+
+    // running balance over stored and projected buckets, merged by date
+    QVector<double> balanceDates;
+    QVector<double> balances;
+    QVector<double> dailyAmounts;
+    double balance = 0;
+    int storedIndex = 0;
+    int projectedIndex = 0;
+    while (storedIndex < dates.size() || projectedIndex < projectedDates.size()) {
+        double date;
+        if (projectedIndex == projectedDates.size()
+            || (storedIndex < dates.size() && dates.at(storedIndex) <= projectedDates.at(projectedIndex))) {
+            date = dates.at(storedIndex);
+        } else {
+            date = projectedDates.at(projectedIndex);
+        }
+        double dailyAmount = 0;
+        while (storedIndex < dates.size() && dates.at(storedIndex) == date)
+            dailyAmount += amounts.at(storedIndex++);
+        while (projectedIndex < projectedDates.size() && projectedDates.at(projectedIndex) == date)
+            dailyAmount += projectedAmounts.at(projectedIndex++);
+        balance += dailyAmount;
+        balanceDates.push_back(date);
+        balances.push_back(balance);
+        dailyAmounts.push_back(dailyAmount);
+    }
+    m_plotBalance = balance;
+
+    // sorted hover index, searched by showHover()
+    m_hoverKeys = balanceDates;
+    m_hoverAmounts = dailyAmounts;
+    m_hoverBalances = balances;
+    hoverTracer->setVisible(false);
+    hoverLabel->setVisible(false);
+    // selected data indices refer to the old buckets
+    transactionBars->setSelection(QCPDataSelection());
+    projectedBars->setSelection(QCPDataSelection());
+
+    // determine ranges for x (date) and y (daily amount) from the buckets
+    QDateTime minDate = QDateTime(QDate::currentDate(), QTime(0, 0));
+    QDateTime maxDate = minDate;
+    double minAmount = 0;
+    double maxAmount = 0;
+    if (!balanceDates.isEmpty()) {
+        minDate = QCPAxisTickerDateTime::keyToDateTime(balanceDates.first());
+        maxDate = QCPAxisTickerDateTime::keyToDateTime(balanceDates.last());
+    }
+    for (double amount : amounts) {
+        minAmount = std::min(minAmount, amount);
+        maxAmount = std::max(maxAmount, amount);
+    }
+    for (double amount : projectedAmounts) {
+        minAmount = std::min(minAmount, amount);
+        maxAmount = std::max(maxAmount, amount);
+    }
+
+    // unusual entries of the filter, marked at their own amount
+    QVector<double> anomalyDates;
+    QVector<double> anomalyAmounts;
+    const QVector<Transaction> anomalies = session->anomalies()->anomalies(m_currentPlotCategory,
+                                                                          m_currentPlotSubcategory);
+    for (const Transaction &entry : anomalies) {
+        double amount = session->rates()->convert(entry);
+        anomalyDates.push_back(QCPAxisTickerDateTime::dateTimeToKey(QDateTime::fromString(entry.date, "yyyy/MM/dd")));
+        anomalyAmounts.push_back(amount);
+        minAmount = std::min(minAmount, amount);
+        maxAmount = std::max(maxAmount, amount);
+    }
+
+    // keep the forecast period in view
+    QDateTime forecastEnd(QDate::currentDate().addMonths(BalanceForecaster::ForecastMonths), QTime(0, 0));
+    maxDate = std::max(maxDate, forecastEnd);
 
     // create margin around X range
     double minRangeX;
@@ -327,7 +1086,6 @@ void BudgetTracker::drawPlot()
     maxRangeX = (QCPAxisTickerDateTime::dateTimeToKey(maxDate)
                         + (QCPAxisTickerDateTime::dateTimeToKey(maxDate)
                            - QCPAxisTickerDateTime::dateTimeToKey(minDate))/10);
-    ui->transactionPlot->xAxis->setRange(minRangeX, maxRangeX);
 
     // create margin around Y range
     double minRangeY;
@@ -340,13 +1098,545 @@ void BudgetTracker::drawPlot()
     }
     minRangeY = (minAmount - (maxAmount - minAmount)/10);
     maxRangeY = (maxAmount + (maxAmount -minAmount)/10);
+
+    // plot data (before setting range, which may extend projected data)
+    transactionBars->setData(dates, amounts, true);
+    projectedBars->setData(projectedDates, projectedAmounts, true);
+    balanceGraph->setData(balanceDates, balances, true);
+    anomalyGraph->setData(anomalyDates, anomalyAmounts);
+    ui->transactionPlot->xAxis->setRange(minRangeX, maxRangeX);
     ui->transactionPlot->yAxis->setRange(minRangeY, maxRangeY);
+    balanceGraph->rescaleValueAxis();
+    ui->transactionPlot->replot();
+
+    // projected balance arrives asynchronously in drawForecast()
+    balanceForecaster->request(m_currentPlotCategory, m_currentPlotSubcategory,
+                               session->schedule()->occurrences(session->schedule()->earliestStart(),
+                                                               forecastEnd.date(),
+                                                               m_currentPlotCategory,
+                                                               m_currentPlotSubcategory));
+}
+
+/**
+ * @brief BudgetTracker::drawComparison
+ *        Draws running total of each compared category as its own series.
+ *
+ *        All series come from a single query grouped by category, date and
+ *        currency, whose rows arrive ordered per category. Rows are partitioned into
+ *        their series, pending entries are added, and running totals are
+ *        accumulated per series.
+ */
+void BudgetTracker::drawComparison()
+{
+    clearComparison();
+
+    // daily, transaction and forecast plottables are hidden while comparing
+    transactionBars->setVisible(false);
+    projectedBars->setVisible(false);
+    balanceGraph->setVisible(false);
+    forecastGraph->setVisible(false);
+    anomalyGraph->setVisible(false);
+    ui->transactionPlot->yAxis->setLabel("Running Total");
+    ui->transactionPlot->yAxis2->setVisible(false);
+    ui->plotGroupBox->setTitle(QString("Plot: Comparing %1").arg(m_comparisonCategories.join(", ")));
+
+    QStringList placeholders(m_comparisonCategories.size(), "?");
+    QSqlQuery query(session->database());
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT category, date, currency, SUM(amount) "
+                          "FROM budget "
+                          "WHERE category IN (%1) "
+                          "GROUP BY category, date, currency "
+                          "ORDER BY category, date").arg(placeholders.join(", ")));
+    for (int i = 0; i < m_comparisonCategories.size(); ++i)
+        query.bindValue(i, m_comparisonCategories.at(i));
+    if (!query.exec()) {
+        qWarning() << "Comparison query failed:" << query.lastError().text();
+        return;
+    }
+
+    // partition rows into series, then add pending entries to their series
+    QHash<QString, int> seriesIndex;
+    for (int i = 0; i < m_comparisonCategories.size(); ++i)
+        seriesIndex.insert(m_comparisonCategories.at(i), i);
+    QVector<QVector<Transaction>> sums(m_comparisonCategories.size());
+    while (query.next()) {
+        int series = seriesIndex.value(query.value(0).toString(), -1);
+        if (series < 0)
+            continue;
+        Transaction sum;
+        sum.date = query.value(1).toString();
+        sum.currency = query.value(2).toString();
+        sum.amount = query.value(3).toDouble();
+        sums[series].push_back(sum);
+    }
+    QVector<bool> changed(m_comparisonCategories.size(), false);
+    for (const Transaction &entry : entryJournal->pendingDelta(LedgerFilter())) {
+        int series = seriesIndex.value(entry.category, -1);
+        if (series < 0)
+            continue;
+        sums[series].push_back(entry);
+        changed[series] = true;
+    }
+
+    // convert and accumulate running totals per series
+    QVector<QVector<double>> dates(m_comparisonCategories.size());
+    QVector<QVector<double>> totals(m_comparisonCategories.size());
+    for (int series = 0; series < sums.size(); ++series) {
+        if (changed.at(series)) {
+            std::stable_sort(sums[series].begin(), sums[series].end(),
+                             [](const Transaction &a, const Transaction &b) {
+                                 return a.date < b.date;
+                             });
+        }
+        const QVector<double> converted = session->rates()->convert(sums.at(series));
+        double runningTotal = 0;
+        for (int i = 0; i < converted.size(); ++i) {
+            runningTotal += converted.at(i);
+            double date = QCPAxisTickerDateTime::dateTimeToKey(QDateTime::fromString(sums.at(series).at(i).date, "yyyy/MM/dd"));
+            // one row per currency, so a day can span several rows
+            if (!dates.at(series).isEmpty() && dates.at(series).last() == date) {
+                totals[series].last() = runningTotal;
+            } else {
+                dates[series].push_back(date);
+                totals[series].push_back(runningTotal);
+            }
+        }
+    }
 
-    // plot data
-    ui->transactionPlot->graph()->setData(dates, amounts);
+    bool hasData = false;
+    for (int i = 0; i < m_comparisonCategories.size(); ++i) {
+        QCPGraph *graph = ui->transactionPlot->addGraph(ui->transactionPlot->xAxis,
+                                                        ui->transactionPlot->yAxis);
+        graph->setName(m_comparisonCategories.at(i));
+        graph->setLineStyle(QCPGraph::lsStepLeft);
+        graph->setPen(QPen(QColor::fromHsv(i * 360 / m_comparisonCategories.size(), 200, 190), 2));
+        graph->setAdaptiveSampling(true);
+        graph->setSelectable(QCP::stNone);
+        graph->setData(dates.at(i), totals.at(i), true);
+        graph->addToLegend();
+        comparisonGraphs.push_back(graph);
+        hasData = hasData || !dates.at(i).isEmpty();
+    }
+    ui->transactionPlot->legend->setVisible(true);
+
+    // there is no hovered day or bar selection in comparison mode
+    m_hoverKeys.clear();
+    m_hoverAmounts.clear();
+    m_hoverBalances.clear();
+    hoverTracer->setVisible(false);
+    hoverLabel->setVisible(false);
+
+    if (hasData) {
+        ui->transactionPlot->rescaleAxes(true);
+        ui->transactionPlot->xAxis->scaleRange(1.2);
+        ui->transactionPlot->yAxis->scaleRange(1.2);
+    }
     ui->transactionPlot->replot();
 }
 
+/**
+ * @brief BudgetTracker::clearComparison
+ *        Removes comparison series and restores the regular plottables.
+ */
+void BudgetTracker::clearComparison()
+{
+    if (comparisonGraphs.isEmpty())
+        return;
+
+    for (QCPGraph *graph : comparisonGraphs)
+        ui->transactionPlot->removeGraph(graph);
+    comparisonGraphs.clear();
+    ui->transactionPlot->legend->setVisible(false);
+
+    transactionBars->setVisible(true);
+    projectedBars->setVisible(true);
+    balanceGraph->setVisible(true);
+    forecastGraph->setVisible(true);
+    anomalyGraph->setVisible(true);
+    ui->transactionPlot->yAxis->setLabel("Daily Amount");
+    ui->transactionPlot->yAxis2->setVisible(true);
+}
+
+/**
+ * @brief BudgetTracker::drawForecast
+ *        Plots projected balance curve, unless plot filter changed meanwhile.
+ *
+ *        Connected to BalanceForecaster forecastReady signal.
+ * @param category plot category the forecast was computed for
+ * @param subcategory plot subcategory the forecast was computed for
+ * @param keys plot keys of projected balance points
+ * @param balances projected balances
+ */
+void BudgetTracker::drawForecast(const QString &category, const QString &subcategory,
+                                 const QVector<double> &keys, const QVector<double> &balances)
+{
+    if (category != m_currentPlotCategory || subcategory != m_currentPlotSubcategory
+        || !m_comparisonCategories.isEmpty()) {
+        return;
+    }
+
+    forecastGraph->setData(keys, balances, true);
+    forecastGraph->rescaleValueAxis(true);
+    ui->transactionPlot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+/**
+ * @brief BudgetTracker::extendProjection
+ *        Buckets projected entries for dates that become visible
+ *        past the currently projected range, continuing the balance line.
+ *
+ *        Connected to plot x-axis rangeChanged signal.
+ * @param range new x-axis range
+ */
+void BudgetTracker::extendProjection(const QCPRange &range)
+{
+    QDate visibleUntil = QCPAxisTickerDateTime::keyToDateTime(range.upper).date();
+    if (visibleUntil <= m_projectedUntil || !m_comparisonCategories.isEmpty())
+        return;
+
+    QVector<double> projectedDates;
+    QVector<double> projectedAmounts;
+    QVector<double> balances;
+    const QVector<Transaction> projected = session->schedule()->occurrences(m_projectedUntil.addDays(1),
+                                                                           visibleUntil,
+                                                                           m_currentPlotCategory,
+                                                                           m_currentPlotSubcategory);
+    const QVector<double> projectedConverted = session->rates()->convert(projected);
+    for (int i = 0; i < projected.size(); ++i) {
+        double date = QCPAxisTickerDateTime::dateTimeToKey(QDateTime::fromString(projected.at(i).date, "yyyy/MM/dd"));
+        double amount = projectedConverted.at(i);
+        m_plotBalance += amount;
+        if (!projectedDates.isEmpty() && projectedDates.last() == date) {
+            projectedAmounts.last() += amount;
+            balances.last() = m_plotBalance;
+        } else {
+            projectedDates.push_back(date);
+            projectedAmounts.push_back(amount);
+            balances.push_back(m_plotBalance);
+        }
+    }
+    projectedBars->addData(projectedDates, projectedAmounts, true);
+    balanceGraph->addData(projectedDates, balances, true);
+    m_hoverKeys.append(projectedDates);
+    m_hoverAmounts.append(projectedAmounts);
+    m_hoverBalances.append(balances);
+    m_projectedUntil = visibleUntil;
+}
+
+/**
+ * @brief BudgetTracker::editRecurring
+ *        Opens RecurringDialog, redrawing all session windows if rules changed.
+ *
+ *        Rules are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ */
+void BudgetTracker::editRecurring()
+{
+    if (entryJournal->pendingCount() > 0) {
+        QMessageBox::information(this, "Recurring Entries",
+                                 "Submit or discard pending entries before editing recurring entries.");
+        return;
+    }
+    RecurringDialog rDialog(session->schedule(), session->accounts(), this);
+    rDialog.exec();
+    if (rDialog.rulesChanged())
+        session->notifyScheduleChanged();
+}
+
+/**
+ * @brief BudgetTracker::addAccount
+ *        Asks for a name and stores a new account, selecting it for new entries.
+ *
+ *        Accounts are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ */
+void BudgetTracker::addAccount()
+{
+    if (entryJournal->pendingCount() > 0) {
+        QMessageBox::information(this, "New Account",
+                                 "Submit or discard pending entries before adding an account.");
+        return;
+    }
+    QString name = QInputDialog::getText(this, "New Account", "Account name:").trimmed();
+    if (name.isEmpty())
+        return;
+
+    qint64 accountID = session->addAccount(name);
+    if (accountID == 0) {
+        QMessageBox::warning(this, "New Account", QString("Account \"%1\" could not be added.").arg(name));
+        return;
+    }
+    ui->entryAccountComboBox->setCurrentIndex(ui->entryAccountComboBox->findData(accountID));
+}
+
+/**
+ * @brief BudgetTracker::changeDisplayCurrency
+ *        Converts balances and plot of all session windows to newly
+ *        selected currency.
+ *
+ *        Connected to displayCurrencyComboBox currentTextChanged signal.
+ * @param currency ISO 4217 code
+ */
+void BudgetTracker::changeDisplayCurrency(const QString &currency)
+{
+    session->setDisplayCurrency(currency);
+}
+
+/**
+ * @brief BudgetTracker::importRates
+ *        Imports exchange rates from a local CSV file and reconverts
+ *        balances and plot.
+ *
+ *        Rates are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ */
+void BudgetTracker::importRates()
+{
+    if (entryJournal->pendingCount() > 0) {
+        QMessageBox::information(this, "Import Rates",
+                                 "Submit or discard pending entries before importing rates.");
+        return;
+    }
+    QString path = QFileDialog::getOpenFileName(this, "Import Exchange Rates", QString(),
+                                                "CSV files (*.csv);;All files (*)");
+    if (path.isEmpty())
+        return;
+
+    QString error;
+    int count = session->importRates(path, &error);
+    if (count < 0) {
+        QMessageBox::warning(this, "Import Failed", error);
+        return;
+    }
+    QMessageBox::information(this, "Import Rates", QString("%1 rates imported.").arg(count));
+}
+
+/**
+ * @brief BudgetTracker::setBudgetTarget
+ *        Asks for a category and its monthly target in the display currency.
+ *
+ *        Targets are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ */
+void BudgetTracker::setBudgetTarget()
+{
+    if (entryJournal->pendingCount() > 0) {
+        QMessageBox::information(this, "Set Target",
+                                 "Submit or discard pending entries before setting a target.");
+        return;
+    }
+    QString current;
+    if (ui->budgetListWidget->currentItem())
+        current = ui->budgetListWidget->currentItem()->data(Qt::UserRole).toString();
+    QStringList categories = session->categoryIndex()->categories();
+    bool ok = false;
+    QString category = QInputDialog::getItem(this, "Set Target", "Category:", categories,
+                                             std::max(0, static_cast<int>(categories.indexOf(current))),
+                                             true, &ok).trimmed();
+    if (!ok || category.isEmpty())
+        return;
+
+    BudgetStatus status = session->budgetTargets()->status(category);
+    double amount = QInputDialog::getDouble(this, "Set Target",
+                                            QString("Monthly target for %1 (%2):")
+                                                .arg(category, session->rates()->displayCurrency()),
+                                            status.target, 0.01, 1e12, 2, &ok);
+    if (!ok)
+        return;
+
+    ui->budgetAlertLabel->clear();
+    if (!session->setBudgetTarget(category, amount, session->rates()->displayCurrency())) {
+        QMessageBox::warning(this, "Set Target",
+                             QString("Target for \"%1\" could not be stored.").arg(category));
+    }
+}
+
+/**
+ * @brief BudgetTracker::removeBudgetTarget
+ *        Removes target of selected category.
+ *
+ *        Targets are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ */
+void BudgetTracker::removeBudgetTarget()
+{
+    if (!ui->budgetListWidget->currentItem())
+        return;
+    if (entryJournal->pendingCount() > 0) {
+        QMessageBox::information(this, "Remove Target",
+                                 "Submit or discard pending entries before removing a target.");
+        return;
+    }
+    QString category = ui->budgetListWidget->currentItem()->data(Qt::UserRole).toString();
+    ui->budgetAlertLabel->clear();
+    if (!session->removeBudgetTarget(category)) {
+        QMessageBox::warning(this, "Remove Target",
+                             QString("Target for \"%1\" could not be removed.").arg(category));
+    }
+}
+
+/**
+ * @brief BudgetTracker::verifyBudgetRemove
+ *        Enables target remove button if a target is selected.
+ */
+void BudgetTracker::verifyBudgetRemove()
+{
+    ui->budgetRemoveButton->setEnabled(ui->budgetListWidget->currentItem() != nullptr);
+}
+
+/**
+ * @brief BudgetTracker::trackHover
+ *        Records cursor position and schedules hover update.
+ *
+ *        Mouse moves are coalesced by hoverTimer, so the overlay is repainted
+ *        at most once per interval no matter how fast events arrive.
+ *        Connected to transactionPlot mouseMove signal.
+ * @param event mouse move event
+ */
+void BudgetTracker::trackHover(QMouseEvent *event)
+{
+    m_hoverPos = event->position().toPoint();
+    m_hoverDragging = event->buttons() != Qt::NoButton;
+    if (!hoverTimer->isActive())
+        hoverTimer->start();
+}
+
+/**
+ * @brief BudgetTracker::showHover
+ *        Moves hover tracer to the day closest to the cursor and shows its
+ *        date, net amount and balance.
+ *
+ *        The day is found by binary search over the sorted plot keys,
+ *        so the cost does not depend on the size of the ledger.
+ *        Connected to hoverTimer timeout signal.
+ */
+void BudgetTracker::showHover()
+{
+    bool visible = false;
+    if (!m_hoverDragging && !m_hoverKeys.isEmpty()
+        && ui->transactionPlot->axisRect()->rect().contains(m_hoverPos)) {
+        double key = ui->transactionPlot->xAxis->pixelToCoord(m_hoverPos.x());
+        int index = std::lower_bound(m_hoverKeys.cbegin(), m_hoverKeys.cend(), key)
+                    - m_hoverKeys.cbegin();
+        // nearest of the neighbouring keys
+        if (index == m_hoverKeys.size()
+            || (index > 0 && key - m_hoverKeys.at(index - 1) < m_hoverKeys.at(index) - key)) {
+            --index;
+        }
+
+        double pixel = ui->transactionPlot->xAxis->coordToPixel(m_hoverKeys.at(index));
+        if (std::abs(pixel - m_hoverPos.x()) <= HoverDistancePx) {
+            hoverTracer->position->setCoords(m_hoverKeys.at(index), m_hoverBalances.at(index));
+            hoverLabel->setText(QString("%1\nAmount: %2 %4\nBalance: %3 %4")
+                                    .arg(QCPAxisTickerDateTime::keyToDateTime(m_hoverKeys.at(index))
+                                             .toString("yyyy/MM/dd"))
+                                    .arg(m_hoverAmounts.at(index))
+                                    .arg(m_hoverBalances.at(index))
+                                    .arg(session->rates()->displayCurrency()));
+            visible = true;
+        }
+    }
+
+    // only repaint overlay if something changed on it
+    if (!visible && !hoverTracer->visible())
+        return;
+    hoverTracer->setVisible(visible);
+    hoverLabel->setVisible(visible);
+    ui->transactionPlot->layer("overlay")->replot();
+}
+
+/**
+ * @brief BudgetTracker::setPlotSelectionMode
+ *        Makes dragging draw a selection rectangle while shift is held,
+ *        and pan the plot otherwise.
+ *
+ *        Connected to transactionPlot mousePress signal, which is emitted
+ *        before the plot decides how to handle the drag.
+ * @param event mouse press event
+ */
+void BudgetTracker::setPlotSelectionMode(QMouseEvent *event)
+{
+    ui->transactionPlot->setSelectionRectMode(event->modifiers() & Qt::ShiftModifier
+                                                  ? QCP::srmSelect
+                                                  : QCP::srmNone);
+}
+
+/**
+ * @brief BudgetTracker::selectPlotFromTable
+ *        Highlights the day bars of the selected table rows.
+ *
+ *        Each row's day is found in the sorted bar data by binary search.
+ *        Connected to transactionTableView selectionChanged signal.
+ */
+void BudgetTracker::selectPlotFromTable()
+{
+    if (m_syncingSelection)
+        return;
+    m_syncingSelection = true;
+
+    QSet<int> rows;
+    for (const QModelIndex &index : ui->transactionTableView->selectionModel()->selectedIndexes())
+        rows.insert(index.row());
+
+    QCPDataSelection storedSelection;
+    QCPDataSelection projectedSelection;
+    for (int row : rows) {
+        Transaction entry = transactionModel->entry(row);
+        double key = QCPAxisTickerDateTime::dateTimeToKey(QDateTime::fromString(entry.date, "yyyy/MM/dd"));
+        QCPBars *bars = entry.ruleID == 0 ? transactionBars : projectedBars;
+        QCPDataSelection &selection = entry.ruleID == 0 ? storedSelection : projectedSelection;
+        auto it = bars->data()->findBegin(key, false);
+        if (it != bars->data()->constEnd() && it->key == key) {
+            int dataIndex = it - bars->data()->constBegin();
+            selection.addDataRange(QCPDataRange(dataIndex, dataIndex + 1), false);
+        }
+    }
+    storedSelection.simplify();
+    projectedSelection.simplify();
+    transactionBars->setSelection(storedSelection);
+    projectedBars->setSelection(projectedSelection);
+    ui->transactionPlot->replot(QCustomPlot::rpQueuedReplot);
+
+    m_syncingSelection = false;
+}
+
+/**
+ * @brief BudgetTracker::selectTableFromPlot
+ *        Selects the table rows of the selected day bars and scrolls to the first.
+ *
+ *        Each day's rows are found in the date-ordered model by binary search,
+ *        so this works the same for any table filter.
+ *        Connected to bar selectionChanged signals.
+ */
+void BudgetTracker::selectTableFromPlot()
+{
+    if (m_syncingSelection)
+        return;
+    m_syncingSelection = true;
+
+    QItemSelection selection;
+    for (QCPBars *bars : {transactionBars, projectedBars}) {
+        for (const QCPDataRange &range : bars->selection().dataRanges()) {
+            for (int dataIndex = range.begin(); dataIndex < range.end(); ++dataIndex) {
+                QString date = QCPAxisTickerDateTime::keyToDateTime(bars->data()->at(dataIndex)->key)
+                                   .toString("yyyy/MM/dd");
+                std::pair<int, int> rows = transactionModel->rowsForDate(date);
+                if (rows.first < rows.second) {
+                    selection.select(transactionModel->index(rows.first, 0),
+                                     transactionModel->index(rows.second - 1,
+                                                             BudgetTableModel::ColumnCount - 1));
+                }
+            }
+        }
+    }
+    ui->transactionTableView->selectionModel()->select(selection, QItemSelectionModel::ClearAndSelect);
+    if (!selection.isEmpty())
+        ui->transactionTableView->scrollTo(selection.first().topLeft());
+
+    m_syncingSelection = false;
+}
+
 /**
  * @brief BudgetTracker::filterPlot
  *        Updates plot category and subcategory filters,
@@ -354,6 +1644,7 @@ void BudgetTracker::drawPlot()
  */
 void BudgetTracker::filterPlot()
 {
+    m_comparisonCategories.clear();
     m_currentPlotCategory = ui->plotFilterCategoryLineEdit->text();
     m_currentPlotSubcategory = ui->plotFilterSubcategoryLineEdit->text();
     drawPlot();
@@ -363,7 +1654,8 @@ void BudgetTracker::filterPlot()
 /**
  * @brief BudgetTracker::verifyPlotFilter
  *        Enables plot filter button if category field is not empty,
- *        disables button if empty.
+ *        and compare button if compare field is not empty,
+ *        disables buttons if empty.
  *
  *        Connected to plot filter LineEdits textChanged signals.
  */
@@ -376,6 +1668,7 @@ void BudgetTracker::verifyPlotFilter()
     } else {
         ui->plotFilterFilterButton->setEnabled(false);
     }
+    ui->plotFilterCompareButton->setEnabled(!ui->plotFilterCompareLineEdit->text().trimmed().isEmpty());
 }
 
 /**
@@ -387,36 +1680,56 @@ void BudgetTracker::clearPlotFilter()
 {
     m_currentPlotCategory = "";
     m_currentPlotSubcategory = "";
+    m_comparisonCategories.clear();
     drawPlot();
     ui->plotFilterCategoryLineEdit->clear();
     ui->plotFilterSubcategoryLineEdit->clear();
+    ui->plotFilterCompareLineEdit->clear();
     ui->plotFilterClearButton->setEnabled(false);
     ui->plotFilterCategoryLineEdit->setFocus();
 }
 
+/**
+ * @brief BudgetTracker::comparePlot
+ *        Switches plot to comparison mode for the comma-separated
+ *        categories in the compare field, then redraws plot.
+ */
+void BudgetTracker::comparePlot()
+{
+    m_comparisonCategories.clear();
+    for (const QString &category : ui->plotFilterCompareLineEdit->text().split(',', Qt::SkipEmptyParts)) {
+        QString trimmed = category.trimmed();
+        if (!trimmed.isEmpty() && !m_comparisonCategories.contains(trimmed))
+            m_comparisonCategories.append(trimmed);
+    }
+    if (m_comparisonCategories.isEmpty())
+        return;
+
+    drawPlot();
+    ui->plotFilterClearButton->setEnabled(true);
+}
+
 /**
  * @brief BudgetTracker::addEntry
- *        Adds new entry to budget database, updating table and plot.
+ *        Adds new entry to journal as a pending operation.
+ *
+ *        Table model picks up the entry from the journal in place;
+ *        entry is only written to disk once pending entries are submitted.
  */
 void BudgetTracker::addEntry()
 {
-    QString date = ui->entryDateDateEdit->date().toString("yyyy/MM/dd");
-    QString category = ui->entryCategoryLineEdit->text();
-    QString subcategory = ui->entrySubcategoryLineEdit->text();
-    double amount = ui->entryAmountLineEdit->text().toDouble();
-
-    QSqlQuery query;
-    query.prepare("INSERT INTO budget "
-                  "(transactionID, date, category, subcategory, amount) "
-                  "VALUES (NULL, ?, ?, ?, ?)");
-    query.bindValue(0, date);
-    query.bindValue(1, category);
-    query.bindValue(2, subcategory);
-    query.bindValue(3, amount);
-    query.exec();
+    Transaction entry;
+    entry.accountID = ui->entryAccountComboBox->currentData().toLongLong();
+    entry.date = ui->entryDateDateEdit->date().toString("yyyy/MM/dd");
+    entry.category = ui->entryCategoryLineEdit->text();
+    entry.subcategory = ui->entrySubcategoryLineEdit->text();
+    entry.amount = ui->entryAmountLineEdit->text().toDouble();
+    entry.currency = ui->entryCurrencyLineEdit->text().trimmed().toUpper();
 
-    drawTable();
-    drawPlot();
+    if (!entryJournal->addEntry(entry)) {
+        QMessageBox::warning(this, "Add Failed", entryJournal->lastError());
+        return;
+    }
 
     ui->entryCategoryLineEdit->clear();
     ui->entrySubcategoryLineEdit->clear();
@@ -427,8 +1740,9 @@ void BudgetTracker::addEntry()
 
 /**
  * @brief BudgetTracker::verifyEntry
- *        Enables entry add button if category and subcategory are not empty
- *        and amount is not 0, disables button otherwise.
+ *        Enables entry add button if category and subcategory are not empty,
+ *        amount is not 0 and currency is a 3-letter code,
+ *        disables button otherwise.
  *
  *        Connected to entry LineEdits textChanged signals.
  */
@@ -437,8 +1751,9 @@ void BudgetTracker::verifyEntry()
     QString category = ui->entryCategoryLineEdit->text();
     QString subcategory = ui->entrySubcategoryLineEdit->text();
     double amount = ui->entryAmountLineEdit->text().toDouble();
+    QString currency = ui->entryCurrencyLineEdit->text().trimmed();
 
-    if (category != "" && subcategory != "" && amount != 0) {
+    if (category != "" && subcategory != "" && amount != 0 && currency.size() == 3) {
         ui->entryAddButton->setEnabled(true);
     } else {
         ui->entryAddButton->setEnabled(false);
@@ -447,11 +1762,178 @@ void BudgetTracker::verifyEntry()
 
 /**
  * @brief BudgetTracker::removeEntry
- *        Removes selected entry from database.
- *
- *        Stub.
+ *        Removes selected entries as pending operations.
  */
 void BudgetTracker::removeEntry()
 {
+    // collect IDs first, since each removal changes the journal state
+    QList<qint64> transactionIDs;
+    for (const QModelIndex &index : ui->transactionTableView->selectionModel()->selectedIndexes()) {
+        Transaction entry = transactionModel->entry(index.row());
+        // projected entries are removed by removing their recurring rule
+        if (entry.ruleID == 0 && !transactionIDs.contains(entry.transactionID))
+            transactionIDs.append(entry.transactionID);
+    }
 
+    for (qint64 transactionID : transactionIDs) {
+        if (!entryJournal->removeEntry(transactionID)) {
+            QMessageBox::warning(this, "Remove Failed", entryJournal->lastError());
+            break;
+        }
+    }
+}
+
+/**
+ * @brief BudgetTracker::verifyRemove
+ *        Enables entry remove button if any table cell is selected.
+ *
+ *        Connected to transactionTableView selectionChanged signal.
+ */
+void BudgetTracker::verifyRemove()
+{
+    ui->entryRemoveButton->setEnabled(ui->transactionTableView->selectionModel()->hasSelection());
+}
+
+/**
+ * @brief BudgetTracker::undoEntry
+ *        Undoes most recent pending operation.
+ */
+void BudgetTracker::undoEntry()
+{
+    if (!entryJournal->undo()) {
+        QMessageBox::warning(this, "Undo Failed", entryJournal->lastError());
+    }
+}
+
+/**
+ * @brief BudgetTracker::redoEntry
+ *        Redoes most recently undone operation.
+ */
+void BudgetTracker::redoEntry()
+{
+    if (!entryJournal->redo()) {
+        QMessageBox::warning(this, "Redo Failed", entryJournal->lastError());
+    }
+}
+
+/**
+ * @brief BudgetTracker::submitEntries
+ *        Commits all pending operations in one transaction.
+ *
+ *        Every window on the session redraws its plot once for the whole
+ *        batch, through the journal's submitted signal.
+ */
+void BudgetTracker::submitEntries()
+{
+    if (!entryJournal->submit())
+        QMessageBox::warning(this, "Submit Failed", entryJournal->lastError());
+}
+
+/**
+ * @brief BudgetTracker::updateJournalButtons
+ *        Enables undo/redo/submit buttons according to journal state,
+ *        and updates pending count in table title.
+ *
+ *        Connected to EntryJournal pendingCountChanged signal.
+ */
+void BudgetTracker::updateJournalButtons()
+{
+    ui->entryUndoButton->setEnabled(entryJournal->canUndo());
+    ui->entryRedoButton->setEnabled(entryJournal->canRedo());
+    ui->entrySubmitButton->setEnabled(entryJournal->pendingCount() > 0);
+    updateTableTitle();
+}
+
+/**
+ * @brief BudgetTracker::reportLogFailure
+ *        Warns that pending entries are no longer protected against crashes.
+ *
+ *        Connected to LedgerSession logFailed signal.
+ * @param error failure description
+ */
+void BudgetTracker::reportLogFailure(const QString &error)
+{
+    QMessageBox::warning(this, "Entry Log Failed",
+                         QString("Pending entries could not be logged and may be lost "
+                                 "if the program stops unexpectedly. Submit them to keep "
+                                 "them.\n\n%1").arg(error));
+}
+
+/**
+ * @brief BudgetTracker::reportRecovery
+ *        Reports entries replayed from the entry log when the session was
+ *        opened, or why the log is unavailable or was recreated.
+ */
+void BudgetTracker::reportRecovery()
+{
+    if (!session->logError().isEmpty())
+        QMessageBox::warning(this, "Entry Log Failed", session->logError());
+    if (session->recoveredCount() < 0) {
+        QMessageBox::warning(this, "Recovery Failed",
+                             QString("Unsubmitted entries could not all be recovered: %1")
+                                 .arg(entryJournal->lastError()));
+    } else if (session->recoveredCount() > 0) {
+        QMessageBox::information(this, "Entries Recovered",
+                                 QString("%1 unsubmitted change(s) from the last session were "
+                                         "recovered and are pending.")
+                                     .arg(session->recoveredCount()));
+    }
+}
+
+/**
+ * @brief BudgetTracker::updateCategoryCompleter
+ *        Reorders category and subcategory completers after category
+ *        counts changed.
+ *
+ *        Connected to LedgerSession categoriesChanged signal.
+ */
+void BudgetTracker::updateCategoryCompleter()
+{
+    categoryListModel->setStringList(session->categoryIndex()->categories());
+    updateSubcategoryCompleter();
+}
+
+/**
+ * @brief BudgetTracker::updateBudget
+ *        Redraws budget panel, alerting if category got closer to or over
+ *        its target.
+ *
+ *        Connected to LedgerSession budgetChanged signal.
+ * @param category category whose spending or target changed
+ * @param previous state of category before the change
+ */
+void BudgetTracker::updateBudget(const QString &category, BudgetStatus::State previous)
+{
+    alertBudget(category, previous);
+    drawBudget();
+}
+
+/**
+ * @brief BudgetTracker::redraw
+ *        Redraws table and plot, e.g. after recurring rules changed.
+ *
+ *        Connected to LedgerSession scheduleChanged signal.
+ */
+void BudgetTracker::redraw()
+{
+    drawTable();
+    drawPlot();
+}
+
+/**
+ * @brief BudgetTracker::requestNewWindow
+ *        Asks for another window on this session, e.g. for other filters.
+ */
+void BudgetTracker::requestNewWindow()
+{
+    emit newWindowRequested(session);
+}
+
+/**
+ * @brief BudgetTracker::requestSwitchUser
+ *        Asks to log in as another user in place of this window.
+ */
+void BudgetTracker::requestSwitchUser()
+{
+    emit switchUserRequested(this);
 }
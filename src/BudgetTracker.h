@@ -1,9 +1,17 @@
 #pragma once
 
-#include "User.h"
+#include "BudgetTableModel.h"
+#include "ColumnSizer.h"
+#include "LedgerExporter.h"
+#include "LedgerSession.h"
+#include "ReportGenerator.h"
+#include "qcustomplot.h"
 
+#include <QCompleter>
+#include <QProgressDialog>
 #include <QWidget>
-#include <QSqlQueryModel>
+#include <QStringListModel>
+#include <QTimer>
 
 namespace Ui {
 class BudgetTracker;
@@ -14,7 +22,8 @@ class BudgetTracker;
  *
  *        Shows plot and table of user transactions, allowing
  *        for manipulation of transaction data and plot/table
- *        filtration.
+ *        filtration. Several windows can be open on one user's
+ *        LedgerSession, each with its own filters.
  */
 class BudgetTracker : public QWidget
 {
@@ -22,41 +31,137 @@ class BudgetTracker : public QWidget
 
 public:
     // constructors
-    explicit BudgetTracker(std::shared_ptr<User> user,
+    explicit BudgetTracker(LedgerSession *session,
                            QWidget *parent = nullptr);
     // destructors
     ~BudgetTracker();
 
+signals:
+    void newWindowRequested(LedgerSession *session);
+    void switchUserRequested(QWidget *window);
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
 private slots:
     // entry-related slots
     void addEntry();
     void verifyEntry();
     void removeEntry();
+    void verifyRemove();
+    void updateSubcategoryCompleter();
+    void editRecurring();
+    void addAccount();
+
+    // currency-related slots
+    void changeDisplayCurrency(const QString &currency);
+    void importRates();
+
+    // budget-related slots
+    void setBudgetTarget();
+    void removeBudgetTarget();
+    void verifyBudgetRemove();
+
+    // journal-related slots
+    void undoEntry();
+    void redoEntry();
+    void submitEntries();
+    void updateJournalButtons();
+    void reportLogFailure(const QString &error);
+
+    // session-related slots
+    void updateCategoryCompleter();
+    void updateBudget(const QString &category, BudgetStatus::State previous);
+    void applyRates();
+    void applyImport();
+    void initializeAccounts();
+    void redraw();
+    void requestNewWindow();
+    void requestSwitchUser();
+    void finishStartup();
 
     // table-related slots
     void filterTable();
     void verifyTableFilter();
     void clearTableFilter();
+    void changeTableAccount(int index);
+    void finishTableLoading();
+    void importTable();
+    void exportTable();
+    void showExportProgress(qint64 rows);
+    void finishExport(qint64 rows, const QString &error);
+    void generateReport();
+    void showReportProgress(int pages);
+    void finishReport(int pages, const QString &error);
 
     // plot-related slots
     void filterPlot();
     void verifyPlotFilter();
     void clearPlotFilter();
+    void comparePlot();
+    void extendProjection(const QCPRange &range);
+    void trackHover(QMouseEvent *event);
+    void setPlotSelectionMode(QMouseEvent *event);
+    void selectPlotFromTable();
+    void selectTableFromPlot();
+    void showHover();
+    void drawForecast(const QString &category, const QString &subcategory,
+                      const QVector<double> &keys, const QVector<double> &balances);
 
 private:
     Ui::BudgetTracker *ui;
-    QSqlQueryModel *transactionModel;       // model for transactionTableView
-    std::shared_ptr<User> m_user;           // current user
+    LedgerSession *session;                 // shared ledger, journal and caches of the user
+    BudgetTableModel *transactionModel;     // model for transactionTableView
+    ColumnSizer *columnSizer;               // sizes transactionTableView columns from sampled rows
+    LedgerExporter *ledgerExporter;         // streams table filter to files off the GUI thread
+    QProgressDialog *exportProgress;        // shows rows written by ledgerExporter
+    ReportGenerator *reportGenerator;       // renders PDF/print reports off the GUI thread
+    QProgressDialog *reportProgress;        // shows pages rendered by reportGenerator
+    EntryJournal *entryJournal;             // session's pending (unsubmitted) entry operations
+    QCPBars *transactionBars;               // daily net of stored transactions in transactionPlot
+    QCPBars *projectedBars;                 // daily net of projected recurring transactions
+    QCPGraph *balanceGraph;                 // running balance line in transactionPlot
+    QCPGraph *forecastGraph;                // projected balance curve in transactionPlot
+    QCPGraph *anomalyGraph;                 // unusual entries marked at their own amount
+    QVector<QCPGraph*> comparisonGraphs;    // running total per compared category
+    BalanceForecaster *balanceForecaster;   // session's forecaster, computes forecastGraph data off the GUI thread
+    QCPItemTracer *hoverTracer;             // marks hovered day on balanceGraph
+    QCPItemText *hoverLabel;                // date/amount/balance of hovered day
+    QTimer *hoverTimer;                     // throttles hover repaints
+    QCompleter *categoryCompleter;          // completer for entryCategoryLineEdit
+    QCompleter *subcategoryCompleter;       // completer for entrySubcategoryLineEdit
+    QStringListModel *categoryListModel;    // ranked categories for categoryCompleter
+    QStringListModel *subcategoryListModel; // ranked subcategories for subcategoryCompleter
+    QDate m_projectedUntil;                 // last date projected entries are plotted for
+    double m_plotBalance = 0;               // balance at m_projectedUntil, for extending balanceGraph
+    QVector<double> m_hoverKeys;            // sorted plot keys of plotted days
+    QVector<double> m_hoverAmounts;         // net amount per plotted day
+    QVector<double> m_hoverBalances;        // balance per plotted day
+    QPoint m_hoverPos;                      // last cursor position over transactionPlot
+    bool m_hoverDragging = false;           // whether a mouse button was held at m_hoverPos
+    bool m_syncingSelection = false;        // guards table/plot selection feedback
+    bool m_painted = false;                 // whether the window has been painted yet
 
     QString m_currentPlotCategory = "";     // current plot category filter string
     QString m_currentPlotSubcategory = "";  // current plot subcategory filter string
     QString m_currentTableCategory = "";    // current table category filter string
     QString m_currentTableSubcategory = ""; // current table subcategory filter string
+    qint64 m_currentTableAccountID = 0;     // current table account; 0 for all accounts
+    QStringList m_comparisonCategories;     // compared plot categories; empty outside comparison mode
 
     // non-slot functions
-    void setupDatabase(const std::shared_ptr<const User> user);
+    void initializeCompleters();
+    void initializeCurrencies();
+    void reportRecovery();
+    void drawBudget();
+    void alertBudget(const QString &category, BudgetStatus::State previous);
     void initializeTable();
     void drawTable();
+    void fitTableColumns();
+    void updateTableTitle();
     void initializePlot();
     void drawPlot();
+    void drawComparison();
+    void clearComparison();
 };
@@ -0,0 +1,130 @@
+#include "CategoryIndex.h"
+
+#include <QSqlQuery>
+
+#include <algorithm>
+
+/**
+ * @brief CategoryIndex::CategoryIndex
+ *        Default constructor. Index is empty until load() is called.
+ */
+CategoryIndex::CategoryIndex() {}
+
+/**
+ * @brief CategoryIndex::load
+ *        Rebuilds index from budget table with one grouped query.
+ * @param database open user database
+ */
+void CategoryIndex::load(const QSqlDatabase &database)
+{
+    m_categoryCounts.clear();
+    m_subcategoryCounts.clear();
+
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    query.exec("SELECT category, subcategory, COUNT(*) "
+               "FROM budget "
+               "GROUP BY category, subcategory");
+    while (query.next()) {
+        QString category = query.value(0).toString();
+        QString subcategory = query.value(1).toString();
+        int count = query.value(2).toInt();
+        m_categoryCounts[category] += count;
+        m_subcategoryCounts[category][subcategory] += count;
+    }
+}
+
+/**
+ * @brief CategoryIndex::addEntry
+ *        Counts one new entry towards its category and subcategory.
+ * @param category entry category
+ * @param subcategory entry subcategory
+ */
+void CategoryIndex::addEntry(const QString &category, const QString &subcategory)
+{
+    ++m_categoryCounts[category];
+    ++m_subcategoryCounts[category][subcategory];
+}
+
+/**
+ * @brief CategoryIndex::removeEntry
+ *        Uncounts one entry, dropping categories/subcategories that reach zero.
+ * @param category entry category
+ * @param subcategory entry subcategory
+ */
+void CategoryIndex::removeEntry(const QString &category, const QString &subcategory)
+{
+    auto categoryIt = m_categoryCounts.find(category);
+    if (categoryIt == m_categoryCounts.end())
+        return;
+    if (--categoryIt.value() <= 0)
+        m_categoryCounts.erase(categoryIt);
+
+    auto subcategoriesIt = m_subcategoryCounts.find(category);
+    if (subcategoriesIt == m_subcategoryCounts.end())
+        return;
+    auto subcategoryIt = subcategoriesIt->find(subcategory);
+    if (subcategoryIt != subcategoriesIt->end() && --subcategoryIt.value() <= 0)
+        subcategoriesIt->erase(subcategoryIt);
+    if (subcategoriesIt->isEmpty())
+        m_subcategoryCounts.erase(subcategoriesIt);
+}
+
+/**
+ * @brief CategoryIndex::categories
+ *        Categories ordered by descending entry count.
+ * @return ranked category list
+ */
+QStringList CategoryIndex::categories() const
+{
+    return ranked(m_categoryCounts);
+}
+
+/**
+ * @brief CategoryIndex::subcategories
+ *        Subcategories of category ordered by descending entry count.
+ *
+ *        Falls back to a case-insensitive category match, so completion
+ *        still works while the category field is not yet normalized.
+ * @param category category to look up
+ * @return ranked subcategory list; empty if category is unknown
+ */
+QStringList CategoryIndex::subcategories(const QString &category) const
+{
+    auto it = m_subcategoryCounts.constFind(category);
+    if (it != m_subcategoryCounts.constEnd())
+        return ranked(it.value());
+
+    for (it = m_subcategoryCounts.constBegin(); it != m_subcategoryCounts.constEnd(); ++it) {
+        if (it.key().compare(category, Qt::CaseInsensitive) == 0)
+            return ranked(it.value());
+    }
+    return QStringList();
+}
+
+/**
+ * @brief CategoryIndex::ranked
+ *        Sorts keys by descending count, ties broken alphabetically.
+ * @param counts key to count map
+ * @return ranked key list
+ */
+QStringList CategoryIndex::ranked(const QHash<QString, int> &counts)
+{
+    QList<std::pair<int, QString>> entries;
+    entries.reserve(counts.size());
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+        entries.append({it.value(), it.key()});
+
+    std::sort(entries.begin(), entries.end(),
+              [](const std::pair<int, QString> &a, const std::pair<int, QString> &b) {
+                  if (a.first != b.first)
+                      return a.first > b.first;
+                  return a.second < b.second;
+              });
+
+    QStringList keys;
+    keys.reserve(entries.size());
+    for (const auto &entry : entries)
+        keys.append(entry.second);
+    return keys;
+}
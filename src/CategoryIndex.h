@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QHash>
+#include <QSqlDatabase>
+#include <QStringList>
+
+/**
+ * @brief The CategoryIndex class
+ *        In-memory, frequency-ranked index of categories and subcategories.
+ *
+ *        Loaded once from the budget table with a single grouped query,
+ *        then kept up to date incrementally as entries are added or removed,
+ *        so completers never have to query the database while typing.
+ */
+class CategoryIndex {
+public:
+    // constructor
+    CategoryIndex();
+
+    // loading and incremental updates
+    void load(const QSqlDatabase &database);
+    void addEntry(const QString &category, const QString &subcategory);
+    void removeEntry(const QString &category, const QString &subcategory);
+
+    // ranked lookups
+    QStringList categories() const;
+    QStringList subcategories(const QString &category) const;
+
+private:
+    QHash<QString, int> m_categoryCounts;                       // entries per category
+    QHash<QString, QHash<QString, int>> m_subcategoryCounts;    // entries per subcategory, keyed by category
+
+    static QStringList ranked(const QHash<QString, int> &counts);
+};
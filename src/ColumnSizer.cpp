@@ -0,0 +1,168 @@
+#include "ColumnSizer.h"
+
+#include <QHeaderView>
+#include <QStyle>
+
+#include <algorithm>
+
+/**
+ * @brief ColumnSizer::ColumnSizer
+ *        Follows row insertions and edits of the view's model.
+ * @param view table view to size; its model must be set
+ * @param parent pointer to QObject parent object
+ */
+ColumnSizer::ColumnSizer(QTableView *view, QObject *parent)
+    : QObject(parent)
+    , view(view)
+{
+    connect(view->model(), &QAbstractItemModel::rowsInserted,
+            this, &ColumnSizer::measureInserted);
+    connect(view->model(), &QAbstractItemModel::dataChanged,
+            this, &ColumnSizer::measureChanged);
+}
+
+/**
+ * @brief ColumnSizer::setFormat
+ *        Sizes column from its widest possible text instead of its rows.
+ * @param column model column
+ * @param widestText text at least as wide as any value of the column
+ */
+void ColumnSizer::setFormat(int column, const QString &widestText)
+{
+    m_formatWidths.insert(column, formatWidth(widestText));
+}
+
+/**
+ * @brief ColumnSizer::fit
+ *        Applies widths of layout, estimating them on first use.
+ * @param layout key of the current filter and visible columns
+ */
+void ColumnSizer::fit(const QString &layout)
+{
+    m_layout = layout;
+    auto it = m_widths.find(layout);
+    if (it == m_widths.end()) {
+        QVector<int> widths(view->model()->columnCount(), 0);
+        int rows = view->model()->rowCount();
+        for (int column = 0; column < widths.size(); ++column) {
+            if (!isSized(column))
+                continue;
+            int width = view->horizontalHeader()->sectionSizeHint(column);
+            if (m_formatWidths.contains(column))
+                width = std::max(width, m_formatWidths.value(column));
+            else if (rows > 0)
+                width = std::max(width, measureRows(0, rows - 1, column, SampleRows));
+            widths[column] = width;
+        }
+        it = m_widths.insert(layout, widths);
+    }
+
+    for (int column = 0; column < it->size(); ++column) {
+        if (isSized(column) && it->at(column) > 0)
+            view->horizontalHeader()->resizeSection(column, it->at(column));
+    }
+}
+
+/**
+ * @brief ColumnSizer::measureInserted
+ *        Widens columns for inserted rows that would not fit.
+ *
+ *        Connected to model rowsInserted signal.
+ */
+void ColumnSizer::measureInserted(const QModelIndex &parent, int first, int last)
+{
+    if (!parent.isValid())
+        widen(first, last, 0, view->model()->columnCount() - 1);
+}
+
+/**
+ * @brief ColumnSizer::measureChanged
+ *        Widens columns for edited cells that would not fit.
+ *
+ *        Connected to model dataChanged signal.
+ */
+void ColumnSizer::measureChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    widen(topLeft.row(), bottomRight.row(), topLeft.column(), bottomRight.column());
+}
+
+/**
+ * @brief ColumnSizer::isSized
+ * @param column model column
+ * @return true if column is visible and not the stretched last section
+ */
+bool ColumnSizer::isSized(int column) const
+{
+    if (view->isColumnHidden(column))
+        return false;
+    QHeaderView *header = view->horizontalHeader();
+    if (!header->stretchLastSection())
+        return true;
+    return header->logicalIndex(header->count() - 1 - header->hiddenSectionCount()) != column;
+}
+
+/**
+ * @brief ColumnSizer::formatWidth
+ * @param text cell text
+ * @return width of a cell showing text, including the style's text margins
+ */
+int ColumnSizer::formatWidth(const QString &text) const
+{
+    int margin = view->style()->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, view) + 1;
+    return view->fontMetrics().horizontalAdvance(text) + 2 * margin;
+}
+
+/**
+ * @brief ColumnSizer::measureRows
+ *        Measures widest cell of column among sampled rows.
+ *
+ *        Short ranges are measured completely. Longer ones measure their
+ *        first rows, which are the ones shown first, and then rows at an
+ *        even stride over the rest.
+ * @param first first row of range
+ * @param last last row of range
+ * @param column model column
+ * @param samples number of rows to measure at most
+ * @return widest cell width
+ */
+int ColumnSizer::measureRows(int first, int last, int column, int samples) const
+{
+    QAbstractItemModel *model = view->model();
+    int head = std::min(last - first + 1, samples / 2);
+    int width = 0;
+    for (int row = first; row < first + head; ++row)
+        width = std::max(width, view->sizeHintForIndex(model->index(row, column)).width());
+
+    int rest = last - (first + head) + 1;
+    if (rest <= 0)
+        return width;
+    int stride = std::max(1, rest / (samples - head));
+    for (int row = first + head; row <= last; row += stride)
+        width = std::max(width, view->sizeHintForIndex(model->index(row, column)).width());
+    return width;
+}
+
+/**
+ * @brief ColumnSizer::widen
+ *        Samples a changed block of cells and widens columns whose cached
+ *        width is exceeded. Columns never shrink until the layout changes.
+ * @param first first changed row
+ * @param last last changed row
+ * @param firstColumn first changed column
+ * @param lastColumn last changed column
+ */
+void ColumnSizer::widen(int first, int last, int firstColumn, int lastColumn)
+{
+    auto it = m_widths.find(m_layout);
+    if (it == m_widths.end())
+        return;
+    for (int column = firstColumn; column <= lastColumn && column < it->size(); ++column) {
+        if (!isSized(column) || m_formatWidths.contains(column))
+            continue;
+        int width = measureRows(first, last, column, SampleRows);
+        if (width > it->at(column)) {
+            (*it)[column] = width;
+            view->horizontalHeader()->resizeSection(column, width);
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QTableView>
+#include <QVector>
+
+/**
+ * @brief The ColumnSizer class
+ *        Sizes table view columns from a sample of rows instead of
+ *        measuring every row.
+ *
+ *        Columns with a known text format (e.g. dates) are sized from the
+ *        format alone; other columns from the header and a sample of rows:
+ *        the first page, then rows at an even stride. Widths are cached per
+ *        layout key (filter, account, visible columns), so returning to a
+ *        layout costs nothing. Rows inserted or edited later are sampled the
+ *        same way and only ever widen a column. The last visible column is
+ *        left to stretch.
+ */
+class ColumnSizer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int SampleRows = 256;      // rows measured per fit or inserted range
+
+    // constructor
+    explicit ColumnSizer(QTableView *view, QObject *parent = nullptr);
+
+    // sizing
+    void setFormat(int column, const QString &widestText);
+    void fit(const QString &layout);
+
+private slots:
+    void measureInserted(const QModelIndex &parent, int first, int last);
+    void measureChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+private:
+    QTableView *view;
+    QString m_layout;                           // layout key of the current widths
+    QHash<QString, QVector<int>> m_widths;      // column widths by layout key
+    QHash<int, int> m_formatWidths;             // width of fixed-format columns
+
+    bool isSized(int column) const;
+    int formatWidth(const QString &text) const;
+    int measureRows(int first, int last, int column, int samples) const;
+    void widen(int first, int last, int firstColumn, int lastColumn);
+};
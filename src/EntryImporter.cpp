@@ -0,0 +1,304 @@
+#include "EntryImporter.h"
+#include "ExchangeRates.h"
+
+#include <QDate>
+#include <QFile>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTextStream>
+
+namespace {
+const quint64 FnvOffset = 0xcbf29ce484222325ULL;    // FNV-1a 64-bit basis
+const quint64 FnvPrime = 0x100000001b3ULL;          // FNV-1a 64-bit prime
+
+/**
+ * @brief splitCsvLine
+ * @param line one CSV line
+ * @return fields of line, unquoted as RFC 4180 requires
+ */
+QStringList splitCsvLine(const QString &line)
+{
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    for (int i = 0; i < line.size(); ++i) {
+        QChar c = line.at(i);
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line.at(i + 1) == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.append(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.append(field);
+    return fields;
+}
+}
+
+/**
+ * @brief EntryImporter::importFile
+ *        Stores the entries of a CSV file that are not in the ledger yet.
+ *
+ *        The first line names the columns, in any order: date, category
+ *        and amount are required; subcategory (or memo, description),
+ *        currency and account are optional. A CSV export of this program
+ *        can be imported as is. Lines that do not parse are skipped.
+ *
+ *        Duplicates are removed and the rest inserted in one immediate
+ *        transaction, so no other connection can store the same entries
+ *        in between. Reload the ledger indexes afterwards.
+ * @param database open user database, without a transaction in progress
+ * @param path CSV file path
+ * @param accounts accounts to resolve account names with
+ * @param accountID account of entries without a known account name
+ * @return counts of imported, duplicate and skipped entries
+ */
+ImportResult EntryImporter::importFile(QSqlDatabase &database, const QString &path,
+                                       const AccountList &accounts, qint64 accountID)
+{
+    ImportResult result;
+    QVector<Transaction> entries = readFile(path, accounts, accountID, &result);
+    if (!result.error.isEmpty())
+        return result;
+
+    QSqlQuery query(database);
+    if (!query.exec("BEGIN IMMEDIATE")) {
+        result.error = query.lastError().text();
+        return result;
+    }
+    QVector<qint64> fingerprints;
+    if (!removeDuplicates(database, entries, fingerprints, &result)) {
+        database.rollback();
+        return result;
+    }
+
+    query.prepare("INSERT INTO budget "
+                  "(date, category, subcategory, amount, currency, accountID, fingerprint) "
+                  "VALUES (?, ?, ?, ?, ?, ?, ?)");
+    for (int i = 0; i < entries.size(); ++i) {
+        const Transaction &entry = entries.at(i);
+        query.bindValue(0, entry.date);
+        query.bindValue(1, entry.category);
+        query.bindValue(2, entry.subcategory);
+        query.bindValue(3, entry.amount);
+        query.bindValue(4, entry.currency);
+        query.bindValue(5, entry.accountID);
+        query.bindValue(6, fingerprints.at(i));
+        if (!query.exec()) {
+            result.error = query.lastError().text();
+            database.rollback();
+            return result;
+        }
+    }
+
+    if (!database.commit()) {
+        result.error = database.lastError().text();
+        database.rollback();
+        return result;
+    }
+    result.imported = entries.size();
+    return result;
+}
+
+/**
+ * @brief EntryImporter::fingerprint
+ *        FNV-1a hash identifying an entry independently of its transactionID.
+ *
+ *        Amounts are compared in cents and texts after normalize(), so
+ *        formatting differences between exports do not hide duplicates.
+ *        The hash is stored, so it must not change between versions.
+ * @param entry entry to fingerprint
+ * @return 64-bit fingerprint
+ */
+qint64 EntryImporter::fingerprint(const Transaction &entry)
+{
+    QByteArray key = entry.date.toUtf8() + '\x1f'
+                     + QByteArray::number(qRound64(entry.amount * 100)) + '\x1f'
+                     + entry.currency.toUpper().toUtf8() + '\x1f'
+                     + QByteArray::number(entry.accountID) + '\x1f'
+                     + normalize(entry.category).toUtf8() + '\x1f'
+                     + normalize(entry.subcategory).toUtf8();
+    quint64 hash = FnvOffset;
+    for (char c : key) {
+        hash ^= quint8(c);
+        hash *= FnvPrime;
+    }
+    return qint64(hash);
+}
+
+/**
+ * @brief EntryImporter::readFile
+ *        Parses entries of a CSV file.
+ * @param path CSV file path
+ * @param accounts accounts to resolve account names with
+ * @param accountID account of entries without a known account name
+ * @param result receives skipped line count, or error if file cannot be read
+ * @return parsed entries, in file order
+ */
+QVector<Transaction> EntryImporter::readFile(const QString &path, const AccountList &accounts,
+                                             qint64 accountID, ImportResult *result)
+{
+    QVector<Transaction> entries;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        result->error = file.errorString();
+        return entries;
+    }
+    QTextStream stream(&file);
+
+    QStringList header = splitCsvLine(stream.readLine());
+    for (QString &name : header)
+        name = name.trimmed().toLower();
+    int dateColumn = header.indexOf("date");
+    int categoryColumn = header.indexOf("category");
+    int subcategoryColumn = header.indexOf("subcategory");
+    if (subcategoryColumn < 0)
+        subcategoryColumn = header.indexOf("memo");
+    if (subcategoryColumn < 0)
+        subcategoryColumn = header.indexOf("description");
+    int amountColumn = header.indexOf("amount");
+    int currencyColumn = header.indexOf("currency");
+    int accountColumn = header.indexOf("account");
+    if (dateColumn < 0 || categoryColumn < 0 || amountColumn < 0) {
+        result->error = "The first line must name the date, category and amount columns.";
+        return entries;
+    }
+
+    const QString homeCurrency = ExchangeRates::homeCurrency();
+    while (!stream.atEnd()) {
+        QString line = stream.readLine();
+        if (line.trimmed().isEmpty())
+            continue;
+        QStringList fields = splitCsvLine(line);
+        QString dateField = fields.value(dateColumn).trimmed();
+        QDate date = QDate::fromString(dateField, "yyyy/MM/dd");
+        if (!date.isValid())
+            date = QDate::fromString(dateField, Qt::ISODate);
+        bool ok = false;
+        double amount = fields.value(amountColumn).trimmed().toDouble(&ok);
+        QString category = fields.value(categoryColumn).trimmed();
+        if (!date.isValid() || !ok || category.isEmpty()) {
+            ++result->skipped;
+            continue;
+        }
+
+        Transaction entry;
+        entry.date = date.toString("yyyy/MM/dd");
+        entry.category = category;
+        entry.subcategory = fields.value(subcategoryColumn).trimmed();
+        entry.amount = amount;
+        entry.currency = fields.value(currencyColumn).trimmed().toUpper();
+        if (entry.currency.size() != 3)
+            entry.currency = homeCurrency;
+        entry.accountID = accounts.accountID(fields.value(accountColumn).trimmed());
+        if (entry.accountID == 0)
+            entry.accountID = accountID;
+        entries.append(entry);
+    }
+    return entries;
+}
+
+/**
+ * @brief EntryImporter::removeDuplicates
+ *        Drops entries already stored in the ledger.
+ *
+ *        The file's distinct fingerprints are counted in the ledger
+ *        index, and each stored copy cancels one file entry. The cost
+ *        grows with the file, not with the ledger.
+ * @param database open user database, in the import transaction
+ * @param entries entries to check; left with new entries only
+ * @param fingerprints receives fingerprint of each remaining entry
+ * @param result receives duplicate count, or error
+ * @return true on success
+ */
+bool EntryImporter::removeDuplicates(QSqlDatabase &database, QVector<Transaction> &entries,
+                                     QVector<qint64> &fingerprints, ImportResult *result)
+{
+    QVector<qint64> all;
+    all.reserve(entries.size());
+    QVector<qint64> distinct;
+    QSet<qint64> seen;
+    for (const Transaction &entry : entries) {
+        qint64 hash = fingerprint(entry);
+        all.append(hash);
+        if (!seen.contains(hash)) {
+            seen.insert(hash);
+            distinct.append(hash);
+        }
+    }
+
+    QHash<qint64, int> counts;
+    for (int first = 0; first < distinct.size(); first += LookupBatch) {
+        if (!countStored(database, distinct.mid(first, LookupBatch), &counts, &result->error))
+            return false;
+    }
+
+    QVector<Transaction> fresh;
+    fresh.reserve(entries.size());
+    fingerprints.clear();
+    fingerprints.reserve(entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        auto it = counts.find(all.at(i));
+        if (it != counts.end() && it.value() > 0) {
+            --it.value();
+            ++result->duplicates;
+        } else {
+            fresh.append(entries.at(i));
+            fingerprints.append(all.at(i));
+        }
+    }
+    entries = fresh;
+    return true;
+}
+
+/**
+ * @brief EntryImporter::countStored
+ *        Counts stored entries of each fingerprint with one index lookup.
+ * @param database open user database
+ * @param fingerprints distinct fingerprints to look up, at most LookupBatch
+ * @param counts receives stored entry count per fingerprint found
+ * @param error receives error message on failure
+ * @return true on success
+ */
+bool EntryImporter::countStored(QSqlDatabase &database, const QVector<qint64> &fingerprints,
+                                QHash<qint64, int> *counts, QString *error)
+{
+    QStringList placeholders(fingerprints.size(), "?");
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT fingerprint, COUNT(*) "
+                          "FROM budget "
+                          "WHERE fingerprint IN (%1) "
+                          "GROUP BY fingerprint").arg(placeholders.join(", ")));
+    for (int i = 0; i < fingerprints.size(); ++i)
+        query.bindValue(i, fingerprints.at(i));
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+    while (query.next())
+        counts->insert(query.value(0).toLongLong(), query.value(1).toInt());
+    return true;
+}
+
+/**
+ * @brief EntryImporter::normalize
+ * @param text category or memo
+ * @return text with whitespace collapsed and case folded
+ */
+QString EntryImporter::normalize(const QString &text)
+{
+    return text.simplified().toCaseFolded();
+}
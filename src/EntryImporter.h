@@ -0,0 +1,56 @@
+#pragma once
+
+#include "AccountList.h"
+#include "Transaction.h"
+
+#include <QHash>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The ImportResult struct
+ *        Outcome of one entry import.
+ */
+struct ImportResult {
+    int imported = 0;       // entries stored
+    int duplicates = 0;     // entries already in the ledger, not stored again
+    int skipped = 0;        // lines that did not parse
+    QString error;          // empty on success
+};
+
+/**
+ * @brief The EntryImporter class
+ *        Imports entries from CSV bank exports without storing any twice.
+ *
+ *        Every budget row carries a fingerprint: a stable 64-bit hash of
+ *        its date, amount, currency, account and normalized category and
+ *        subcategory (the memo of a bank line), indexed by budget_fingerprint.
+ *        An import counts its distinct fingerprints in that index, in
+ *        batches of LookupBatch, so it never scans the whole ledger.
+ *        Identical entries are counted, not just matched, so two equal
+ *        purchases on the same day are kept apart: a file entry is a
+ *        duplicate only while the ledger has more copies of it than were
+ *        already matched.
+ */
+class EntryImporter
+{
+public:
+    static const int LookupBatch = 500;     // fingerprints per index lookup, below SQLite's variable limit
+
+    // importing
+    static ImportResult importFile(QSqlDatabase &database, const QString &path,
+                                   const AccountList &accounts, qint64 accountID);
+
+    // fingerprints
+    static qint64 fingerprint(const Transaction &entry);
+
+private:
+    static QVector<Transaction> readFile(const QString &path, const AccountList &accounts,
+                                         qint64 accountID, ImportResult *result);
+    static bool removeDuplicates(QSqlDatabase &database, QVector<Transaction> &entries,
+                                 QVector<qint64> &fingerprints, ImportResult *result);
+    static bool countStored(QSqlDatabase &database, const QVector<qint64> &fingerprints,
+                            QHash<qint64, int> *counts, QString *error);
+    static QString normalize(const QString &text);
+};
@@ -0,0 +1,616 @@
+#include "EntryJournal.h"
+#include "EntryImporter.h"
+
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+
+#include <algorithm>
+
+/**
+ * @brief EntryJournal::EntryJournal
+ *        Creates empty journal on database connection.
+ * @param database open user database
+ * @param parent pointer to QObject parent object
+ */
+EntryJournal::EntryJournal(const QSqlDatabase &database, QObject *parent)
+    : QObject(parent)
+    , m_database(database)
+{
+}
+
+/**
+ * @brief EntryJournal::setLog
+ *        Attaches durable log that pending operations are written to.
+ * @param log open entry log
+ */
+void EntryJournal::setLog(EntryLog *log)
+{
+    m_log = log;
+    connect(m_log, &EntryLog::synced, this, &EntryJournal::logSynced);
+}
+
+/**
+ * @brief EntryJournal::replay
+ *        Reapplies operations logged before an unclean shutdown.
+ *
+ *        Logged batches the ledger has already committed are dropped.
+ *        Replayed operations become pending again, in their original
+ *        undo/redo order, and emit the usual change signals.
+ * @return number of pending operations afterwards; -1 if replay failed
+ */
+int EntryJournal::replay()
+{
+    if (!m_log)
+        return 0;
+
+    qint64 committedBatch = 0;
+    QSqlQuery query(m_database);
+    if (query.exec("SELECT batch "
+                   "FROM log_batch "
+                   "WHERE id = 1") && query.next()) {
+        committedBatch = query.value(0).toLongLong();
+    }
+    query.finish();
+
+    if (m_log->batch() <= committedBatch) {
+        m_log->reset(committedBatch + 1);
+        return 0;
+    }
+
+    m_replaying = true;
+    bool replayed = true;
+    for (const EntryLog::Record &record : m_log->records(committedBatch)) {
+        switch (record.action) {
+        case EntryLog::Record::Apply:
+            apply(Operation{static_cast<Operation::Type>(record.operation),
+                            record.before, record.after}, EntryLog::Record::Apply);
+            break;
+        case EntryLog::Record::Undo:
+            replayed = undo();
+            break;
+        case EntryLog::Record::Redo:
+            replayed = redo();
+            break;
+        }
+        if (!replayed)
+            break;
+    }
+    m_replaying = false;
+    return replayed ? pendingCount() : -1;
+}
+
+/**
+ * @brief EntryJournal::addEntry
+ *        Journals insertion of new entry.
+ * @param entry entry to insert; a provisional transactionID is assigned if 0
+ * @return true if entry was applied
+ */
+bool EntryJournal::addEntry(const Transaction &entry)
+{
+    Operation operation{Operation::Add, Transaction(), entry};
+    if (operation.after.transactionID == 0)
+        operation.after.transactionID = provisionalID();
+    apply(operation, EntryLog::Record::Apply);
+    return true;
+}
+
+/**
+ * @brief EntryJournal::editEntry
+ *        Journals update of existing entry.
+ * @param before entry as currently shown, pending or stored
+ * @param after new entry values (same transactionID)
+ * @return true if edit was applied
+ */
+bool EntryJournal::editEntry(const Transaction &before, const Transaction &after)
+{
+    apply(Operation{Operation::Edit, before, after}, EntryLog::Record::Apply);
+    return true;
+}
+
+/**
+ * @brief EntryJournal::removeEntry
+ *        Journals removal of existing entry.
+ *
+ *        Looks up the entry's current values first, pending or stored, so
+ *        the removal can be undone.
+ * @param transactionID ID of entry to remove
+ * @return true if entry was found and removed
+ */
+bool EntryJournal::removeEntry(qint64 transactionID)
+{
+    if (m_pending.contains(transactionID)) {
+        apply(Operation{Operation::Remove, m_pending.value(transactionID), Transaction()},
+              EntryLog::Record::Apply);
+        return true;
+    }
+    if (m_replaced.contains(transactionID)) {
+        m_lastError = QString("Entry %1 not found").arg(transactionID);
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    query.prepare("SELECT date, category, subcategory, amount, currency, accountID "
+                  "FROM budget "
+                  "WHERE transactionID = ?");
+    query.bindValue(0, transactionID);
+    if (!query.exec() || !query.next()) {
+        m_lastError = QString("Entry %1 not found").arg(transactionID);
+        return false;
+    }
+
+    Transaction entry;
+    entry.transactionID = transactionID;
+    entry.date = query.value(0).toString();
+    entry.category = query.value(1).toString();
+    entry.subcategory = query.value(2).toString();
+    entry.amount = query.value(3).toDouble();
+    entry.currency = query.value(4).toString();
+    entry.accountID = query.value(5).toLongLong();
+    query.finish();
+
+    apply(Operation{Operation::Remove, entry, Transaction()}, EntryLog::Record::Apply);
+    return true;
+}
+
+/**
+ * @brief EntryJournal::undo
+ *        Takes back most recent pending operation.
+ * @return true if an operation was undone
+ */
+bool EntryJournal::undo()
+{
+    if (m_undoStack.isEmpty())
+        return false;
+
+    Operation operation = m_undoStack.takeLast();
+    m_redoStack.append(operation);
+    updatePending();
+    log(EntryLog::Record::Undo, operation);
+
+    emitReverted(operation);
+    emit pendingCountChanged(pendingCount());
+    return true;
+}
+
+/**
+ * @brief EntryJournal::redo
+ *        Reapplies most recently undone operation.
+ * @return true if an operation was redone
+ */
+bool EntryJournal::redo()
+{
+    if (m_redoStack.isEmpty())
+        return false;
+
+    apply(m_redoStack.takeLast(), EntryLog::Record::Redo);
+    return true;
+}
+
+/**
+ * @brief EntryJournal::submit
+ *        Writes all pending operations to the ledger in a single transaction.
+ *
+ *        The write lock is taken here and held only while the batch is
+ *        written. If another writer stored entries under provisional IDs
+ *        meanwhile, the batch's added entries are moved above them and
+ *        reported as changed once committed.
+ * @return true if commit succeeded (or nothing was pending)
+ */
+bool EntryJournal::submit()
+{
+    if (m_undoStack.isEmpty())
+        return true;
+
+    QSqlQuery query(m_database);
+    if (!query.exec("BEGIN IMMEDIATE")) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+
+    // move added entries above the highest ID stored by now
+    QSet<qint64> added;
+    qint64 firstAdded = 0;
+    for (const Operation &operation : m_undoStack) {
+        if (operation.type != Operation::Add)
+            continue;
+        added.insert(operation.after.transactionID);
+        if (firstAdded == 0 || operation.after.transactionID < firstAdded)
+            firstAdded = operation.after.transactionID;
+    }
+    qint64 offset = 0;
+    if (firstAdded != 0 && query.exec("SELECT MAX(transactionID) "
+                                      "FROM budget") && query.next()) {
+        offset = std::max<qint64>(0, query.value(0).toLongLong() + 1 - firstAdded);
+    }
+    query.finish();
+    QVector<Operation> batch = m_undoStack;
+    if (offset > 0) {
+        for (Operation &operation : batch) {
+            if (added.contains(operation.before.transactionID))
+                operation.before.transactionID += offset;
+            if (added.contains(operation.after.transactionID))
+                operation.after.transactionID += offset;
+        }
+    }
+
+    bool written = true;
+    for (const Operation &operation : batch) {
+        written = execute(query, operation);
+        if (!written)
+            break;
+    }
+    // mark batch as committed in the same commit, so it is never replayed
+    if (written && m_log) {
+        query.prepare("INSERT OR REPLACE INTO log_batch "
+                      "(id, batch) "
+                      "VALUES (1, ?)");
+        query.bindValue(0, m_log->batch());
+        written = query.exec();
+        if (!written)
+            m_lastError = query.lastError().text();
+    }
+    if (written && !m_database.commit()) {
+        m_lastError = m_database.lastError().text();
+        written = false;
+    }
+    if (!written) {
+        query.finish();
+        m_database.rollback();
+        return false;
+    }
+
+    QVector<Transaction> moved;
+    if (offset > 0) {
+        for (const Transaction &entry : m_pending) {
+            if (added.contains(entry.transactionID))
+                moved.append(entry);
+        }
+    }
+    m_undoStack.clear();
+    m_redoStack.clear();
+    m_pending.clear();
+    m_replaced.clear();
+    m_unlogged.clear();
+    m_nextID = 0;
+    if (m_log)
+        m_log->reset(m_log->batch() + 1);
+
+    emit submitted();
+    for (const Transaction &entry : moved) {
+        Transaction stored = entry;
+        stored.transactionID += offset;
+        emit entryChanged(entry, stored);
+    }
+    emit pendingCountChanged(0);
+    return true;
+}
+
+/**
+ * @brief EntryJournal::discard
+ *        Forgets all pending operations.
+ */
+void EntryJournal::discard()
+{
+    m_undoStack.clear();
+    m_redoStack.clear();
+    m_pending.clear();
+    m_replaced.clear();
+    m_unlogged.clear();
+    m_nextID = 0;
+    if (m_log)
+        m_log->reset(m_log->batch() + 1);
+
+    emit discarded();
+    emit pendingCountChanged(0);
+}
+
+/**
+ * @brief EntryJournal::canUndo
+ * @return true if there is a pending operation to undo
+ */
+bool EntryJournal::canUndo() const
+{
+    return !m_undoStack.isEmpty();
+}
+
+/**
+ * @brief EntryJournal::canRedo
+ * @return true if there is an undone operation to redo
+ */
+bool EntryJournal::canRedo() const
+{
+    return !m_redoStack.isEmpty();
+}
+
+/**
+ * @brief EntryJournal::pendingCount
+ * @return number of uncommitted operations
+ */
+int EntryJournal::pendingCount() const
+{
+    return m_undoStack.size();
+}
+
+/**
+ * @brief EntryJournal::lastError
+ * @return description of last failed operation
+ */
+QString EntryJournal::lastError() const
+{
+    return m_lastError;
+}
+
+/**
+ * @brief EntryJournal::pendingEntries
+ * @return added and edited entries as they will be stored, unordered
+ */
+QVector<Transaction> EntryJournal::pendingEntries() const
+{
+    return m_pending.values().toVector();
+}
+
+/**
+ * @brief EntryJournal::replacedEntries
+ * @return stored entries that pending edits and removes replace, unordered
+ */
+QVector<Transaction> EntryJournal::replacedEntries() const
+{
+    return m_replaced.values().toVector();
+}
+
+/**
+ * @brief EntryJournal::pendingDelta
+ *        Corrections that turn sums over stored entries into sums over
+ *        the entries as they will be once submitted.
+ * @param filter filter the sums are taken over
+ * @return pending entries matching filter, and replaced stored entries
+ *         matching filter with negated amounts; unordered
+ */
+QVector<Transaction> EntryJournal::pendingDelta(const LedgerFilter &filter) const
+{
+    QVector<Transaction> delta;
+    for (const Transaction &entry : m_pending) {
+        if (LedgerQuery::matches(filter, entry))
+            delta.append(entry);
+    }
+    for (Transaction entry : m_replaced) {
+        if (LedgerQuery::matches(filter, entry)) {
+            entry.amount = -entry.amount;
+            delta.append(entry);
+        }
+    }
+    return delta;
+}
+
+/**
+ * @brief EntryJournal::isPending
+ * @param transactionID entry ID
+ * @return true if the entry's current values are pending, not stored
+ */
+bool EntryJournal::isPending(qint64 transactionID) const
+{
+    return m_pending.contains(transactionID);
+}
+
+/**
+ * @brief EntryJournal::isReplaced
+ * @param transactionID entry ID
+ * @return true if the stored entry is edited or removed by a pending operation
+ */
+bool EntryJournal::isReplaced(qint64 transactionID) const
+{
+    return m_replaced.contains(transactionID);
+}
+
+/**
+ * @brief EntryJournal::isUnlogged
+ * @param transactionID entry ID
+ * @return true if the entry is pending and its values are not durable in
+ *         the entry log yet, so a crash now would lose them
+ */
+bool EntryJournal::isUnlogged(qint64 transactionID) const
+{
+    return m_pending.contains(transactionID) && (!m_log || m_unlogged.contains(transactionID));
+}
+
+/**
+ * @brief EntryJournal::logSynced
+ *        Marks every logged operation durable once the entry log synced.
+ */
+void EntryJournal::logSynced()
+{
+    if (m_unlogged.isEmpty())
+        return;
+    m_unlogged.clear();
+    emit logged();
+}
+
+/**
+ * @brief EntryJournal::apply
+ *        Pushes operation onto the undo stack, logs it and announces it.
+ *        Nothing is written to the ledger until submit().
+ * @param operation operation to apply; Add operations carry their transactionID
+ * @param action Apply for a new operation, which clears the redo stack;
+ *        Redo for a redone one
+ */
+void EntryJournal::apply(const Operation &operation, EntryLog::Record::Action action)
+{
+    if (operation.type == Operation::Add)
+        m_nextID = std::max(m_nextID, operation.after.transactionID + 1);
+    m_undoStack.append(operation);
+    if (action == EntryLog::Record::Apply)
+        m_redoStack.clear();
+    updatePending();
+    log(action, operation);
+    emitApplied(operation);
+    emit pendingCountChanged(pendingCount());
+}
+
+/**
+ * @brief EntryJournal::updatePending
+ *        Recomputes pending and replaced entries from the undo stack.
+ *
+ *        An entry first seen being edited or removed is stored, so its
+ *        values before that operation are what it replaces; entries added
+ *        in the batch replace nothing.
+ */
+void EntryJournal::updatePending()
+{
+    m_pending.clear();
+    m_replaced.clear();
+    for (const Operation &operation : m_undoStack) {
+        switch (operation.type) {
+        case Operation::Add:
+            m_pending.insert(operation.after.transactionID, operation.after);
+            break;
+        case Operation::Edit:
+            if (!m_pending.contains(operation.before.transactionID)
+                && !m_replaced.contains(operation.before.transactionID)) {
+                m_replaced.insert(operation.before.transactionID, operation.before);
+            }
+            m_pending.insert(operation.after.transactionID, operation.after);
+            break;
+        case Operation::Remove:
+            if (!m_pending.contains(operation.before.transactionID)
+                && !m_replaced.contains(operation.before.transactionID)) {
+                m_replaced.insert(operation.before.transactionID, operation.before);
+            }
+            m_pending.remove(operation.before.transactionID);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief EntryJournal::provisionalID
+ *        Hands out the next transactionID above every stored and pending one.
+ * @return provisional transactionID for an added entry
+ */
+qint64 EntryJournal::provisionalID()
+{
+    QSqlQuery query(m_database);
+    if (query.exec("SELECT MAX(transactionID) "
+                   "FROM budget") && query.next()) {
+        m_nextID = std::max(m_nextID, query.value(0).toLongLong() + 1);
+    }
+    m_nextID = std::max<qint64>(m_nextID, 1);
+    return m_nextID++;
+}
+
+/**
+ * @brief EntryJournal::execute
+ *        Runs the SQL statement for an operation.
+ * @param query query on the ledger connection
+ * @param operation operation to execute
+ * @return true if statement succeeded
+ */
+bool EntryJournal::execute(QSqlQuery &query, const Operation &operation)
+{
+    switch (operation.type) {
+    case Operation::Add:
+        query.prepare("INSERT INTO budget "
+                      "(transactionID, date, category, subcategory, amount, currency, accountID, "
+                      "fingerprint) "
+                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+        query.bindValue(0, operation.after.transactionID);
+        query.bindValue(1, operation.after.date);
+        query.bindValue(2, operation.after.category);
+        query.bindValue(3, operation.after.subcategory);
+        query.bindValue(4, operation.after.amount);
+        query.bindValue(5, operation.after.currency);
+        query.bindValue(6, operation.after.accountID);
+        query.bindValue(7, EntryImporter::fingerprint(operation.after));
+        break;
+    case Operation::Edit:
+        query.prepare("UPDATE budget "
+                      "SET date = ?, category = ?, subcategory = ?, amount = ?, currency = ?, "
+                      "accountID = ?, fingerprint = ? "
+                      "WHERE transactionID = ?");
+        query.bindValue(0, operation.after.date);
+        query.bindValue(1, operation.after.category);
+        query.bindValue(2, operation.after.subcategory);
+        query.bindValue(3, operation.after.amount);
+        query.bindValue(4, operation.after.currency);
+        query.bindValue(5, operation.after.accountID);
+        query.bindValue(6, EntryImporter::fingerprint(operation.after));
+        query.bindValue(7, operation.after.transactionID);
+        break;
+    case Operation::Remove:
+        query.prepare("DELETE FROM budget "
+                      "WHERE transactionID = ?");
+        query.bindValue(0, operation.before.transactionID);
+        break;
+    }
+
+    if (!query.exec()) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief EntryJournal::log
+ *        Appends journal action to the entry log, if one is attached, and
+ *        marks the entries it touches unlogged until the log syncs. Called
+ *        before the action is announced, so slots already see the marks.
+ * @param action applied, undone or redone
+ * @param operation operation the action was taken on
+ */
+void EntryJournal::log(EntryLog::Record::Action action, const Operation &operation)
+{
+    if (!m_log || m_replaying)
+        return;
+
+    EntryLog::Record record;
+    record.action = action;
+    record.operation = operation.type;
+    record.before = operation.before;
+    record.after = operation.after;
+    m_log->append(record);
+    if (operation.before.transactionID != 0)
+        m_unlogged.insert(operation.before.transactionID);
+    if (operation.after.transactionID != 0)
+        m_unlogged.insert(operation.after.transactionID);
+}
+
+/**
+ * @brief EntryJournal::emitApplied
+ *        Emits change signal for an applied operation.
+ * @param operation applied operation
+ */
+void EntryJournal::emitApplied(const Operation &operation)
+{
+    switch (operation.type) {
+    case Operation::Add:
+        emit entryAdded(operation.after);
+        break;
+    case Operation::Edit:
+        emit entryChanged(operation.before, operation.after);
+        break;
+    case Operation::Remove:
+        emit entryRemoved(operation.before);
+        break;
+    }
+}
+
+/**
+ * @brief EntryJournal::emitReverted
+ *        Emits inverse change signal for an undone operation.
+ * @param operation undone operation
+ */
+void EntryJournal::emitReverted(const Operation &operation)
+{
+    switch (operation.type) {
+    case Operation::Add:
+        emit entryRemoved(operation.after);
+        break;
+    case Operation::Edit:
+        emit entryChanged(operation.after, operation.before);
+        break;
+    case Operation::Remove:
+        emit entryAdded(operation.before);
+        break;
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "EntryLog.h"
+#include "LedgerQuery.h"
+#include "Transaction.h"
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QVector>
+
+/**
+ * @brief The EntryJournal class
+ *        Client-side command journal for budget table edits.
+ *
+ *        Adds, edits and removes are kept in memory until the batch is
+ *        submitted, so they can be undone and redone freely and no lock is
+ *        held on the ledger meanwhile. Views show them on top of the stored
+ *        entries: pendingEntries() are the added and edited entries as they
+ *        will be stored, replacedEntries() the stored ones that pending
+ *        edits and removes replace. Added entries get provisional IDs above
+ *        the highest stored one. Submitting writes the whole batch in one
+ *        short transaction (one fsync), moving provisional IDs up if another
+ *        writer took them meanwhile; discarding just forgets it.
+ *
+ *        With an EntryLog attached, every applied, undone and redone
+ *        operation is also logged durably, so a batch that never got
+ *        submitted because of a crash can be replayed on the next start.
+ *        The ledger records the last submitted batch number in the same
+ *        commit, so a batch is never replayed twice. The log commits in
+ *        groups, so an operation is announced before it is durable:
+ *        isUnlogged() tells which pending entries a crash could still
+ *        lose, until logged() is emitted.
+ */
+class EntryJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    // constructor
+    explicit EntryJournal(const QSqlDatabase &database, QObject *parent = nullptr);
+
+    // crash recovery
+    void setLog(EntryLog *log);
+    int replay();
+
+    // journal operations
+    bool addEntry(const Transaction &entry);
+    bool editEntry(const Transaction &before, const Transaction &after);
+    bool removeEntry(qint64 transactionID);
+    bool undo();
+    bool redo();
+    bool submit();
+    void discard();
+
+    // getters
+    bool canUndo() const;
+    bool canRedo() const;
+    int pendingCount() const;
+    QString lastError() const;
+
+    // pending entries
+    QVector<Transaction> pendingEntries() const;
+    QVector<Transaction> replacedEntries() const;
+    QVector<Transaction> pendingDelta(const LedgerFilter &filter) const;
+    bool isPending(qint64 transactionID) const;
+    bool isReplaced(qint64 transactionID) const;
+    bool isUnlogged(qint64 transactionID) const;
+
+signals:
+    void entryAdded(const Transaction &entry);
+    void entryRemoved(const Transaction &entry);
+    void entryChanged(const Transaction &before, const Transaction &after);
+    void pendingCountChanged(int count);
+    void submitted();
+    void discarded();
+    void logged();
+
+private slots:
+    void logSynced();
+
+private:
+    /**
+     * @brief The Operation struct
+     *        One journaled change; before/after are unused for Add/Remove respectively.
+     */
+    struct Operation {
+        enum Type { Add, Edit, Remove };
+        Type type;
+        Transaction before;
+        Transaction after;
+    };
+
+    QSqlDatabase m_database;
+    QVector<Operation> m_undoStack;     // applied, uncommitted operations
+    QVector<Operation> m_redoStack;     // undone operations
+    QHash<qint64, Transaction> m_pending;   // added/edited entries by ID, as they will be stored
+    QHash<qint64, Transaction> m_replaced;  // stored entries that pending edits/removes replace
+    QSet<qint64> m_unlogged;            // entries changed by operations not yet durable in the log
+    qint64 m_nextID = 0;                // lowest provisional transactionID not handed out yet
+    EntryLog *m_log = nullptr;          // durable log of pending operations; may be null
+    bool m_replaying = false;           // replayed operations are already logged
+    QString m_lastError;
+
+    void apply(const Operation &operation, EntryLog::Record::Action action);
+    void updatePending();
+    qint64 provisionalID();
+    bool execute(QSqlQuery &query, const Operation &operation);
+    void log(EntryLog::Record::Action action, const Operation &operation);
+    void emitApplied(const Operation &operation);
+    void emitReverted(const Operation &operation);
+};
@@ -0,0 +1,261 @@
+#include "EntryLog.h"
+#include "LedgerCipher.h"
+
+#include <QDataStream>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+/**
+ * @brief serialize
+ * @param entry entry to store in a log record
+ * @return entry as binary blob
+ */
+QByteArray serialize(const Transaction &entry)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << entry.transactionID << entry.accountID << entry.date << entry.category
+           << entry.subcategory << entry.amount << entry.currency << entry.ruleID;
+    return data;
+}
+
+/**
+ * @brief deserialize
+ * @param data binary blob written by serialize()
+ * @return stored entry
+ */
+Transaction deserialize(const QByteArray &data)
+{
+    Transaction entry;
+    QDataStream stream(data);
+    stream >> entry.transactionID >> entry.accountID >> entry.date >> entry.category
+           >> entry.subcategory >> entry.amount >> entry.currency >> entry.ruleID;
+    return entry;
+}
+}
+
+/**
+ * @brief EntryLog::EntryLog
+ *        Creates log for sidecar database at path. Nothing is read or
+ *        written until open() is called.
+ * @param path log database path
+ * @param key raw ledger key; empty for an unencrypted ledger
+ * @param parent pointer to QObject parent object
+ */
+EntryLog::EntryLog(const QString &path, const QByteArray &key, QObject *parent)
+    : QObject(parent)
+    , m_path(path)
+    , m_key(key)
+    , m_connectionName(QString("entry_log_%1").arg(reinterpret_cast<quintptr>(this)))
+    , syncTimer(new QTimer(this))
+{
+    syncTimer->setSingleShot(true);
+    syncTimer->setInterval(GroupCommitMs);
+    connect(syncTimer, &QTimer::timeout,
+            this, &EntryLog::sync);
+}
+
+/**
+ * @brief EntryLog::~EntryLog
+ *        Makes queued records durable and closes the log connection.
+ */
+EntryLog::~EntryLog()
+{
+    if (m_open)
+        sync();
+    {
+        QSqlDatabase database = QSqlDatabase::database(m_connectionName, false);
+        if (database.isValid())
+            database.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+/**
+ * @brief EntryLog::open
+ *        Opens (or creates) log database and reads current batch number.
+ *
+ *        The log runs in WAL mode with full synchronous commits, so each
+ *        group commit is a single appended, fsynced write.
+ * @return true if log is ready for appends
+ */
+bool EntryLog::open()
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase(LedgerCipher::driverName(), m_connectionName);
+    database.setDatabaseName(m_path);
+    if (!LedgerCipher::open(database, m_key))
+        return fail(QString("Entry log could not be opened: %1").arg(database.lastError().text()));
+
+    QSqlQuery query(database);
+    if (!query.exec("PRAGMA journal_mode = WAL")
+        || !query.exec("PRAGMA synchronous = FULL")
+        || !query.exec("CREATE TABLE IF NOT EXISTS log ("
+                       "seq INTEGER PRIMARY KEY, "
+                       "batch INTEGER, "
+                       "action INTEGER, "
+                       "operation INTEGER, "
+                       "before BLOB, "
+                       "after BLOB)")
+        || !query.exec("SELECT MAX(batch) "
+                       "FROM log")) {
+        return fail(query.lastError().text());
+    }
+    m_batch = query.next() ? query.value(0).toLongLong() : 0;
+    m_open = true;
+    return true;
+}
+
+/**
+ * @brief EntryLog::append
+ *        Queues record for the next group commit.
+ *
+ *        The record is durable once sync() has run, at most GroupCommitMs
+ *        later; a failure is reported through failed().
+ * @param record journal action to log
+ */
+void EntryLog::append(const Record &record)
+{
+    if (!m_open)
+        return;
+    m_queue.append(record);
+    if (!syncTimer->isActive())
+        syncTimer->start();
+}
+
+/**
+ * @brief EntryLog::sync
+ *        Writes all queued records in one transaction (one fsync), and
+ *        announces that they are durable.
+ * @return true if every queued record is durable
+ */
+bool EntryLog::sync()
+{
+    syncTimer->stop();
+    if (!m_open || m_queue.isEmpty())
+        return m_open;
+
+    QSqlDatabase database = QSqlDatabase::database(m_connectionName);
+    if (!database.transaction())
+        return fail(database.lastError().text());
+
+    QSqlQuery query(database);
+    query.prepare("INSERT INTO log "
+                  "(batch, action, operation, before, after) "
+                  "VALUES (?, ?, ?, ?, ?)");
+    for (const Record &record : m_queue) {
+        query.bindValue(0, m_batch);
+        query.bindValue(1, static_cast<int>(record.action));
+        query.bindValue(2, record.operation);
+        query.bindValue(3, serialize(record.before));
+        query.bindValue(4, serialize(record.after));
+        if (!query.exec()) {
+            QString error = query.lastError().text();
+            database.rollback();
+            return fail(error);
+        }
+    }
+    if (!database.commit()) {
+        QString error = database.lastError().text();
+        database.rollback();
+        return fail(error);
+    }
+    m_queue.clear();
+    emit synced();
+    return true;
+}
+
+/**
+ * @brief EntryLog::reset
+ *        Drops all records once their batch was committed to (or discarded
+ *        from) the ledger, and starts a new batch.
+ * @param batch number of the next batch
+ * @return true if log was cleared
+ */
+bool EntryLog::reset(qint64 batch)
+{
+    syncTimer->stop();
+    m_queue.clear();
+    m_batch = batch;
+    if (!m_open)
+        return false;
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    if (!query.exec("DELETE FROM log"))
+        return fail(query.lastError().text());
+    return true;
+}
+
+/**
+ * @brief EntryLog::records
+ *        Reads logged records of batches the ledger has not committed.
+ * @param afterBatch last batch committed to the ledger
+ * @return records in append order
+ */
+QVector<EntryLog::Record> EntryLog::records(qint64 afterBatch)
+{
+    QVector<Record> records;
+    if (!m_open)
+        return records;
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.setForwardOnly(true);
+    query.prepare("SELECT action, operation, before, after "
+                  "FROM log "
+                  "WHERE batch > ? "
+                  "ORDER BY seq");
+    query.bindValue(0, afterBatch);
+    if (!query.exec()) {
+        fail(query.lastError().text());
+        return records;
+    }
+    while (query.next()) {
+        Record record;
+        record.action = static_cast<Record::Action>(query.value(0).toInt());
+        record.operation = query.value(1).toInt();
+        record.before = deserialize(query.value(2).toByteArray());
+        record.after = deserialize(query.value(3).toByteArray());
+        records.append(record);
+    }
+    return records;
+}
+
+/**
+ * @brief EntryLog::isOpen
+ * @return true if log was opened successfully
+ */
+bool EntryLog::isOpen() const
+{
+    return m_open;
+}
+
+/**
+ * @brief EntryLog::batch
+ * @return batch number of current records; 0 if log is empty
+ */
+qint64 EntryLog::batch() const
+{
+    return m_batch;
+}
+
+/**
+ * @brief EntryLog::lastError
+ * @return description of last failure
+ */
+QString EntryLog::lastError() const
+{
+    return m_lastError;
+}
+
+/**
+ * @brief EntryLog::fail
+ *        Records and reports a failure.
+ * @param error failure description
+ * @return false
+ */
+bool EntryLog::fail(const QString &error)
+{
+    m_lastError = error;
+    emit failed(error);
+    return false;
+}
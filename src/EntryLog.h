@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Transaction.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @brief The EntryLog class
+ *        Durable append-only log of pending journal operations.
+ *
+ *        Pending operations only live in the journal's memory, so a crash
+ *        would lose them. Each one is also appended here, to a
+ *        small sidecar database next to the ledger, keyed like the ledger
+ *        itself. Appends are group committed: records arriving within
+ *        GroupCommitMs of each other are written in one transaction, so a
+ *        burst of entries costs one fsync instead of one each. After a crash
+ *        the records of the uncommitted batch are replayed on startup.
+ */
+class EntryLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief The Record struct
+     *        One logged journal action; operation is the journal's own
+     *        operation type and is unused for Undo/Redo.
+     */
+    struct Record {
+        enum Action { Apply, Undo, Redo };
+        Action action = Apply;
+        int operation = 0;
+        Transaction before;
+        Transaction after;
+    };
+
+    static const int GroupCommitMs = 5;    // window for batching appends into one commit
+
+    // constructor and destructor
+    EntryLog(const QString &path, const QByteArray &key, QObject *parent = nullptr);
+    ~EntryLog();
+
+    // log operations
+    bool open();
+    void append(const Record &record);
+    bool sync();
+    bool reset(qint64 batch);
+    QVector<Record> records(qint64 afterBatch);
+
+    // getters
+    bool isOpen() const;
+    qint64 batch() const;
+    QString lastError() const;
+
+signals:
+    void synced();
+    void failed(const QString &error);
+
+private:
+    QString m_path;
+    QByteArray m_key;
+    QString m_connectionName;
+    QTimer *syncTimer;                  // coalesces appends into one commit
+    QVector<Record> m_queue;            // appended, not yet durable records
+    qint64 m_batch = 0;                 // batch number of current records
+    bool m_open = false;
+    QString m_lastError;
+
+    bool fail(const QString &error);
+};
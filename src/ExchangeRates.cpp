@@ -0,0 +1,239 @@
+#include "ExchangeRates.h"
+
+#include <QFile>
+#include <QLocale>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTextStream>
+
+/**
+ * @brief ExchangeRates::ExchangeRates
+ *        Default constructor. No rates are known until load() is called;
+ *        display currency starts as the home currency.
+ */
+ExchangeRates::ExchangeRates()
+    : m_displayCurrency(homeCurrency())
+{
+}
+
+/**
+ * @brief ExchangeRates::load
+ *        Loads all rates from rates table and drops cached factors.
+ * @param database open user database
+ */
+void ExchangeRates::load(const QSqlDatabase &database)
+{
+    m_rates.clear();
+    m_factors.clear();
+
+    QSqlQuery query(database);
+    query.setForwardOnly(true);
+    query.exec("SELECT date, currency, rate "
+               "FROM rates");
+    while (query.next()) {
+        QDate date = QDate::fromString(query.value(0).toString(), "yyyy/MM/dd");
+        double rate = query.value(2).toDouble();
+        if (date.isValid() && rate > 0)
+            m_rates[query.value(1).toString()].insert(date, rate);
+    }
+}
+
+/**
+ * @brief ExchangeRates::importFile
+ *        Stores rates from a local CSV file into rates table.
+ *
+ *        Each line is "date,currency,rate", with the rate given as units
+ *        of currency per unit of the file's reference currency, which
+ *        should itself be listed with rate 1. Lines that do not parse,
+ *        such as a header, are skipped. Existing rates for the same date
+ *        and currency are replaced. Call load() afterwards to use them.
+ * @param database open user database, without a transaction in progress
+ * @param path CSV file path
+ * @param error receives error message on failure, if not null
+ * @return number of rates stored; -1 on failure
+ */
+int ExchangeRates::importFile(QSqlDatabase &database, const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error)
+            *error = file.errorString();
+        return -1;
+    }
+    if (!database.transaction()) {
+        if (error)
+            *error = database.lastError().text();
+        return -1;
+    }
+
+    QSqlQuery query(database);
+    query.prepare("INSERT OR REPLACE INTO rates "
+                  "(date, currency, rate) "
+                  "VALUES (?, ?, ?)");
+    int count = 0;
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        QStringList fields = stream.readLine().split(',');
+        if (fields.size() != 3)
+            continue;
+        QString dateField = fields.at(0).trimmed();
+        QDate date = QDate::fromString(dateField, "yyyy/MM/dd");
+        if (!date.isValid())
+            date = QDate::fromString(dateField, Qt::ISODate);
+        QString currency = fields.at(1).trimmed().toUpper();
+        bool ok = false;
+        double rate = fields.at(2).trimmed().toDouble(&ok);
+        if (!date.isValid() || currency.size() != 3 || !ok || rate <= 0)
+            continue;
+
+        query.bindValue(0, date.toString("yyyy/MM/dd"));
+        query.bindValue(1, currency);
+        query.bindValue(2, rate);
+        if (!query.exec()) {
+            if (error)
+                *error = query.lastError().text();
+            database.rollback();
+            return -1;
+        }
+        ++count;
+    }
+
+    if (!database.commit()) {
+        if (error)
+            *error = database.lastError().text();
+        database.rollback();
+        return -1;
+    }
+    return count;
+}
+
+/**
+ * @brief ExchangeRates::displayCurrency
+ * @return currency amounts are converted to
+ */
+QString ExchangeRates::displayCurrency() const
+{
+    return m_displayCurrency;
+}
+
+/**
+ * @brief ExchangeRates::setDisplayCurrency
+ *        Sets currency amounts are converted to and drops cached factors.
+ * @param currency ISO 4217 code
+ */
+void ExchangeRates::setDisplayCurrency(const QString &currency)
+{
+    if (currency == m_displayCurrency)
+        return;
+    m_displayCurrency = currency;
+    m_factors.clear();
+}
+
+/**
+ * @brief ExchangeRates::currencies
+ * @return currencies with known rates, sorted, including the display currency
+ */
+QStringList ExchangeRates::currencies() const
+{
+    QStringList currencies = m_rates.keys();
+    if (!currencies.contains(m_displayCurrency))
+        currencies.append(m_displayCurrency);
+    currencies.sort();
+    return currencies;
+}
+
+/**
+ * @brief ExchangeRates::homeCurrency
+ * @return currency of the system locale; USD if it has none
+ */
+QString ExchangeRates::homeCurrency()
+{
+    QString currency = QLocale::system().currencySymbol(QLocale::CurrencyIsoCode);
+    return currency.isEmpty() ? QString("USD") : currency;
+}
+
+/**
+ * @brief ExchangeRates::factor
+ *        Conversion factor from currency to display currency on date.
+ *
+ *        Uses the latest rates on or before date (or the earliest known
+ *        rates for older dates). Currencies without any rates are left
+ *        unconverted.
+ * @param currency ISO 4217 code; empty for the display currency
+ * @param date conversion date
+ * @return factor to multiply amounts with
+ */
+double ExchangeRates::factor(const QString &currency, const QDate &date) const
+{
+    if (currency.isEmpty() || currency == m_displayCurrency)
+        return 1;
+
+    QPair<QString, qint64> key(currency, date.toJulianDay());
+    auto it = m_factors.constFind(key);
+    if (it != m_factors.constEnd())
+        return it.value();
+
+    double from = rate(currency, date);
+    double to = rate(m_displayCurrency, date);
+    double factor = from > 0 && to > 0 ? to / from : 1;
+    m_factors.insert(key, factor);
+    return factor;
+}
+
+/**
+ * @brief ExchangeRates::convert
+ * @param entry entry to convert
+ * @return entry amount in display currency
+ */
+double ExchangeRates::convert(const Transaction &entry) const
+{
+    return entry.amount * factor(entry.currency, QDate::fromString(entry.date, "yyyy/MM/dd"));
+}
+
+/**
+ * @brief ExchangeRates::convert
+ *        Converts a whole result set in one pass.
+ *
+ *        Result sets are ordered by date, so consecutive entries mostly
+ *        share currency and day; the factor is only looked up again when
+ *        either changes.
+ * @param entries entries to convert
+ * @return amount of each entry in display currency
+ */
+QVector<double> ExchangeRates::convert(const QVector<Transaction> &entries) const
+{
+    QVector<double> amounts;
+    amounts.reserve(entries.size());
+
+    const QString *lastCurrency = nullptr;
+    const QString *lastDate = nullptr;
+    double lastFactor = 1;
+    for (const Transaction &entry : entries) {
+        if (!lastDate || entry.date != *lastDate || entry.currency != *lastCurrency) {
+            lastFactor = factor(entry.currency, QDate::fromString(entry.date, "yyyy/MM/dd"));
+            lastCurrency = &entry.currency;
+            lastDate = &entry.date;
+        }
+        amounts.append(entry.amount * lastFactor);
+    }
+    return amounts;
+}
+
+/**
+ * @brief ExchangeRates::rate
+ * @param currency ISO 4217 code
+ * @param date rate date
+ * @return units of currency per reference unit on date; 0 if unknown
+ */
+double ExchangeRates::rate(const QString &currency, const QDate &date) const
+{
+    auto ratesIt = m_rates.constFind(currency);
+    if (ratesIt == m_rates.constEnd() || ratesIt->isEmpty())
+        return 0;
+
+    // latest rate on or before date, else the earliest one
+    auto it = ratesIt->upperBound(date);
+    if (it != ratesIt->constBegin())
+        --it;
+    return it.value();
+}
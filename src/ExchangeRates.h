@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Transaction.h"
+
+#include <QDate>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief The ExchangeRates class
+ *        Date-indexed exchange rates and conversion to a display currency.
+ *
+ *        Rates are kept per currency as units per one unit of a common
+ *        reference currency, so any pair converts through the reference.
+ *        Conversion factors are cached per currency and day. Being a plain
+ *        value, a copy can be handed to a worker thread.
+ */
+class ExchangeRates
+{
+public:
+    // constructor
+    ExchangeRates();
+
+    // loading
+    void load(const QSqlDatabase &database);
+    static int importFile(QSqlDatabase &database, const QString &path, QString *error = nullptr);
+
+    // display currency
+    QString displayCurrency() const;
+    void setDisplayCurrency(const QString &currency);
+    QStringList currencies() const;
+    static QString homeCurrency();
+
+    // conversion
+    double factor(const QString &currency, const QDate &date) const;
+    double convert(const Transaction &entry) const;
+    QVector<double> convert(const QVector<Transaction> &entries) const;
+
+private:
+    QString m_displayCurrency;
+    QHash<QString, QMap<QDate, double>> m_rates;            // units per reference unit, by currency and date
+    mutable QHash<QPair<QString, qint64>, double> m_factors; // factor cache by currency and julian day
+
+    double rate(const QString &currency, const QDate &date) const;
+};
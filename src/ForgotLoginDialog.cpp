@@ -35,12 +35,24 @@ ForgotLoginDialog::~ForgotLoginDialog()
     delete ui;
 }
 
+/**
+ * @brief ForgotLoginDialog::setLoggedInUsers
+ *        Setter for users already logged in. Their ledgers are open with
+ *        the key of the current password, so re-encrypting them under a
+ *        new one would leave the open session unable to read them.
+ * @param userIDs userIDs with an open session
+ */
+void ForgotLoginDialog::setLoggedInUsers(const QList<int> &userIDs)
+{
+    m_loggedInUsers = userIDs;
+}
+
 /**
  * @brief ForgotLoginDialog::resetPassword
  *        Attempts to reset password with LoginDatabaseManager.
  *
- *        Accepts QDialog if passwords and userID are verified.
- *        Updates status label to reflect outcome.
+ *        Accepts QDialog if passwords and userID are verified and the
+ *        user is not logged in. Updates status label to reflect outcome.
  */
 void ForgotLoginDialog::resetPassword()
 {
@@ -51,9 +63,16 @@ void ForgotLoginDialog::resetPassword()
     QString confirmPassword = ui->confirmPasswordLineEdit->text();
 
     if (verifyPassword(newPassword, confirmPassword)) {
-        if (db.verifyUserID(userID)) {
-            db.changePassword(userID, newPassword);
-            QDialog::accept();
+        if (m_loggedInUsers.contains(userID)) {
+            ui->statusLabel->setStyleSheet("color: red");
+            ui->statusLabel->setText("User is logged in; close their windows first");
+        } else if (db.verifyUserID(userID)) {
+            if (db.changePassword(userID, newPassword)) {
+                QDialog::accept();
+            } else {
+                ui->statusLabel->setStyleSheet("color: red");
+                ui->statusLabel->setText("Ledger could not be re-encrypted");
+            }
         } else {
             ui->statusLabel->setStyleSheet("color: red");
             ui->statusLabel->setText("userID does not exist");
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QDialog>
+#include <QList>
 
 namespace Ui {
 class ForgotLoginDialog;
@@ -23,12 +24,16 @@ public:
     // destructors
     ~ForgotLoginDialog();
 
+    // setter
+    void setLoggedInUsers(const QList<int> &userIDs);
+
 private slots:
     void resetPassword();
     void clearStatusLabel();
 
 private:
     Ui::ForgotLoginDialog *ui;
+    QList<int> m_loggedInUsers;     // userIDs with an open session, whose ledgers cannot be rekeyed
 
     bool verifyPassword(const QString &newPassword, const QString &confirmPassword);
 };
@@ -0,0 +1,406 @@
+#include "LedgerBench.h"
+#include "AccountList.h"
+#include "EntryImporter.h"
+#include "EntryJournal.h"
+#include "ExchangeRates.h"
+#include "LedgerCipher.h"
+#include "LedgerQuery.h"
+#include "LedgerSession.h"
+#include "User.h"
+
+#include <QDate>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+namespace {
+const char *BenchUser = "bench";            // user of the scratch ledger
+const char *BenchPassword = "bench";        // derives the scratch ledger's key
+const char *BenchAccount = "Bench";         // account of every entry
+const char *ConnectionName = "ledger_bench";
+const double MaxOverhead = 0.15;            // slowdown of encrypted workloads that fails the benchmark
+const int CategoryCount = 12;               // categories of random entries
+const int MaxAmountCents = 50000;           // largest random amount, in cents
+const int DateRangeDays = 2500;             // random dates from 2020/01/01 on
+const quint32 Seed = 35;                    // same entries in every run
+
+/**
+ * @brief The Ledger struct
+ *        One side of the comparison.
+ */
+struct Ledger {
+    QString path;
+    QByteArray key;             // empty for the unencrypted copy
+};
+
+/**
+ * @brief The Setup struct
+ *        What the workloads need to know about the scratch ledgers.
+ */
+struct Setup {
+    QString csvPath;            // import file of entries
+    qint64 accountID = 0;       // account of every entry
+    int entries = 0;            // entries in the import file, and journaled
+};
+
+using Workload = std::function<bool(QSqlDatabase &database, QString *error)>;
+
+/**
+ * @brief categoryName
+ * @param category category index
+ * @return name of the category
+ */
+QString categoryName(int category)
+{
+    return QString("Category %1").arg(category);
+}
+
+/**
+ * @brief randomEntry
+ * @param random random source
+ * @param serial numbers the entry, so no two are alike
+ * @param accountID account of the entry
+ * @return entry with random date, category and amount
+ */
+Transaction randomEntry(QRandomGenerator &random, qint64 serial, qint64 accountID)
+{
+    Transaction entry;
+    entry.date = QDate(2020, 1, 1).addDays(random.bounded(DateRangeDays)).toString("yyyy/MM/dd");
+    entry.category = categoryName(random.bounded(CategoryCount));
+    entry.subcategory = QString("Item %1").arg(serial);
+    qint64 amountCents = random.bounded(1, MaxAmountCents);
+    entry.amount = (random.bounded(2) == 0 ? -amountCents : amountCents) / 100.0;
+    entry.currency = ExchangeRates::homeCurrency();
+    entry.accountID = accountID;
+    return entry;
+}
+
+/**
+ * @brief writeCsv
+ *        Writes the import file of the import workloads.
+ * @param setup scratch ledger setup
+ * @return true if the file was written
+ */
+bool writeCsv(const Setup &setup)
+{
+    QFile file(setup.csvPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    stream << "date,category,subcategory,amount,currency\n";
+    QRandomGenerator random(Seed);
+    for (int i = 0; i < setup.entries; ++i) {
+        Transaction entry = randomEntry(random, i, setup.accountID);
+        stream << entry.date << ',' << entry.category << ',' << entry.subcategory << ','
+               << QString::number(entry.amount, 'f', 2) << ',' << entry.currency << '\n';
+    }
+    return stream.status() == QTextStream::Ok;
+}
+
+/**
+ * @brief exportPlain
+ *        Exports an unencrypted copy of the encrypted scratch ledger, so
+ *        both sides start from the same schema and rows.
+ * @param encrypted encrypted scratch ledger
+ * @param path path of the copy
+ * @param error receives error message on failure
+ * @return true if the copy was written
+ */
+bool exportPlain(const Ledger &encrypted, const QString &path, QString *error)
+{
+    bool exported = false;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(LedgerCipher::driverName(), ConnectionName);
+        database.setDatabaseName(encrypted.path);
+        if (LedgerCipher::open(database, encrypted.key)) {
+            QSqlQuery query(database);
+            query.prepare("ATTACH DATABASE ? AS plain KEY ''");
+            query.bindValue(0, path);
+            exported = query.exec();
+            // sqlcipher_export() copies schema and rows, but not the schema version
+            int userVersion = 0;
+            if (exported && query.exec("PRAGMA main.user_version") && query.next())
+                userVersion = query.value(0).toInt();
+            exported = exported
+                       && query.exec("SELECT sqlcipher_export('plain')")
+                       && query.exec(QString("PRAGMA plain.user_version = %1").arg(userVersion))
+                       && query.exec("DETACH DATABASE plain");
+            if (!exported)
+                *error = query.lastError().text();
+        } else {
+            *error = database.lastError().text();
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(ConnectionName);
+    return exported;
+}
+
+/**
+ * @brief measure
+ *        Runs a workload on a fresh connection to a ledger.
+ *
+ *        Opening and keying the connection is not timed: the key is
+ *        derived once per login, and connections are reused after that.
+ * @param ledger ledger to run on
+ * @param workload workload to time
+ * @param error receives error message on failure
+ * @return nanoseconds the workload took; -1 if it failed
+ */
+qint64 measure(const Ledger &ledger, const Workload &workload, QString *error)
+{
+    qint64 elapsed = -1;
+    {
+        // both sides use the same driver, so only the cipher differs
+        QSqlDatabase database = QSqlDatabase::addDatabase(LedgerCipher::driverName(), ConnectionName);
+        database.setDatabaseName(ledger.path);
+        if (LedgerCipher::open(database, ledger.key)) {
+            // the ledger session's journal mode, so both sides write alike
+            QSqlQuery query(database);
+            if (query.exec("PRAGMA journal_mode = WAL")) {
+                query.finish();
+                QElapsedTimer timer;
+                timer.start();
+                if (workload(database, error))
+                    elapsed = timer.nsecsElapsed();
+            } else {
+                *error = query.lastError().text();
+            }
+        } else {
+            *error = database.lastError().text();
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(ConnectionName);
+    return elapsed;
+}
+
+/**
+ * @brief importWorkload
+ * @param setup scratch ledger setup
+ * @param duplicates true if every entry of the file is stored already
+ * @return workload importing the import file
+ */
+Workload importWorkload(const Setup &setup, bool duplicates)
+{
+    return [setup, duplicates](QSqlDatabase &database, QString *error) {
+        AccountList accounts;
+        accounts.load(database);
+        ImportResult result = EntryImporter::importFile(database, setup.csvPath,
+                                                        accounts, setup.accountID);
+        if (!result.error.isEmpty()) {
+            *error = result.error;
+            return false;
+        }
+        if ((duplicates ? result.duplicates : result.imported) != setup.entries) {
+            *error = QString("%1 imported, %2 duplicates").arg(result.imported).arg(result.duplicates);
+            return false;
+        }
+        return true;
+    };
+}
+
+/**
+ * @brief journalWorkload
+ * @param setup scratch ledger setup
+ * @return workload submitting added entries in batches of BatchEntries
+ */
+Workload journalWorkload(const Setup &setup)
+{
+    return [setup](QSqlDatabase &database, QString *error) {
+        EntryJournal journal(database);
+        QRandomGenerator random(Seed + 1);
+        for (int i = 0; i < setup.entries; ++i) {
+            journal.addEntry(randomEntry(random, setup.entries + i, setup.accountID));
+            if ((i + 1) % LedgerBench::BatchEntries == 0 || i + 1 == setup.entries) {
+                if (!journal.submit()) {
+                    *error = journal.lastError();
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+}
+
+/**
+ * @brief tableWorkload
+ * @return workload reading every row in table chunks, as the table loads them
+ */
+Workload tableWorkload()
+{
+    return [](QSqlDatabase &database, QString *error) {
+        QSqlQuery query(database);
+        query.setForwardOnly(true);
+        QString lastDate;
+        qint64 lastID = 0;
+        for (;;) {
+            int tail = LedgerQuery::prepare<LedgerQuery::TableChunk>(query, LedgerFilter());
+            query.bindValue(0, lastDate);
+            query.bindValue(1, lastDate);
+            query.bindValue(2, lastID);
+            query.bindValue(tail, LedgerBench::ChunkRows);
+            if (!query.exec()) {
+                *error = query.lastError().text();
+                return false;
+            }
+            int rows = 0;
+            while (query.next()) {
+                Transaction entry = LedgerQuery::readEntry(query);
+                lastDate = entry.date;
+                lastID = entry.transactionID;
+                ++rows;
+            }
+            if (rows < LedgerBench::ChunkRows)
+                return true;
+        }
+    };
+}
+
+/**
+ * @brief plotWorkload
+ * @return workload summing the plot of the whole ledger and of each category
+ */
+Workload plotWorkload()
+{
+    return [](QSqlDatabase &database, QString *error) {
+        QSqlQuery query(database);
+        query.setForwardOnly(true);
+        for (int category = -1; category < CategoryCount; ++category) {
+            LedgerFilter filter;
+            if (category >= 0)
+                filter.category = categoryName(category);
+            LedgerQuery::prepare<LedgerQuery::PlotSums>(query, filter);
+            if (!query.exec()) {
+                *error = query.lastError().text();
+                return false;
+            }
+            int days = 0;
+            while (query.next())
+                ++days;
+            if (days == 0) {
+                *error = QString("no plot sums for %1").arg(category < 0 ? "ledger" : filter.category);
+                return false;
+            }
+        }
+        return true;
+    };
+}
+}
+
+/**
+ * @brief LedgerBench::isRequested
+ *        Checked before the application object exists, since the
+ *        benchmark runs without widgets.
+ * @param argc argument count of main()
+ * @param argv arguments of main()
+ * @return true if the program was started to run the benchmark
+ */
+bool LedgerBench::isRequested(int argc, char *argv[])
+{
+    return argc > 1 && qstrcmp(argv[1], "--bench-cipher") == 0;
+}
+
+/**
+ * @brief LedgerBench::run
+ *        Creates the scratch ledgers, runs every workload on both and
+ *        prints the results.
+ * @param arguments application arguments
+ * @return process exit code; 0 if every workload stayed within budget
+ */
+int LedgerBench::run(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    if (!LedgerCipher::isAvailable()) {
+        out << "Bench: SQLCipher driver not installed, ledgers are not encrypted\n";
+        return 1;
+    }
+
+    // keep the scratch ledgers away from real ledgers
+    QStandardPaths::setTestModeEnabled(true);
+    Setup setup;
+    setup.entries = arguments.value(2).toInt();
+    if (setup.entries <= 0)
+        setup.entries = DefaultEntries;
+    Ledger encrypted;
+    encrypted.path = LedgerCipher::ledgerPath(BenchUser);
+    Ledger plain;
+    plain.path = encrypted.path + ".plain";
+    setup.csvPath = encrypted.path + ".csv";
+    QDir().mkpath(QFileInfo(encrypted.path).absolutePath());
+    for (const QString &file : {encrypted.path, plain.path, LedgerCipher::logPath(BenchUser)}) {
+        QFile::remove(file);
+        QFile::remove(file + "-wal");
+        QFile::remove(file + "-shm");
+    }
+
+    {
+        auto session = std::make_unique<LedgerSession>(std::make_shared<User>(0, BenchUser, BenchPassword));
+        encrypted.key = session->ledgerKey();
+        setup.accountID = session->addAccount(BenchAccount);
+    }
+    QString error;
+    if (encrypted.key.isEmpty() || setup.accountID == 0) {
+        out << "Bench: scratch ledger could not be created at " << encrypted.path << "\n";
+        return 1;
+    }
+    if (!exportPlain(encrypted, plain.path, &error)) {
+        out << "Bench: unencrypted copy could not be exported: " << error << "\n";
+        return 1;
+    }
+    if (!writeCsv(setup)) {
+        out << "Bench: import file could not be written to " << setup.csvPath << "\n";
+        return 1;
+    }
+    out << QString("Bench: %1 entries, ledger %2\n").arg(setup.entries).arg(encrypted.path);
+    out.flush();
+
+    struct Step {
+        QString name;
+        Workload workload;
+        int rounds;
+    };
+    const Step steps[] = {
+        {"import", importWorkload(setup, false), 1},
+        {"reimport", importWorkload(setup, true), 1},
+        {"journal", journalWorkload(setup), 1},
+        {"table", tableWorkload(), Rounds},
+        {"plot", plotWorkload(), Rounds}
+    };
+    bool withinBudget = true;
+    for (const Step &step : steps) {
+        qint64 plainNs = -1;
+        qint64 encryptedNs = -1;
+        // alternate sides, so both see the same cache state
+        for (int round = 0; round < step.rounds; ++round) {
+            qint64 plainRound = measure(plain, step.workload, &error);
+            qint64 encryptedRound = plainRound < 0 ? -1 : measure(encrypted, step.workload, &error);
+            if (encryptedRound < 0) {
+                out << QString("Bench: %1 failed: %2\n").arg(step.name).arg(error);
+                return 1;
+            }
+            plainNs = plainNs < 0 ? plainRound : std::min(plainNs, plainRound);
+            encryptedNs = encryptedNs < 0 ? encryptedRound : std::min(encryptedNs, encryptedRound);
+        }
+        double overhead = double(encryptedNs) / std::max<qint64>(plainNs, 1) - 1;
+        bool ok = overhead <= MaxOverhead;
+        withinBudget = withinBudget && ok;
+        out << QString("Bench: %1 %2 ms plain, %3 ms encrypted, %4% overhead%5\n")
+                   .arg(step.name, -8).arg(plainNs / 1e6, 8, 'f', 1).arg(encryptedNs / 1e6, 8, 'f', 1)
+                   .arg(overhead * 100, 5, 'f', 1).arg(ok ? "" : ", over budget");
+        out.flush();
+    }
+    out << QString("Bench: encrypted workloads %1 within %2% of unencrypted ones\n")
+               .arg(withinBudget ? "are" : "are not").arg(MaxOverhead * 100, 0, 'f', 0);
+    return withinBudget ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QStringList>
+
+/**
+ * @brief The LedgerBench class
+ *        Throughput of encrypted against unencrypted ledgers, run as
+ *        "BudgetTracker --bench-cipher [entries]" instead of logging in.
+ *
+ *        A scratch ledger (in QStandardPaths test mode, so no real ledger
+ *        is touched) is created through a LedgerSession, which gives it the
+ *        current schema and encryption, and an unencrypted copy is exported
+ *        next to it. Both are opened through LedgerCipher::open, with and
+ *        without the key, and run the same workloads in turn:
+ *        - importing a CSV file of entries through EntryImporter, then the
+ *          same file again, finding every entry a duplicate;
+ *        - submitting batches of BatchEntries added entries through
+ *          EntryJournal;
+ *        - reading every row in table chunks of ChunkRows;
+ *        - plot sums of the whole ledger and of each category.
+ *        Read workloads take the best of Rounds runs. The encrypted time of
+ *        each workload is printed with its overhead over the unencrypted
+ *        one; more than 15% fails the benchmark.
+ */
+class LedgerBench
+{
+public:
+    static const int DefaultEntries = 20000;    // imported and journaled entries without an entries argument
+    static const int BatchEntries = 100;        // added entries per submitted batch
+    static const int ChunkRows = 500;           // rows per table chunk read
+    static const int Rounds = 3;                // runs of each read workload
+
+    static bool isRequested(int argc, char *argv[]);
+    static int run(const QStringList &arguments);
+};
@@ -0,0 +1,244 @@
+#include "LedgerCipher.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QPasswordDigestor>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+
+namespace {
+const char *CipherDriver = "QSQLCIPHER";
+const char *PlainDriver = "QSQLITE";
+const int KeyIterations = 256000;   // PBKDF2 rounds, paid once per login
+const int KeyLength = 32;           // AES-256 key
+const int BusyTimeoutMs = 5000;     // wait for other connections' locks before failing with SQLITE_BUSY
+}
+
+/**
+ * @brief LedgerCipher::isAvailable
+ * @return true if the SQLCipher driver plugin is installed
+ */
+bool LedgerCipher::isAvailable()
+{
+    return QSqlDatabase::isDriverAvailable(CipherDriver);
+}
+
+/**
+ * @brief LedgerCipher::driverName
+ * @return driver ledgers are opened with
+ */
+QString LedgerCipher::driverName()
+{
+    return isAvailable() ? CipherDriver : PlainDriver;
+}
+
+/**
+ * @brief LedgerCipher::deriveKey
+ *        Derives raw ledger key from login credentials with PBKDF2-SHA256.
+ *
+ *        Salted with the username, so equal passwords of different users
+ *        give different keys.
+ * @param username user's username
+ * @param password user's password
+ * @return 256-bit key
+ */
+QByteArray LedgerCipher::deriveKey(const QString &username, const QString &password)
+{
+    QByteArray salt = QByteArray("BudgetTracker ledger:") + username.toUtf8();
+    return QPasswordDigestor::deriveKeyPbkdf2(QCryptographicHash::Sha256, password.toUtf8(),
+                                              salt, KeyIterations, KeyLength);
+}
+
+/**
+ * @brief LedgerCipher::applyKey
+ *        Keys an open SQLCipher connection and checks the key is correct.
+ * @param database open connection
+ * @param key raw ledger key
+ * @return true if ledger can be read with key
+ */
+bool LedgerCipher::applyKey(QSqlDatabase &database, const QByteArray &key)
+{
+    QSqlQuery query(database);
+    if (!query.exec(QString("PRAGMA key = \"%1\"").arg(keyLiteral(key)))) {
+        qWarning() << "Ledger key rejected:" << query.lastError().text();
+        return false;
+    }
+    // SQLCipher only decrypts on first read, so a wrong key shows up here
+    if (!query.exec("SELECT COUNT(*) FROM sqlite_master")) {
+        qWarning() << "Ledger could not be decrypted:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief LedgerCipher::open
+ *        Opens ledger connection, keys it and sets its busy timeout.
+ *
+ *        Keys are per connection, so every connection to an encrypted
+ *        ledger, including cloned worker connections, must be opened here.
+ *        The ledger may be shared with worker threads and other instances
+ *        of the program, so a connection finding it locked retries for up
+ *        to BusyTimeoutMs instead of failing at once.
+ * @param database connection to open
+ * @param key raw ledger key; empty for an unencrypted ledger
+ * @return true if connection is open and readable
+ */
+bool LedgerCipher::open(QSqlDatabase &database, const QByteArray &key)
+{
+    if (!database.open())
+        return false;
+    if (!key.isEmpty() && !applyKey(database, key))
+        return false;
+    QSqlQuery query(database);
+    if (!query.exec(QString("PRAGMA busy_timeout = %1").arg(BusyTimeoutMs)))
+        qWarning() << "Ledger busy timeout not set:" << query.lastError().text();
+    return true;
+}
+
+/**
+ * @brief LedgerCipher::ledgerPath
+ * @param username user's username
+ * @return path of user's ledger database in AppData
+ */
+QString LedgerCipher::ledgerPath(const QString &username)
+{
+    QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return path + QDir::separator() + QString("%1.sqlite").arg(username);
+}
+
+/**
+ * @brief LedgerCipher::logPath
+ * @param username user's username
+ * @return path of user's entry log, next to the ledger
+ */
+QString LedgerCipher::logPath(const QString &username)
+{
+    return ledgerPath(username) + "-entrylog";
+}
+
+/**
+ * @brief LedgerCipher::isPlaintext
+ * @param path ledger path
+ * @return true if file starts with the plain SQLite header
+ */
+bool LedgerCipher::isPlaintext(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    return file.read(16) == QByteArray("SQLite format 3", 16);
+}
+
+/**
+ * @brief LedgerCipher::encryptFile
+ *        Converts an unencrypted ledger to an encrypted one in place.
+ *
+ *        The encrypted copy is written next to the ledger with
+ *        sqlcipher_export() and only replaces it once complete.
+ *        Missing and already encrypted ledgers are left alone.
+ * @param path ledger path
+ * @param key raw ledger key
+ * @return true if ledger is encrypted afterwards or does not exist
+ */
+bool LedgerCipher::encryptFile(const QString &path, const QByteArray &key)
+{
+    if (!QFile::exists(path) || !isPlaintext(path))
+        return true;
+
+    QString encryptedPath = path + ".encrypting";
+    QFile::remove(encryptedPath);
+
+    const QString connectionName = "ledger_encrypt";
+    bool exported = false;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(CipherDriver, connectionName);
+        database.setDatabaseName(path);
+        if (database.open()) {
+            QSqlQuery query(database);
+            query.prepare("ATTACH DATABASE ? AS encrypted KEY ?");
+            query.bindValue(0, encryptedPath);
+            query.bindValue(1, keyLiteral(key));
+            exported = query.exec();
+            // sqlcipher_export() copies schema and rows, but not the schema version
+            int userVersion = 0;
+            if (exported && query.exec("PRAGMA main.user_version") && query.next())
+                userVersion = query.value(0).toInt();
+            exported = exported
+                       && query.exec("SELECT sqlcipher_export('encrypted')")
+                       && query.exec(QString("PRAGMA encrypted.user_version = %1").arg(userVersion))
+                       && query.exec("DETACH DATABASE encrypted");
+            if (!exported)
+                qWarning() << "Ledger export failed:" << query.lastError().text();
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    if (!exported) {
+        QFile::remove(encryptedPath);
+        return false;
+    }
+
+    // keep the plaintext ledger until the encrypted one is in place
+    QString plaintextPath = path + ".plaintext";
+    QFile::remove(plaintextPath);
+    if (!QFile::rename(path, plaintextPath)) {
+        QFile::remove(encryptedPath);
+        return false;
+    }
+    if (!QFile::rename(encryptedPath, path)) {
+        QFile::rename(plaintextPath, path);
+        return false;
+    }
+    QFile::remove(plaintextPath);
+    return true;
+}
+
+/**
+ * @brief LedgerCipher::rekeyFile
+ *        Re-encrypts ledger under a new key, e.g. after a password change.
+ *
+ *        Missing and still unencrypted ledgers need no rekey; they are
+ *        encrypted with the new key on next login.
+ * @param path ledger path
+ * @param oldKey raw key ledger is currently encrypted with
+ * @param newKey raw key to encrypt ledger with
+ * @return true if ledger can be opened with newKey afterwards
+ */
+bool LedgerCipher::rekeyFile(const QString &path, const QByteArray &oldKey, const QByteArray &newKey)
+{
+    if (!QFile::exists(path) || isPlaintext(path))
+        return true;
+    if (!isAvailable())
+        return false;
+
+    const QString connectionName = "ledger_rekey";
+    bool rekeyed = false;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(CipherDriver, connectionName);
+        database.setDatabaseName(path);
+        if (open(database, oldKey)) {
+            QSqlQuery query(database);
+            rekeyed = query.exec(QString("PRAGMA rekey = \"%1\"").arg(keyLiteral(newKey)));
+            if (!rekeyed)
+                qWarning() << "Ledger rekey failed:" << query.lastError().text();
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return rekeyed;
+}
+
+/**
+ * @brief LedgerCipher::keyLiteral
+ * @param key raw ledger key
+ * @return SQLCipher raw key literal, x'<hex>'
+ */
+QString LedgerCipher::keyLiteral(const QByteArray &key)
+{
+    return QString("x'%1'").arg(QString::fromLatin1(key.toHex()));
+}
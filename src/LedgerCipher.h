@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QString>
+
+/**
+ * @brief The LedgerCipher class
+ *        Page-level encryption of user ledger databases.
+ *
+ *        Ledgers are opened with the SQLCipher driver when it is installed,
+ *        keyed with a raw 256-bit key derived once from the login password.
+ *        Passing a raw key skips SQLCipher's own per-connection key
+ *        derivation, so opening worker connections stays cheap. Without the
+ *        driver, ledgers fall back to plain QSQLITE and an empty key.
+ */
+class LedgerCipher
+{
+public:
+    // driver
+    static bool isAvailable();
+    static QString driverName();
+
+    // keys
+    static QByteArray deriveKey(const QString &username, const QString &password);
+    static bool applyKey(QSqlDatabase &database, const QByteArray &key);
+    static bool open(QSqlDatabase &database, const QByteArray &key);
+
+    // ledger files
+    static QString ledgerPath(const QString &username);
+    static QString logPath(const QString &username);
+    static bool isPlaintext(const QString &path);
+    static bool encryptFile(const QString &path, const QByteArray &key);
+    static bool rekeyFile(const QString &path, const QByteArray &oldKey, const QByteArray &newKey);
+
+private:
+    static QString keyLiteral(const QByteArray &key);
+};
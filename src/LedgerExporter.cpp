@@ -0,0 +1,328 @@
+#include "LedgerExporter.h"
+#include "LedgerCipher.h"
+#include "LedgerQuery.h"
+#include "Transaction.h"
+
+#include <QDataStream>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <climits>
+
+namespace {
+const char ColumnarMagic[] = "BTCOL1";      // columnar file signature and version
+
+/**
+ * @brief csvField
+ * @param field field text
+ * @return field quoted as RFC 4180 requires
+ */
+QByteArray csvField(const QString &field)
+{
+    QByteArray data = field.toUtf8();
+    if (!data.contains(',') && !data.contains('"') && !data.contains('\n') && !data.contains('\r'))
+        return data;
+    data.replace("\"", "\"\"");
+    return '"' + data + '"';
+}
+
+/**
+ * @brief writeCsv
+ *        Appends chunk of rows as CSV lines.
+ * @param file output file
+ * @param chunk rows to write
+ * @param accountNames account name by accountID
+ */
+void writeCsv(QIODevice &file, const QVector<Transaction> &chunk,
+              const QHash<qint64, QString> &accountNames)
+{
+    QByteArray data;
+    for (const Transaction &entry : chunk) {
+        data += QByteArray::number(entry.transactionID) + ','
+                + csvField(entry.date) + ','
+                + csvField(accountNames.value(entry.accountID)) + ','
+                + csvField(entry.category) + ','
+                + csvField(entry.subcategory) + ','
+                + QByteArray::number(entry.amount, 'g', 17) + ','
+                + csvField(entry.currency) + '\n';
+    }
+    file.write(data);
+}
+
+/**
+ * @brief writeJsonLines
+ *        Appends chunk of rows as one JSON object per line.
+ * @param file output file
+ * @param chunk rows to write
+ * @param accountNames account name by accountID
+ */
+void writeJsonLines(QIODevice &file, const QVector<Transaction> &chunk,
+                    const QHash<qint64, QString> &accountNames)
+{
+    QByteArray data;
+    for (const Transaction &entry : chunk) {
+        QJsonObject object;
+        object.insert("transactionID", entry.transactionID);
+        object.insert("date", entry.date);
+        object.insert("account", accountNames.value(entry.accountID));
+        object.insert("category", entry.category);
+        object.insert("subcategory", entry.subcategory);
+        object.insert("amount", entry.amount);
+        object.insert("currency", entry.currency);
+        data += QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n';
+    }
+    file.write(data);
+}
+
+/**
+ * @brief writeColumnar
+ *        Appends chunk of rows as one compressed row group.
+ *
+ *        A row group is its row count (quint32) followed by one block per
+ *        column, each a qCompress()ed QByteArray: transactionIDs and dates
+ *        (as julian days) delta-encoded as qint64, accountIDs as qint64,
+ *        categories, subcategories and currencies as QStringList, amounts
+ *        as double. A row count of 0 ends the file. Sorted, repetitive
+ *        columns compress far better than interleaved rows.
+ * @param stream output stream
+ * @param chunk rows to write
+ */
+void writeColumnar(QDataStream &stream, const QVector<Transaction> &chunk)
+{
+    QByteArray ids, dates, accounts, categories, subcategories, amounts, currencies;
+    QDataStream idStream(&ids, QIODevice::WriteOnly);
+    QDataStream dateStream(&dates, QIODevice::WriteOnly);
+    QDataStream accountStream(&accounts, QIODevice::WriteOnly);
+    QDataStream amountStream(&amounts, QIODevice::WriteOnly);
+    QStringList categoryList, subcategoryList, currencyList;
+
+    qint64 lastID = 0;
+    qint64 lastDay = 0;
+    for (const Transaction &entry : chunk) {
+        qint64 day = QDate::fromString(entry.date, "yyyy/MM/dd").toJulianDay();
+        idStream << entry.transactionID - lastID;
+        dateStream << day - lastDay;
+        accountStream << entry.accountID;
+        amountStream << entry.amount;
+        categoryList.append(entry.category);
+        subcategoryList.append(entry.subcategory);
+        currencyList.append(entry.currency);
+        lastID = entry.transactionID;
+        lastDay = day;
+    }
+    QDataStream(&categories, QIODevice::WriteOnly) << categoryList;
+    QDataStream(&subcategories, QIODevice::WriteOnly) << subcategoryList;
+    QDataStream(&currencies, QIODevice::WriteOnly) << currencyList;
+
+    stream << quint32(chunk.size());
+    for (const QByteArray *column : {&ids, &dates, &accounts, &categories,
+                                     &subcategories, &amounts, &currencies}) {
+        stream << qCompress(*column);
+    }
+}
+}
+
+/**
+ * @brief LedgerExporter::LedgerExporter
+ *        Creates exporter reading from clones of a database connection.
+ * @param connectionName name of open user database connection
+ * @param key raw ledger key; empty for an unencrypted ledger
+ * @param parent pointer to QObject parent object
+ */
+LedgerExporter::LedgerExporter(const QString &connectionName, const QByteArray &key,
+                               QObject *parent)
+    : QObject(parent)
+    , m_connectionName(connectionName)
+    , m_key(key)
+{
+    connect(&m_watcher, &QFutureWatcher<ExportResult>::progressValueChanged,
+            this, &LedgerExporter::progress);
+    connect(&m_watcher, &QFutureWatcher<ExportResult>::finished,
+            this, &LedgerExporter::done);
+}
+
+/**
+ * @brief LedgerExporter::~LedgerExporter
+ *        Cancels running export and waits for it, so its connection is
+ *        closed first.
+ */
+LedgerExporter::~LedgerExporter()
+{
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+}
+
+/**
+ * @brief LedgerExporter::start
+ *        Starts exporting entries matching filter to path.
+ * @param path output file; replaced only once the export completes
+ * @param format output format
+ * @param category category filter; empty for all entries
+ * @param subcategory subcategory filter
+ * @param accountID account filter; 0 for all accounts
+ * @param accountNames account name by accountID
+ * @return false if an export is already running
+ */
+bool LedgerExporter::start(const QString &path, Format format,
+                           const QString &category, const QString &subcategory, qint64 accountID,
+                           const QHash<qint64, QString> &accountNames)
+{
+    if (m_watcher.isRunning())
+        return false;
+    m_watcher.setFuture(QtConcurrent::run(&LedgerExporter::run, m_connectionName, m_key,
+                                          path, format, category, subcategory, accountID,
+                                          accountNames));
+    return true;
+}
+
+/**
+ * @brief LedgerExporter::cancel
+ *        Stops running export; the output file is left untouched.
+ */
+void LedgerExporter::cancel()
+{
+    m_watcher.cancel();
+}
+
+/**
+ * @brief LedgerExporter::isRunning
+ * @return true while an export is running
+ */
+bool LedgerExporter::isRunning() const
+{
+    return m_watcher.isRunning();
+}
+
+/**
+ * @brief LedgerExporter::formatForPath
+ * @param path output file path
+ * @return format matching file suffix; Csv if unknown
+ */
+LedgerExporter::Format LedgerExporter::formatForPath(const QString &path)
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "jsonl")
+        return JsonLines;
+    if (suffix == "btcol")
+        return Columnar;
+    return Csv;
+}
+
+/**
+ * @brief LedgerExporter::done
+ *        Reports finished (or cancelled) export.
+ */
+void LedgerExporter::done()
+{
+    if (m_watcher.isCanceled()) {
+        emit finished(0, "Export cancelled");
+        return;
+    }
+    ExportResult result = m_watcher.result();
+    emit finished(result.rows, result.error);
+}
+
+/**
+ * @brief LedgerExporter::run
+ *        Worker: streams matching entries to path in chunks of ChunkRows.
+ *
+ *        Output goes to a QSaveFile, so a failed or cancelled export
+ *        never leaves a partial file behind.
+ * @param promise reports rows written and observes cancellation
+ * @param connectionName connection to clone for this thread
+ * @param key raw ledger key; empty for an unencrypted ledger
+ * @param path output file
+ * @param format output format
+ * @param category category filter; empty for all entries
+ * @param subcategory subcategory filter
+ * @param accountID account filter; 0 for all accounts
+ * @param accountNames account name by accountID
+ */
+void LedgerExporter::run(QPromise<ExportResult> &promise,
+                         const QString &connectionName, const QByteArray &key,
+                         const QString &path, Format format,
+                         const QString &category, const QString &subcategory, qint64 accountID,
+                         const QHash<qint64, QString> &accountNames)
+{
+    ExportResult result;
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        result.error = file.errorString();
+        promise.addResult(result);
+        return;
+    }
+    QDataStream stream(&file);
+    if (format == Csv) {
+        file.write("transactionID,date,account,category,subcategory,amount,currency\n");
+    } else if (format == Columnar) {
+        stream.writeRawData(ColumnarMagic, sizeof(ColumnarMagic) - 1);
+        stream << QStringList{"transactionID", "date", "accountID", "category",
+                              "subcategory", "amount", "currency"};
+    }
+
+    QString workerConnection = QString("export_%1")
+                                   .arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    {
+        QSqlDatabase database = QSqlDatabase::cloneDatabase(connectionName, workerConnection);
+        if (!LedgerCipher::open(database, key)) {
+            result.error = database.lastError().text();
+        } else {
+            LedgerFilter filter;
+            filter.category = category;
+            filter.subcategory = subcategory;
+            filter.accountID = accountID;
+
+            QSqlQuery query(database);
+            query.setForwardOnly(true);
+            LedgerQuery::prepare<LedgerQuery::Entries>(query, filter);
+            if (!query.exec())
+                result.error = query.lastError().text();
+
+            QVector<Transaction> chunk;
+            chunk.reserve(ChunkRows);
+            bool more = result.error.isEmpty();
+            while (more && !promise.isCanceled()) {
+                more = query.next();
+                if (more) {
+                    chunk.append(LedgerQuery::readEntry(query));
+                }
+                if (chunk.size() == ChunkRows || (!more && !chunk.isEmpty())) {
+                    switch (format) {
+                    case Csv:
+                        writeCsv(file, chunk, accountNames);
+                        break;
+                    case JsonLines:
+                        writeJsonLines(file, chunk, accountNames);
+                        break;
+                    case Columnar:
+                        writeColumnar(stream, chunk);
+                        break;
+                    }
+                    result.rows += chunk.size();
+                    chunk.clear();
+                    promise.setProgressValue(int(std::min<qint64>(result.rows, INT_MAX)));
+                }
+            }
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(workerConnection);
+
+    if (promise.isCanceled()) {
+        file.cancelWriting();
+        return;
+    }
+    if (format == Columnar)
+        stream << quint32(0) << quint64(result.rows);
+    if (result.error.isEmpty() && !file.commit())
+        result.error = file.errorString();
+    promise.addResult(result);
+}
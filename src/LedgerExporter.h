@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QPromise>
+
+/**
+ * @brief The ExportResult struct
+ *        Outcome of one export run.
+ */
+struct ExportResult {
+    qint64 rows = 0;    // rows written
+    QString error;      // empty on success
+};
+
+/**
+ * @brief The LedgerExporter class
+ *        Streams filtered ledger entries to a file on a worker thread.
+ *
+ *        The worker reads on its own clone of the ledger connection with a
+ *        forward-only query and moves rows to the file in chunks of
+ *        ChunkRows, so memory use stays constant however many rows match.
+ *        Supported formats:
+ *        - Csv: RFC 4180 CSV with a header line.
+ *        - JsonLines: one compact JSON object per line.
+ *        - Columnar: row groups of ChunkRows rows, each column stored as
+ *          its own qCompress()ed block (see writeColumnar()).
+ *        Only submitted entries are exported; projected recurring entries
+ *        are not.
+ */
+class LedgerExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format { Csv, JsonLines, Columnar };
+
+    static const int ChunkRows = 4096;      // rows buffered between reads and writes
+
+    // constructor and destructor
+    LedgerExporter(const QString &connectionName, const QByteArray &key,
+                   QObject *parent = nullptr);
+    ~LedgerExporter();
+
+    // export requests
+    bool start(const QString &path, Format format,
+               const QString &category, const QString &subcategory, qint64 accountID,
+               const QHash<qint64, QString> &accountNames);
+    void cancel();
+    bool isRunning() const;
+
+    static Format formatForPath(const QString &path);
+
+signals:
+    void progress(qint64 rows);
+    void finished(qint64 rows, const QString &error);
+
+private slots:
+    void done();
+
+private:
+    QString m_connectionName;               // connection that workers clone
+    QByteArray m_key;                       // ledger key applied to each clone
+    QFutureWatcher<ExportResult> m_watcher;
+
+    static void run(QPromise<ExportResult> &promise,
+                    const QString &connectionName, const QByteArray &key,
+                    const QString &path, Format format,
+                    const QString &category, const QString &subcategory, qint64 accountID,
+                    const QHash<qint64, QString> &accountNames);
+};
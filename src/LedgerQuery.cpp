@@ -0,0 +1,70 @@
+#include "LedgerQuery.h"
+
+#include <QVariant>
+
+/**
+ * @brief LedgerQuery::mask
+ *        Filter dimensions that are set.
+ *
+ *        Subcategories are only unique within their category, so a
+ *        subcategory without category is not a filter.
+ * @param filter filter values
+ * @return Dimension flags
+ */
+unsigned LedgerQuery::mask(const LedgerFilter &filter)
+{
+    unsigned dimensions = 0;
+    if (!filter.category.isEmpty()) {
+        dimensions |= ByCategory;
+        if (!filter.subcategory.isEmpty())
+            dimensions |= BySubcategory;
+    }
+    if (filter.accountID != 0)
+        dimensions |= ByAccount;
+    if (!filter.fromDate.isEmpty())
+        dimensions |= FromDate;
+    if (!filter.untilDate.isEmpty())
+        dimensions |= UntilDate;
+    return dimensions;
+}
+
+/**
+ * @brief LedgerQuery::readEntry
+ * @param query query positioned on a row of an entry spec
+ * @return entry of current row
+ */
+Transaction LedgerQuery::readEntry(const QSqlQuery &query)
+{
+    Transaction entry;
+    entry.transactionID = query.value(0).toLongLong();
+    entry.date = query.value(1).toString();
+    entry.category = query.value(2).toString();
+    entry.subcategory = query.value(3).toString();
+    entry.amount = query.value(4).toDouble();
+    entry.currency = query.value(5).toString();
+    entry.accountID = query.value(6).toLongLong();
+    return entry;
+}
+
+/**
+ * @brief LedgerQuery::matches
+ *        Applies filter to an entry in memory, like the statements do.
+ * @param filter filter values
+ * @param entry entry to test
+ * @return true if a statement for filter would select entry
+ */
+bool LedgerQuery::matches(const LedgerFilter &filter, const Transaction &entry)
+{
+    unsigned dimensions = mask(filter);
+    if ((dimensions & ByCategory) && entry.category != filter.category)
+        return false;
+    if ((dimensions & BySubcategory) && entry.subcategory != filter.subcategory)
+        return false;
+    if ((dimensions & ByAccount) && entry.accountID != filter.accountID)
+        return false;
+    if ((dimensions & FromDate) && entry.date < filter.fromDate)
+        return false;
+    if ((dimensions & UntilDate) && entry.date > filter.untilDate)
+        return false;
+    return true;
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "Transaction.h"
+
+#include <QSqlQuery>
+#include <QString>
+
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief The LedgerFilter struct
+ *        Filter values of a budget table query.
+ *
+ *        Dimensions left unset match all rows.
+ */
+struct LedgerFilter {
+    QString category;           // empty for all categories
+    QString subcategory;        // empty for all; only applies together with category
+    qint64 accountID = 0;       // 0 for all accounts
+    QString fromDate;           // first date, "yyyy/MM/dd"; empty for no lower bound
+    QString untilDate;          // last date, "yyyy/MM/dd"; empty for no upper bound
+};
+
+/**
+ * @brief The LedgerQuery class
+ *        Budget table statements specialized per filter combination at compile time.
+ *
+ *        A statement is described once by a spec: its columns, an optional
+ *        leading condition and a tail for grouping, order and limit. For
+ *        each combination of filter dimensions the compiler assembles the
+ *        SQL text into a static array and instantiates a prepare function
+ *        binding exactly the dimensions of that combination. prepare() only
+ *        picks one of these by the filter's mask, so no SQL is assembled
+ *        while querying, and a new dimension is one more entry in Dimension
+ *        and Conditions rather than another set of hand-written variants.
+ *
+ *        Placeholders are ordered leading condition first, then filter
+ *        dimensions in Dimension order, then tail. Rows of specs selecting
+ *        all entry columns are read back with readEntry(), and matches()
+ *        applies the same filter to entries that are not stored yet.
+ */
+class LedgerQuery
+{
+public:
+    enum Dimension : unsigned {
+        ByCategory = 0x01,
+        BySubcategory = 0x02,
+        ByAccount = 0x04,
+        FromDate = 0x08,
+        UntilDate = 0x10
+    };
+    static const int DimensionCount = 5;
+    static const unsigned Combinations = 1u << DimensionCount;
+
+    // statement specs
+    struct PlotSums {           // per-currency daily sums for the plot
+        static constexpr const char *Columns = "date, currency, SUM(amount)";
+        static constexpr const char *Leading = "";
+        static constexpr const char *Tail = "GROUP BY date, currency ORDER BY date";
+        static const int LeadingBinds = 0;
+    };
+    struct TableChunk {         // next page of table rows after (date, transactionID)
+        static constexpr const char *Columns = "transactionID, date, category, subcategory, amount, currency, accountID";
+        static constexpr const char *Leading = "(date > ? OR (date = ? AND transactionID > ?))";
+        static constexpr const char *Tail = "ORDER BY date, transactionID LIMIT ?";
+        static const int LeadingBinds = 3;
+    };
+    struct NewEntries {         // entries stored after a transactionID
+        static constexpr const char *Columns = "transactionID, date, category, subcategory, amount, currency, accountID";
+        static constexpr const char *Leading = "transactionID > ?";
+        static constexpr const char *Tail = "";
+        static const int LeadingBinds = 1;
+    };
+    struct Entries {            // all entries in date order
+        static constexpr const char *Columns = "transactionID, date, category, subcategory, amount, currency, accountID";
+        static constexpr const char *Leading = "";
+        static constexpr const char *Tail = "ORDER BY date, transactionID";
+        static const int LeadingBinds = 0;
+    };
+
+    // querying
+    static unsigned mask(const LedgerFilter &filter);
+    template <class Spec>
+    static int prepare(QSqlQuery &query, const LedgerFilter &filter);
+    static Transaction readEntry(const QSqlQuery &query);
+    static bool matches(const LedgerFilter &filter, const Transaction &entry);
+
+private:
+    static constexpr const char *Conditions[DimensionCount] = {
+        "category = ?",
+        "subcategory = ?",
+        "accountID = ?",
+        "date >= ?",
+        "date <= ?"
+    };
+
+    struct Length {             // counts statement characters
+        std::size_t size = 0;
+        constexpr void append(const char *part) { while (*part++) ++size; }
+    };
+    template <std::size_t Size>
+    struct Text {               // statement characters, null terminated
+        char chars[Size + 1] = {};
+        std::size_t size = 0;
+        constexpr void append(const char *part) { while (*part) chars[size++] = *part++; }
+    };
+    template <class Spec, class Out>
+    static constexpr Out compose(Out out, unsigned mask);
+    template <class Spec, unsigned Mask>
+    struct Statement {
+        static constexpr std::size_t Size = compose<Spec>(Length(), Mask).size;
+        static constexpr Text<Size> Sql = compose<Spec>(Text<Size>(), Mask);
+    };
+
+    template <class Spec, unsigned Mask>
+    static int prepareStatement(QSqlQuery &query, const LedgerFilter &filter);
+    template <class Spec, std::size_t... Masks>
+    static int dispatch(QSqlQuery &query, const LedgerFilter &filter,
+                        std::index_sequence<Masks...>);
+};
+
+/**
+ * @brief LedgerQuery::prepare
+ *        Prepares spec's statement for filter and binds filter values.
+ *
+ *        Leading and tail placeholders are left for the caller to bind.
+ * @param query query to prepare
+ * @param filter filter values
+ * @return index of the first tail placeholder
+ */
+template <class Spec>
+int LedgerQuery::prepare(QSqlQuery &query, const LedgerFilter &filter)
+{
+    return dispatch<Spec>(query, filter, std::make_index_sequence<Combinations>());
+}
+
+/**
+ * @brief LedgerQuery::compose
+ *        Writes spec's statement for a filter combination.
+ *
+ *        Evaluated by the compiler, once with Length to size the text and
+ *        once with Text to fill it.
+ * @param out character sink
+ * @param mask filter dimensions
+ * @return out after writing
+ */
+template <class Spec, class Out>
+constexpr Out LedgerQuery::compose(Out out, unsigned mask)
+{
+    out.append("SELECT ");
+    out.append(Spec::Columns);
+    out.append(" FROM budget");
+    bool conditions = false;
+    if (*Spec::Leading) {
+        out.append(" WHERE ");
+        out.append(Spec::Leading);
+        conditions = true;
+    }
+    for (int i = 0; i < DimensionCount; ++i) {
+        if (mask & (1u << i)) {
+            out.append(conditions ? " AND " : " WHERE ");
+            out.append(Conditions[i]);
+            conditions = true;
+        }
+    }
+    if (*Spec::Tail) {
+        out.append(" ");
+        out.append(Spec::Tail);
+    }
+    return out;
+}
+
+/**
+ * @brief LedgerQuery::prepareStatement
+ *        Prepares the statement of one filter combination.
+ *
+ *        Its text is converted to a QString once per process.
+ * @param query query to prepare
+ * @param filter filter values
+ * @return index of the first tail placeholder
+ */
+template <class Spec, unsigned Mask>
+int LedgerQuery::prepareStatement(QSqlQuery &query, const LedgerFilter &filter)
+{
+    static const QString sql = QString::fromLatin1(Statement<Spec, Mask>::Sql.chars,
+                                                   Statement<Spec, Mask>::Size);
+    query.prepare(sql);
+    int index = Spec::LeadingBinds;
+    if constexpr ((Mask & ByCategory) != 0)
+        query.bindValue(index++, filter.category);
+    if constexpr ((Mask & BySubcategory) != 0)
+        query.bindValue(index++, filter.subcategory);
+    if constexpr ((Mask & ByAccount) != 0)
+        query.bindValue(index++, filter.accountID);
+    if constexpr ((Mask & FromDate) != 0)
+        query.bindValue(index++, filter.fromDate);
+    if constexpr ((Mask & UntilDate) != 0)
+        query.bindValue(index++, filter.untilDate);
+    return index;
+}
+
+/**
+ * @brief LedgerQuery::dispatch
+ *        Calls the prepare function of filter's combination from a table
+ *        holding one per combination.
+ * @param query query to prepare
+ * @param filter filter values
+ * @return index of the first tail placeholder
+ */
+template <class Spec, std::size_t... Masks>
+int LedgerQuery::dispatch(QSqlQuery &query, const LedgerFilter &filter,
+                          std::index_sequence<Masks...>)
+{
+    static constexpr int (*prepares[])(QSqlQuery &, const LedgerFilter &) = {
+        &prepareStatement<Spec, Masks>...
+    };
+    return prepares[mask(filter)](query, filter);
+}
@@ -0,0 +1,728 @@
+#include "LedgerSession.h"
+#include "EntryImporter.h"
+#include "LedgerCipher.h"
+#include "LedgerQuery.h"
+#include "SchemaMigrator.h"
+#include "StartupProfile.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+
+namespace {
+/**
+ * @brief addColumn
+ *        Adds column to a table created by an older version.
+ * @param query query on the ledger
+ * @param table table name
+ * @param column column name
+ * @param type column type
+ * @return true if column exists afterwards
+ */
+bool addColumn(QSqlQuery &query, const QString &table, const QString &column, const QString &type)
+{
+    if (!query.exec(QString("PRAGMA table_info(%1)").arg(table)))
+        return false;
+    while (query.next()) {
+        if (query.value(1).toString() == column)
+            return true;
+    }
+    return query.exec(QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table, column, type));
+}
+
+/**
+ * @brief createTables
+ *        Migration 1: creates all ledger tables and the default account.
+ *
+ *        Ledgers from before schema versioning already have some of the
+ *        tables; they only get the columns added since. Their recurring
+ *        rules are backfilled here, entries by backfillEntries().
+ * @param query query on the ledger
+ * @return true on success
+ */
+bool createTables(QSqlQuery &query)
+{
+    bool ok = query.exec("CREATE TABLE IF NOT EXISTS budget ("
+                         "transactionID INTEGER PRIMARY KEY, "
+                         "date VARCHAR(20), "
+                         "category VARCHAR(20), "
+                         "subcategory VARCHAR(20),"
+                         "amount DOUBLE, "
+                         "currency VARCHAR(3), "
+                         "accountID INTEGER)")
+              && query.exec("CREATE TABLE IF NOT EXISTS recurring ("
+                            "ruleID INTEGER PRIMARY KEY, "
+                            "category VARCHAR(20), "
+                            "subcategory VARCHAR(20), "
+                            "amount DOUBLE, "
+                            "startDate VARCHAR(20), "
+                            "intervalCount INTEGER, "
+                            "intervalUnit VARCHAR(10), "
+                            "endDate VARCHAR(20), "
+                            "currency VARCHAR(3), "
+                            "accountID INTEGER)")
+              && query.exec("CREATE TABLE IF NOT EXISTS rates ("
+                            "date VARCHAR(20), "
+                            "currency VARCHAR(3), "
+                            "rate DOUBLE, "
+                            "PRIMARY KEY (date, currency))")
+              && query.exec("CREATE TABLE IF NOT EXISTS target ("
+                            "category VARCHAR(20) PRIMARY KEY, "
+                            "amount DOUBLE, "
+                            "currency VARCHAR(3))")
+              && query.exec("CREATE TABLE IF NOT EXISTS log_batch ("
+                            "id INTEGER PRIMARY KEY, "
+                            "batch INTEGER)")
+              && query.exec("CREATE TABLE IF NOT EXISTS account ("
+                            "accountID INTEGER PRIMARY KEY, "
+                            "name VARCHAR(20) UNIQUE)")
+              && addColumn(query, "budget", "currency", "VARCHAR(3)")
+              && addColumn(query, "recurring", "currency", "VARCHAR(3)")
+              && addColumn(query, "budget", "accountID", "INTEGER")
+              && addColumn(query, "recurring", "accountID", "INTEGER");
+    if (!ok)
+        return false;
+
+    query.prepare("INSERT OR IGNORE INTO account "
+                  "(accountID, name) "
+                  "VALUES (?, ?)");
+    query.bindValue(0, AccountList::DefaultAccountID);
+    query.bindValue(1, "Main");
+    if (!query.exec())
+        return false;
+
+    // few rules, so no need to chunk
+    query.prepare("UPDATE recurring "
+                  "SET currency = COALESCE(currency, ?), accountID = COALESCE(accountID, ?) "
+                  "WHERE currency IS NULL OR accountID IS NULL");
+    query.bindValue(0, ExchangeRates::homeCurrency());
+    query.bindValue(1, AccountList::DefaultAccountID);
+    return query.exec();
+}
+
+/**
+ * @brief backfillEntries
+ *        Migration 2 chunk: assigns home currency and default account to
+ *        entries made before currencies and accounts existed.
+ *
+ *        Walks entries in transactionID order, so each chunk is a range of
+ *        the primary key and the cursor is the last transactionID visited.
+ * @param query query on the ledger
+ * @param cursor last transactionID of the previous chunk; advanced
+ * @param rows entries to visit at most
+ * @return entries visited; 0 when done; -1 on error
+ */
+int backfillEntries(QSqlQuery &query, qint64 *cursor, int rows)
+{
+    query.prepare("SELECT MAX(transactionID), COUNT(*) "
+                  "FROM (SELECT transactionID "
+                  "FROM budget "
+                  "WHERE transactionID > ? "
+                  "ORDER BY transactionID "
+                  "LIMIT ?)");
+    query.bindValue(0, *cursor);
+    query.bindValue(1, rows);
+    if (!query.exec() || !query.next())
+        return -1;
+    int visited = query.value(1).toInt();
+    if (visited == 0)
+        return 0;
+    qint64 last = query.value(0).toLongLong();
+
+    query.prepare("UPDATE budget "
+                  "SET currency = COALESCE(currency, ?), accountID = COALESCE(accountID, ?) "
+                  "WHERE transactionID > ? AND transactionID <= ? "
+                  "AND (currency IS NULL OR accountID IS NULL)");
+    query.bindValue(0, ExchangeRates::homeCurrency());
+    query.bindValue(1, AccountList::DefaultAccountID);
+    query.bindValue(2, *cursor);
+    query.bindValue(3, last);
+    if (!query.exec())
+        return -1;
+    *cursor = last;
+    return visited;
+}
+
+/**
+ * @brief indexByAccount
+ *        Migration 3: per-account streams are read in (accountID, date,
+ *        transactionID) order.
+ * @param query query on the ledger
+ * @return true on success
+ */
+bool indexByAccount(QSqlQuery &query)
+{
+    return query.exec("CREATE INDEX IF NOT EXISTS budget_account_date "
+                      "ON budget (accountID, date, transactionID)");
+}
+
+/**
+ * @brief indexByDate
+ *        Migration 4: tables page through entries in (date, transactionID)
+ *        order.
+ * @param query query on the ledger
+ * @return true on success
+ */
+bool indexByDate(QSqlQuery &query)
+{
+    return query.exec("CREATE INDEX IF NOT EXISTS budget_date "
+                      "ON budget (date, transactionID)");
+}
+
+/**
+ * @brief addFingerprints
+ *        Migration 5: entries carry an indexed fingerprint, so imports can
+ *        find duplicates without comparing rows.
+ * @param query query on the ledger
+ * @return true on success
+ */
+bool addFingerprints(QSqlQuery &query)
+{
+    return addColumn(query, "budget", "fingerprint", "INTEGER")
+           && query.exec("CREATE INDEX IF NOT EXISTS budget_fingerprint "
+                         "ON budget (fingerprint)");
+}
+
+/**
+ * @brief backfillFingerprints
+ *        Migration 6 chunk: fingerprints entries stored before migration 5.
+ *
+ *        Fingerprints are hashed in C++, so each chunk of entries is read
+ *        in transactionID order and updated row by row.
+ * @param query query on the ledger
+ * @param cursor last transactionID of the previous chunk; advanced
+ * @param rows entries to visit at most
+ * @return entries visited; 0 when done; -1 on error
+ */
+int backfillFingerprints(QSqlQuery &query, qint64 *cursor, int rows)
+{
+    query.prepare("SELECT transactionID, date, category, subcategory, amount, currency, accountID "
+                  "FROM budget "
+                  "WHERE transactionID > ? "
+                  "ORDER BY transactionID "
+                  "LIMIT ?");
+    query.bindValue(0, *cursor);
+    query.bindValue(1, rows);
+    if (!query.exec())
+        return -1;
+    QVector<Transaction> entries;
+    while (query.next())
+        entries.append(LedgerQuery::readEntry(query));
+    if (entries.isEmpty())
+        return 0;
+
+    query.prepare("UPDATE budget "
+                  "SET fingerprint = ? "
+                  "WHERE transactionID = ?");
+    for (const Transaction &entry : entries) {
+        query.bindValue(0, EntryImporter::fingerprint(entry));
+        query.bindValue(1, entry.transactionID);
+        if (!query.exec())
+            return -1;
+    }
+    *cursor = entries.last().transactionID;
+    return entries.size();
+}
+}
+
+/**
+ * @brief LedgerSession::LedgerSession
+ *        Opens user's ledger on its own connection, loads the shared
+ *        indexes and replays entries logged before an unclean shutdown.
+ * @param user logged in user
+ * @param parent pointer to QObject parent object
+ */
+LedgerSession::LedgerSession(std::shared_ptr<User> user, QObject *parent)
+    : QObject(parent)
+    , m_user(user)
+    , m_connectionName(QString("ledger_%1").arg(user->getUserID()))
+    , entryJournal(nullptr)
+    , entryLog(nullptr)
+    , balanceForecaster(nullptr)
+{
+    setupDatabase();
+    StartupProfile::mark("ledger opened");
+    m_categoryIndex.load(database());
+    m_recurringSchedule.load(database());
+    m_exchangeRates.load(database());
+    m_accounts.load(database());
+    m_budgetTargets.load(database(), &m_exchangeRates);
+    m_anomalies.load(database(), &m_exchangeRates);
+    balanceForecaster = new BalanceForecaster(m_connectionName, m_ledgerKey, this);
+    balanceForecaster->setRates(m_exchangeRates);
+    StartupProfile::mark("ledger indexes loaded");
+
+    // connected before any window, so shared state is updated before views refresh
+    entryJournal = new EntryJournal(database(), this);
+    connect(entryJournal, &EntryJournal::entryAdded,
+            this, &LedgerSession::entryAdded);
+    connect(entryJournal, &EntryJournal::entryRemoved,
+            this, &LedgerSession::entryRemoved);
+    connect(entryJournal, &EntryJournal::entryChanged,
+            this, &LedgerSession::entryChanged);
+    connect(entryJournal, &EntryJournal::submitted,
+            this, &LedgerSession::entriesSubmitted);
+
+    entryLog = new EntryLog(LedgerCipher::logPath(user->getUsername()), m_ledgerKey, this);
+    if (entryLog->open()) {
+        // replayed after the indexes are loaded, so they count recovered entries like new ones
+        entryJournal->setLog(entryLog);
+        m_recovered = entryJournal->replay();
+    } else {
+        if (!m_logError.isEmpty())
+            m_logError += "\n\n";
+        m_logError += QString("The entry log could not be opened, so pending entries may be "
+                              "lost if the program stops unexpectedly. Submit them to keep "
+                              "them.\n\n%1").arg(entryLog->lastError());
+    }
+    StartupProfile::mark("entry log replayed");
+    connect(entryLog, &EntryLog::failed,
+            this, &LedgerSession::logFailed);
+}
+
+/**
+ * @brief LedgerSession::~LedgerSession
+ *        Closes the ledger connection; unsubmitted entries are left in the
+ *        entry log.
+ *
+ *        Everything holding a handle to the connection is released first,
+ *        so it can be removed cleanly and reopened by a later login.
+ */
+LedgerSession::~LedgerSession()
+{
+    delete balanceForecaster;
+    delete entryJournal;
+    delete entryLog;
+    m_recurringSchedule = RecurringSchedule();
+    m_accounts = AccountList();
+    m_budgetTargets = BudgetTargets();
+    {
+        QSqlDatabase db = database();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+/**
+ * @brief LedgerSession::user
+ * @return user the session belongs to
+ */
+std::shared_ptr<User> LedgerSession::user() const
+{
+    return m_user;
+}
+
+/**
+ * @brief LedgerSession::database
+ * @return session's ledger connection
+ */
+QSqlDatabase LedgerSession::database() const
+{
+    return QSqlDatabase::database(m_connectionName, false);
+}
+
+/**
+ * @brief LedgerSession::ledgerKey
+ * @return raw ledger key for worker connections; empty if unencrypted
+ */
+QByteArray LedgerSession::ledgerKey() const
+{
+    return m_ledgerKey;
+}
+
+/**
+ * @brief LedgerSession::journal
+ * @return journal of pending entry operations, shared by all windows
+ */
+EntryJournal *LedgerSession::journal() const
+{
+    return entryJournal;
+}
+
+/**
+ * @brief LedgerSession::forecaster
+ * @return forecaster shared by all windows
+ */
+BalanceForecaster *LedgerSession::forecaster() const
+{
+    return balanceForecaster;
+}
+
+/**
+ * @brief LedgerSession::categoryIndex
+ * @return frequency-ranked category index
+ */
+CategoryIndex *LedgerSession::categoryIndex()
+{
+    return &m_categoryIndex;
+}
+
+/**
+ * @brief LedgerSession::schedule
+ * @return recurring transaction rules; call notifyScheduleChanged() after editing
+ */
+RecurringSchedule *LedgerSession::schedule()
+{
+    return &m_recurringSchedule;
+}
+
+/**
+ * @brief LedgerSession::rates
+ * @return exchange rates and display currency
+ */
+ExchangeRates *LedgerSession::rates()
+{
+    return &m_exchangeRates;
+}
+
+/**
+ * @brief LedgerSession::accounts
+ * @return accounts of the ledger
+ */
+AccountList *LedgerSession::accounts()
+{
+    return &m_accounts;
+}
+
+/**
+ * @brief LedgerSession::budgetTargets
+ * @return budget targets and this month's spending
+ */
+BudgetTargets *LedgerSession::budgetTargets()
+{
+    return &m_budgetTargets;
+}
+
+/**
+ * @brief LedgerSession::anomalies
+ * @return amount statistics flagging unusual entries
+ */
+AnomalyDetector *LedgerSession::anomalies()
+{
+    return &m_anomalies;
+}
+
+/**
+ * @brief LedgerSession::recoveredCount
+ * @return pending operations replayed on open; -1 if replay failed
+ */
+int LedgerSession::recoveredCount() const
+{
+    return m_recovered;
+}
+
+/**
+ * @brief LedgerSession::logError
+ * @return message on why the entry log could not be opened or had to be
+ *         recreated; empty if neither
+ */
+QString LedgerSession::logError() const
+{
+    return m_logError;
+}
+
+/**
+ * @brief LedgerSession::attachWindow
+ *        Counts a newly opened window on this session.
+ */
+void LedgerSession::attachWindow()
+{
+    ++m_windowCount;
+}
+
+/**
+ * @brief LedgerSession::detachWindow
+ *        Uncounts a closed window, announcing when none are left.
+ */
+void LedgerSession::detachWindow()
+{
+    if (--m_windowCount == 0)
+        emit lastWindowDetached();
+}
+
+/**
+ * @brief LedgerSession::windowCount
+ * @return number of open windows on this session
+ */
+int LedgerSession::windowCount() const
+{
+    return m_windowCount;
+}
+
+/**
+ * @brief LedgerSession::setDisplayCurrency
+ *        Switches display currency of all windows.
+ * @param currency ISO 4217 code
+ */
+void LedgerSession::setDisplayCurrency(const QString &currency)
+{
+    if (currency.isEmpty() || currency == m_exchangeRates.displayCurrency())
+        return;
+    m_exchangeRates.setDisplayCurrency(currency);
+    balanceForecaster->setRates(m_exchangeRates);
+    m_budgetTargets.load(database(), &m_exchangeRates);
+    m_anomalies.load(database(), &m_exchangeRates);
+    countPending();
+    emit ratesChanged();
+}
+
+/**
+ * @brief LedgerSession::importRates
+ *        Imports exchange rates from a local CSV file.
+ *
+ *        Rates are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ * @param path CSV file path
+ * @param error receives error message on failure, if not null
+ * @return number of rates imported; -1 on failure
+ */
+int LedgerSession::importRates(const QString &path, QString *error)
+{
+    QSqlDatabase db = database();
+    int count = ExchangeRates::importFile(db, path, error);
+    if (count < 0)
+        return count;
+
+    m_exchangeRates.load(db);
+    balanceForecaster->setRates(m_exchangeRates);
+    m_budgetTargets.load(db, &m_exchangeRates);
+    m_anomalies.load(db, &m_exchangeRates);
+    countPending();
+    emit ratesChanged();
+    return count;
+}
+
+/**
+ * @brief LedgerSession::importEntries
+ *        Imports entries from a CSV file, skipping those already stored.
+ *
+ *        Entries are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ * @param path CSV file path
+ * @param accountID account of entries without a known account name
+ * @return counts of imported, duplicate and skipped entries, or error
+ */
+ImportResult LedgerSession::importEntries(const QString &path, qint64 accountID)
+{
+    QSqlDatabase db = database();
+    ImportResult result = EntryImporter::importFile(db, path, m_accounts, accountID);
+    if (!result.error.isEmpty() || result.imported == 0)
+        return result;
+
+    m_categoryIndex.load(db);
+    m_budgetTargets.load(db, &m_exchangeRates);
+    m_anomalies.load(db, &m_exchangeRates);
+    emit categoriesChanged();
+    emit entriesImported();
+    return result;
+}
+
+/**
+ * @brief LedgerSession::addAccount
+ *        Stores a new account.
+ *
+ *        Accounts are committed right away, so pending entries must be
+ *        submitted or discarded first.
+ * @param name account name
+ * @return accountID of new account; 0 on failure
+ */
+qint64 LedgerSession::addAccount(const QString &name)
+{
+    qint64 accountID = m_accounts.addAccount(name);
+    if (accountID != 0)
+        emit accountsChanged();
+    return accountID;
+}
+
+/**
+ * @brief LedgerSession::setBudgetTarget
+ *        Stores monthly target for category.
+ * @param category category to limit
+ * @param amount monthly limit on net spending
+ * @param currency ISO 4217 code of amount
+ * @return true if target was stored
+ */
+bool LedgerSession::setBudgetTarget(const QString &category, double amount, const QString &currency)
+{
+    if (!m_budgetTargets.setTarget(category, amount, currency))
+        return false;
+    emit budgetChanged(category, BudgetStatus::Under);
+    return true;
+}
+
+/**
+ * @brief LedgerSession::removeBudgetTarget
+ *        Deletes target of category.
+ * @param category category whose target to delete
+ * @return true if target was deleted
+ */
+bool LedgerSession::removeBudgetTarget(const QString &category)
+{
+    if (!m_budgetTargets.removeTarget(category))
+        return false;
+    emit budgetChanged(category, BudgetStatus::Over);
+    return true;
+}
+
+/**
+ * @brief LedgerSession::notifyScheduleChanged
+ *        Announces that recurring rules were edited.
+ */
+void LedgerSession::notifyScheduleChanged()
+{
+    emit scheduleChanged();
+}
+
+/**
+ * @brief LedgerSession::entryAdded
+ *        Counts added (or restored) entry in category index, budget and
+ *        amount statistics.
+ *
+ *        Connected to EntryJournal entryAdded signal.
+ * @param entry added entry
+ */
+void LedgerSession::entryAdded(const Transaction &entry)
+{
+    m_categoryIndex.addEntry(entry.category, entry.subcategory);
+    m_anomalies.addEntry(entry);
+    emit categoriesChanged();
+
+    BudgetStatus::State previous = m_budgetTargets.status(entry.category).state;
+    m_budgetTargets.addEntry(entry);
+    emit budgetChanged(entry.category, previous);
+}
+
+/**
+ * @brief LedgerSession::entryRemoved
+ *        Uncounts removed (or undone) entry in category index, budget and
+ *        amount statistics, and marks cached forecast aggregates as stale.
+ *
+ *        Connected to EntryJournal entryRemoved signal.
+ * @param entry removed entry
+ */
+void LedgerSession::entryRemoved(const Transaction &entry)
+{
+    m_forecastStale = true;
+    m_categoryIndex.removeEntry(entry.category, entry.subcategory);
+    m_anomalies.removeEntry(entry);
+    emit categoriesChanged();
+
+    BudgetStatus::State previous = m_budgetTargets.status(entry.category).state;
+    m_budgetTargets.removeEntry(entry);
+    emit budgetChanged(entry.category, previous);
+}
+
+/**
+ * @brief LedgerSession::entryChanged
+ *        Moves edited entry's count to its new category in category index,
+ *        budget and amount statistics, and marks cached forecast aggregates as stale.
+ *
+ *        Connected to EntryJournal entryChanged signal.
+ * @param before entry before change
+ * @param after entry after change
+ */
+void LedgerSession::entryChanged(const Transaction &before, const Transaction &after)
+{
+    m_forecastStale = true;
+    m_categoryIndex.removeEntry(before.category, before.subcategory);
+    m_categoryIndex.addEntry(after.category, after.subcategory);
+    m_anomalies.removeEntry(before);
+    m_anomalies.addEntry(after);
+    emit categoriesChanged();
+
+    BudgetStatus::State previous = m_budgetTargets.status(after.category).state;
+    m_budgetTargets.removeEntry(before);
+    m_budgetTargets.addEntry(after);
+    emit budgetChanged(after.category, previous);
+}
+
+/**
+ * @brief LedgerSession::entriesSubmitted
+ *        Drops forecast aggregates invalidated by submitted edits/removes.
+ *
+ *        Connected to EntryJournal submitted signal.
+ */
+void LedgerSession::entriesSubmitted()
+{
+    // forecast aggregates only fold in new entries, so edits/removes need a rebuild
+    if (m_forecastStale) {
+        balanceForecaster->invalidate();
+        m_forecastStale = false;
+    }
+}
+
+/**
+ * @brief LedgerSession::countPending
+ *        Counts pending entries into budget and amount statistics just
+ *        reloaded from the ledger, which only has stored entries.
+ */
+void LedgerSession::countPending()
+{
+    for (const Transaction &entry : entryJournal->replacedEntries()) {
+        m_anomalies.removeEntry(entry);
+        m_budgetTargets.removeEntry(entry);
+    }
+    for (const Transaction &entry : entryJournal->pendingEntries()) {
+        m_anomalies.addEntry(entry);
+        m_budgetTargets.addEntry(entry);
+    }
+}
+
+/**
+ * @brief LedgerSession::setupDatabase
+ *        Opens session's connection to the user's SQLite ledger, and
+ *        creates or migrates its tables to the current schema version.
+ *
+ *        If the SQLCipher driver is available, the ledger is encrypted
+ *        with a key derived from the user's password, converting an
+ *        existing unencrypted ledger first. If only the entry log cannot be
+ *        converted, it is moved aside and recreated encrypted instead, so
+ *        the ledger keeps its encryption; the loss is reported via logError().
+ */
+void LedgerSession::setupDatabase()
+{
+    QString path = LedgerCipher::ledgerPath(m_user->getUsername());
+    if (LedgerCipher::isAvailable()) {
+        m_ledgerKey = LedgerCipher::deriveKey(m_user->getUsername(), m_user->getPassword());
+        QString logPath = LedgerCipher::logPath(m_user->getUsername());
+        if (!LedgerCipher::encryptFile(path, m_ledgerKey)) {
+            qWarning() << "Ledger left unencrypted:" << path;
+            m_ledgerKey.clear();
+        } else if (!LedgerCipher::encryptFile(logPath, m_ledgerKey)) {
+            // the old log's SQLite files move together, so it stays readable by hand
+            for (const QString &suffix : {"", "-wal", "-shm"}) {
+                QFile::remove(logPath + suffix + ".unencrypted");
+                if (QFile::exists(logPath + suffix)
+                    && !QFile::rename(logPath + suffix, logPath + suffix + ".unencrypted")) {
+                    QFile::remove(logPath + suffix);
+                }
+            }
+            qWarning() << "Entry log could not be encrypted, recreated:" << logPath;
+            m_logError = QString("The entry log could not be encrypted and was replaced by a new "
+                                 "one. Unsubmitted entries of the last session were not "
+                                 "recovered; the old log was kept as %1.")
+                             .arg(logPath + ".unencrypted");
+        }
+    }
+
+    QSqlDatabase db = QSqlDatabase::addDatabase(LedgerCipher::driverName(), m_connectionName);
+    db.setDatabaseName(path);
+    if (!LedgerCipher::open(db, m_ledgerKey))
+        qWarning() << "Ledger could not be opened:" << path;
+    // in WAL mode, worker connections and other instances can still read
+    // while a batch of entries is being written
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA journal_mode = WAL"))
+        qWarning() << "Ledger WAL mode not set:" << query.lastError().text();
+
+    SchemaMigrator migrator(db);
+    migrator.add(1, "create tables", createTables);
+    migrator.addChunked(2, "backfill entry currencies and accounts", backfillEntries);
+    migrator.add(3, "index entries by account", indexByAccount);
+    migrator.add(4, "index entries by date", indexByDate);
+    migrator.add(5, "add entry fingerprints", addFingerprints);
+    migrator.addChunked(6, "fingerprint entries", backfillFingerprints);
+    if (!migrator.migrate())
+        qWarning() << "Ledger schema not up to date:" << migrator.lastError();
+}
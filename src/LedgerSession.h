@@ -0,0 +1,104 @@
+#pragma once
+
+#include "AccountList.h"
+#include "AnomalyDetector.h"
+#include "BalanceForecaster.h"
+#include "BudgetTargets.h"
+#include "CategoryIndex.h"
+#include "EntryImporter.h"
+#include "EntryJournal.h"
+#include "EntryLog.h"
+#include "ExchangeRates.h"
+#include "RecurringSchedule.h"
+#include "User.h"
+
+#include <QObject>
+#include <QSqlDatabase>
+
+/**
+ * @brief The LedgerSession class
+ *        A logged-in user's open ledger and everything cached from it.
+ *
+ *        Owns the user's named ledger connection, entry journal and log,
+ *        forecaster and the in-memory indexes (categories, recurring rules,
+ *        rates, accounts, budget targets, amount statistics). Every BudgetTracker window of the
+ *        user shares one session, so the ledger is opened and loaded once and
+ *        pending entries are the same in all windows. Changes to shared data
+ *        are applied here once and announced through signals, which windows
+ *        use to refresh their own views.
+ */
+class LedgerSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    // constructor and destructor
+    explicit LedgerSession(std::shared_ptr<User> user, QObject *parent = nullptr);
+    ~LedgerSession();
+
+    // getters
+    std::shared_ptr<User> user() const;
+    QSqlDatabase database() const;
+    QByteArray ledgerKey() const;
+    EntryJournal *journal() const;
+    BalanceForecaster *forecaster() const;
+    CategoryIndex *categoryIndex();
+    RecurringSchedule *schedule();
+    ExchangeRates *rates();
+    AccountList *accounts();
+    BudgetTargets *budgetTargets();
+    AnomalyDetector *anomalies();
+    int recoveredCount() const;
+    QString logError() const;
+
+    // windows
+    void attachWindow();
+    void detachWindow();
+    int windowCount() const;
+
+    // shared changes
+    void setDisplayCurrency(const QString &currency);
+    int importRates(const QString &path, QString *error = nullptr);
+    ImportResult importEntries(const QString &path, qint64 accountID);
+    qint64 addAccount(const QString &name);
+    bool setBudgetTarget(const QString &category, double amount, const QString &currency);
+    bool removeBudgetTarget(const QString &category);
+    void notifyScheduleChanged();
+
+signals:
+    void ratesChanged();
+    void accountsChanged();
+    void scheduleChanged();
+    void categoriesChanged();
+    void entriesImported();
+    void budgetChanged(const QString &category, BudgetStatus::State previous);
+    void logFailed(const QString &error);
+    void lastWindowDetached();
+
+private slots:
+    void entryAdded(const Transaction &entry);
+    void entryRemoved(const Transaction &entry);
+    void entryChanged(const Transaction &before, const Transaction &after);
+    void entriesSubmitted();
+
+private:
+    std::shared_ptr<User> m_user;           // user the ledger belongs to
+    QString m_connectionName;               // named ledger connection of this session
+    QByteArray m_ledgerKey;                 // raw ledger encryption key; empty if unencrypted
+    EntryJournal *entryJournal;             // pending (unsubmitted) entry operations
+    EntryLog *entryLog;                     // durable log of entryJournal's pending operations
+    BalanceForecaster *balanceForecaster;   // forecasts for all windows, cached per filter
+    CategoryIndex m_categoryIndex;          // frequency-ranked category/subcategory index
+    RecurringSchedule m_recurringSchedule;  // recurring transaction rules
+    ExchangeRates m_exchangeRates;          // rates and display currency
+    AccountList m_accounts;                 // accounts entries belong to
+    BudgetTargets m_budgetTargets;          // monthly category targets and spending
+    AnomalyDetector m_anomalies;            // amount statistics per category, flags unusual entries
+    int m_recovered = 0;                    // operations replayed from entryLog; -1 if replay failed
+    QString m_logError;                     // why entryLog could not be opened or was recreated; empty if neither
+    int m_windowCount = 0;                  // open windows on this session
+    bool m_forecastStale = false;           // pending edits/removes invalidate forecast aggregates
+
+    void countPending();
+    void setupDatabase();
+};
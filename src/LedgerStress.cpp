@@ -0,0 +1,654 @@
+#include "LedgerStress.h"
+#include "AccountList.h"
+#include "EntryImporter.h"
+#include "EntryJournal.h"
+#include "ExchangeRates.h"
+#include "LedgerCipher.h"
+#include "LedgerQuery.h"
+#include "LedgerSession.h"
+#include "User.h"
+
+#include <QCoreApplication>
+#include <QDate>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+const char *StressUser = "stress";          // user of the scratch ledger
+const char *StressPassword = "stress";      // derives the scratch ledger's key
+const int MaxBatchOperations = 20;          // journal operations per submitted batch
+const int MaxImportEntries = 50;            // fresh entries per import file
+const int MaxAmountCents = 50000;           // largest random amount, in cents
+const int DateRangeDays = 2500;             // random dates from 2020/01/01 on
+const int ChildGraceMs = 60000;             // child run time allowed beyond the deadline
+
+/**
+ * @brief The WorkerResult struct
+ *        What one writer did, and the balance its account should have.
+ */
+struct WorkerResult {
+    int worker = 0;             // writer index; names its account
+    qint64 expectedCents = 0;   // account balance per the writer's model
+    qint64 operations = 0;      // journal operations, and entries imported or exported
+    int submits = 0;            // batches committed
+    int imports = 0;            // import files committed
+    int exports = 0;            // exports read and imported again
+    int busy = 0;               // submits and imports that failed with SQLITE_BUSY
+    int failures = 0;           // batches and imports that failed otherwise, or too often
+    int mismatches = 0;         // reads and imports that disagreed with the model
+    qint64 maxSubmitMs = 0;     // slowest submit, including lock waits
+};
+
+/**
+ * @brief The Writer struct
+ *        State of one writer thread.
+ */
+struct Writer {
+    QRandomGenerator random;
+    QSqlDatabase database;              // the writer's own connection
+    EntryJournal *journal = nullptr;    // journal on database
+    AccountList accounts;               // resolves account names of imported lines
+    qint64 accountID = 0;               // account only this writer writes to
+    QString csvPath;                    // scratch file of imports and exports
+    QVector<qint64> ids;                // submitted journal entries, targets of edits and removes
+    QVector<Transaction> lastImport;    // fresh entries of the previous import
+    qint64 serial = 0;                  // numbers imported entries so none are alike
+    WorkerResult result;
+};
+
+/**
+ * @brief accountName
+ * @param worker writer index
+ * @return name of the account the writer writes to
+ */
+QString accountName(int worker)
+{
+    return QString("Stress %1").arg(worker);
+}
+
+/**
+ * @brief writerSeed
+ * @param seed seed of the whole run
+ * @param worker writer index
+ * @return seed of the writer's random choices, the same in every process
+ */
+quint32 writerSeed(quint32 seed, int worker)
+{
+    return seed + quint32(worker) * 0x9e3779b9u;
+}
+
+/**
+ * @brief cents
+ * @param amount amount as stored
+ * @return amount in whole cents
+ */
+qint64 cents(double amount)
+{
+    return qRound64(amount * 100);
+}
+
+/**
+ * @brief isBusy
+ * @param error error text of a failed statement
+ * @return true if it failed with SQLITE_BUSY (or SQLITE_LOCKED)
+ */
+bool isBusy(const QString &error)
+{
+    return error.contains("is locked");
+}
+
+/**
+ * @brief randomEntry
+ * @param writer writer the entry is for
+ * @param category category of the entry
+ * @return entry with random date and amount on the writer's account
+ */
+Transaction randomEntry(Writer &writer, const QString &category)
+{
+    Transaction entry;
+    entry.date = QDate(2020, 1, 1).addDays(writer.random.bounded(DateRangeDays)).toString("yyyy/MM/dd");
+    entry.category = category;
+    entry.subcategory = QString("Item %1").arg(writer.random.bounded(10));
+    qint64 amountCents = writer.random.bounded(1, MaxAmountCents);
+    entry.amount = (writer.random.bounded(2) == 0 ? -amountCents : amountCents) / 100.0;
+    entry.currency = ExchangeRates::homeCurrency();
+    entry.accountID = writer.accountID;
+    return entry;
+}
+
+/**
+ * @brief readStored
+ * @param writer writer whose connection to read on
+ * @param transactionID entry ID
+ * @param entry receives the stored entry
+ * @return true if the entry is stored
+ */
+bool readStored(Writer &writer, qint64 transactionID, Transaction *entry)
+{
+    QSqlQuery query(writer.database);
+    query.prepare("SELECT transactionID, date, category, subcategory, amount, currency, accountID "
+                  "FROM budget "
+                  "WHERE transactionID = ?");
+    query.bindValue(0, transactionID);
+    if (!query.exec() || !query.next())
+        return false;
+    *entry = LedgerQuery::readEntry(query);
+    return true;
+}
+
+/**
+ * @brief writeCsv
+ *        Writes entries as an import file of the writer's account.
+ * @param writer writer whose scratch file to write
+ * @param entries entries to write
+ * @return true if the file was written
+ */
+bool writeCsv(Writer &writer, const QVector<Transaction> &entries)
+{
+    QFile file(writer.csvPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    stream << "date,category,subcategory,amount,currency,account\n";
+    for (const Transaction &entry : entries) {
+        stream << entry.date << ',' << entry.category << ',' << entry.subcategory << ','
+               << QString::number(entry.amount, 'f', 2) << ',' << entry.currency << ','
+               << accountName(writer.result.worker) << '\n';
+    }
+    return stream.status() == QTextStream::Ok;
+}
+
+/**
+ * @brief importCsv
+ *        Imports the writer's scratch file, retrying on SQLITE_BUSY.
+ * @param writer writer whose scratch file to import
+ * @param result receives the import result
+ * @return true if the import was committed
+ */
+bool importCsv(Writer &writer, ImportResult *result)
+{
+    for (int attempt = 1; ; ++attempt) {
+        *result = EntryImporter::importFile(writer.database, writer.csvPath,
+                                            writer.accounts, writer.accountID);
+        if (result->error.isEmpty())
+            return true;
+        if (!isBusy(result->error)) {
+            qWarning() << "Stress import failed:" << result->error;
+            ++writer.result.failures;
+            return false;
+        }
+        ++writer.result.busy;
+        if (attempt == LedgerStress::MaxAttempts) {
+            ++writer.result.failures;
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief journalBatch
+ *        Journals a random batch of adds, edits, removes and undos and
+ *        submits it, updating the model once it is committed.
+ * @param writer writer to run the batch on
+ */
+void journalBatch(Writer &writer)
+{
+    // effect of one pending operation on the model
+    struct Step {
+        qint64 deltaCents;      // change of the account balance
+        qint64 addedID;         // provisional ID of an added entry; 0 if none
+        qint64 removedID;       // ID of a removed entry; 0 if none
+    };
+    QVector<Step> steps;
+    qint64 addedID = 0;
+    QHash<qint64, qint64> moved;
+    QObject::connect(writer.journal, &EntryJournal::entryAdded, writer.journal,
+                     [&addedID](const Transaction &entry) { addedID = entry.transactionID; });
+    QObject::connect(writer.journal, &EntryJournal::entryChanged, writer.journal,
+                     [&moved](const Transaction &before, const Transaction &after) {
+                         if (before.transactionID != after.transactionID)
+                             moved.insert(before.transactionID, after.transactionID);
+                     });
+
+    int count = 1 + writer.random.bounded(MaxBatchOperations);
+    for (int i = 0; i < count; ++i) {
+        ++writer.result.operations;
+        int kind = writer.random.bounded(10);
+        if (kind == 0 && !steps.isEmpty()) {
+            writer.journal->undo();
+            steps.removeLast();
+            continue;
+        }
+
+        // edit or remove an entry submitted earlier, unless this batch already touches it
+        qint64 targetID = 0;
+        Transaction before;
+        if (kind < 6 && !writer.ids.isEmpty()) {
+            targetID = writer.ids.at(writer.random.bounded(writer.ids.size()));
+            if (writer.journal->isPending(targetID) || writer.journal->isReplaced(targetID)) {
+                targetID = 0;
+            } else if (!readStored(writer, targetID, &before)) {
+                ++writer.result.mismatches;
+                writer.ids.removeOne(targetID);
+                targetID = 0;
+            }
+        }
+
+        if (targetID == 0) {
+            Transaction entry = randomEntry(writer, "Stress");
+            writer.journal->addEntry(entry);
+            steps.append(Step{cents(entry.amount), addedID, 0});
+        } else if (kind < 4) {
+            Transaction after = randomEntry(writer, before.category);
+            after.transactionID = before.transactionID;
+            writer.journal->editEntry(before, after);
+            steps.append(Step{cents(after.amount) - cents(before.amount), 0, 0});
+        } else if (writer.journal->removeEntry(targetID)) {
+            steps.append(Step{-cents(before.amount), 0, targetID});
+        } else {
+            ++writer.result.mismatches;
+        }
+    }
+
+    bool submitted = false;
+    for (int attempt = 1; attempt <= LedgerStress::MaxAttempts; ++attempt) {
+        QElapsedTimer timer;
+        timer.start();
+        submitted = writer.journal->submit();
+        writer.result.maxSubmitMs = std::max(writer.result.maxSubmitMs, timer.elapsed());
+        if (submitted || !isBusy(writer.journal->lastError()))
+            break;
+        ++writer.result.busy;
+    }
+    QObject::disconnect(writer.journal, nullptr, writer.journal, nullptr);
+
+    if (!submitted) {
+        qWarning() << "Stress submit failed:" << writer.journal->lastError();
+        ++writer.result.failures;
+        writer.journal->discard();
+        return;
+    }
+    ++writer.result.submits;
+    for (const Step &step : steps) {
+        writer.result.expectedCents += step.deltaCents;
+        if (step.addedID != 0)
+            writer.ids.append(moved.value(step.addedID, step.addedID));
+        if (step.removedID != 0)
+            writer.ids.removeOne(step.removedID);
+    }
+}
+
+/**
+ * @brief importBatch
+ *        Imports fresh entries together with some of the previous import's,
+ *        which must all be found as duplicates.
+ * @param writer writer to import on
+ */
+void importBatch(Writer &writer)
+{
+    QVector<Transaction> fresh;
+    qint64 freshCents = 0;
+    int count = 1 + writer.random.bounded(MaxImportEntries);
+    for (int i = 0; i < count; ++i) {
+        Transaction entry = randomEntry(writer, "Import");
+        entry.subcategory = QString("Line %1-%2").arg(writer.result.worker).arg(++writer.serial);
+        freshCents += cents(entry.amount);
+        fresh.append(entry);
+    }
+    QVector<Transaction> repeated = writer.lastImport.mid(0, writer.random.bounded(writer.lastImport.size() + 1));
+    if (!writeCsv(writer, fresh + repeated)) {
+        ++writer.result.failures;
+        return;
+    }
+
+    ImportResult result;
+    if (!importCsv(writer, &result))
+        return;
+    ++writer.result.imports;
+    writer.result.operations += fresh.size() + repeated.size();
+    writer.result.expectedCents += freshCents;
+    if (result.imported != fresh.size() || result.duplicates != repeated.size())
+        ++writer.result.mismatches;
+    writer.lastImport = fresh;
+}
+
+/**
+ * @brief exportAccount
+ *        Reads the account's rows with the exporter's statement, checks
+ *        their balance against the model and imports them again, which
+ *        must store none.
+ * @param writer writer to export on
+ */
+void exportAccount(Writer &writer)
+{
+    QSqlQuery query(writer.database);
+    query.setForwardOnly(true);
+    LedgerFilter filter;
+    filter.accountID = writer.accountID;
+    LedgerQuery::prepare<LedgerQuery::Entries>(query, filter);
+    if (!query.exec()) {
+        if (isBusy(query.lastError().text()))
+            ++writer.result.busy;
+        ++writer.result.failures;
+        return;
+    }
+    QVector<Transaction> entries;
+    qint64 totalCents = 0;
+    while (query.next()) {
+        Transaction entry = LedgerQuery::readEntry(query);
+        totalCents += cents(entry.amount);
+        entries.append(entry);
+    }
+    query.finish();
+    ++writer.result.exports;
+    writer.result.operations += entries.size();
+    if (totalCents != writer.result.expectedCents)
+        ++writer.result.mismatches;
+
+    if (!writeCsv(writer, entries)) {
+        ++writer.result.failures;
+        return;
+    }
+    ImportResult result;
+    if (!importCsv(writer, &result))
+        return;
+    if (result.imported != 0 || result.duplicates != entries.size())
+        ++writer.result.mismatches;
+}
+
+/**
+ * @brief runWriter
+ *        Writes to the scratch ledger at random until the deadline.
+ * @param worker writer index
+ * @param seed seed of the whole run
+ * @param seconds run time
+ * @param key ledger key; empty if unencrypted
+ * @return what the writer did
+ */
+WorkerResult runWriter(int worker, quint32 seed, int seconds, const QByteArray &key)
+{
+    QString connectionName = QString("stress_%1").arg(worker);
+    WorkerResult result;
+    {
+        Writer writer;
+        writer.random.seed(writerSeed(seed, worker));
+        writer.result.worker = worker;
+        writer.database = QSqlDatabase::addDatabase(LedgerCipher::driverName(), connectionName);
+        writer.database.setDatabaseName(LedgerCipher::ledgerPath(StressUser));
+        if (LedgerCipher::open(writer.database, key)) {
+            writer.accounts.load(writer.database);
+            writer.accountID = writer.accounts.accountID(accountName(worker));
+            writer.csvPath = QFileInfo(LedgerCipher::ledgerPath(StressUser)).absolutePath()
+                             + QString("/stress-%1.csv").arg(worker);
+            EntryJournal journal(writer.database);
+            writer.journal = &journal;
+
+            QElapsedTimer clock;
+            clock.start();
+            while (writer.accountID != 0 && clock.elapsed() < seconds * 1000) {
+                int kind = writer.random.bounded(20);
+                if (kind < 12)
+                    journalBatch(writer);
+                else if (kind < 17)
+                    importBatch(writer);
+                else
+                    exportAccount(writer);
+            }
+            writer.journal = nullptr;
+            QFile::remove(writer.csvPath);
+        }
+        if (writer.accountID == 0)
+            ++writer.result.failures;
+        writer.database.close();
+        result = writer.result;
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    return result;
+}
+
+/**
+ * @brief runWriters
+ *        Runs LedgerStress::Threads writers in this process at once.
+ * @param firstWorker index of the first writer
+ * @param seed seed of the whole run
+ * @param seconds run time
+ * @param key ledger key; empty if unencrypted
+ * @return what each writer did
+ */
+QVector<WorkerResult> runWriters(int firstWorker, quint32 seed, int seconds, const QByteArray &key)
+{
+    QVector<WorkerResult> results(LedgerStress::Threads);
+    QThreadPool pool;
+    pool.setMaxThreadCount(LedgerStress::Threads);
+    for (int i = 0; i < LedgerStress::Threads; ++i) {
+        WorkerResult *result = &results[i];
+        pool.start([result, firstWorker, i, seed, seconds, key]() {
+            *result = runWriter(firstWorker + i, seed, seconds, key);
+        });
+    }
+    pool.waitForDone();
+    return results;
+}
+
+/**
+ * @brief toLine
+ * @param result writer result
+ * @return result as a line a child process reports to its parent
+ */
+QString toLine(const WorkerResult &result)
+{
+    return QString("result %1 %2 %3 %4 %5 %6 %7 %8 %9 %10")
+        .arg(result.worker).arg(result.expectedCents).arg(result.operations)
+        .arg(result.submits).arg(result.imports).arg(result.exports)
+        .arg(result.busy).arg(result.failures).arg(result.mismatches)
+        .arg(result.maxSubmitMs);
+}
+
+/**
+ * @brief fromLine
+ * @param line line of a child process
+ * @param result receives the writer result
+ * @return true if line is a result line
+ */
+bool fromLine(const QString &line, WorkerResult *result)
+{
+    QStringList fields = line.split(' ');
+    if (fields.size() != 11 || fields.at(0) != "result")
+        return false;
+    result->worker = fields.at(1).toInt();
+    result->expectedCents = fields.at(2).toLongLong();
+    result->operations = fields.at(3).toLongLong();
+    result->submits = fields.at(4).toInt();
+    result->imports = fields.at(5).toInt();
+    result->exports = fields.at(6).toInt();
+    result->busy = fields.at(7).toInt();
+    result->failures = fields.at(8).toInt();
+    result->mismatches = fields.at(9).toInt();
+    result->maxSubmitMs = fields.at(10).toLongLong();
+    return true;
+}
+}
+
+/**
+ * @brief LedgerStress::isRequested
+ *        Checked before the application object exists, since the stress
+ *        test runs without widgets.
+ * @param argc argument count of main()
+ * @param argv arguments of main()
+ * @return true if the program was started to run the stress test
+ */
+bool LedgerStress::isRequested(int argc, char *argv[])
+{
+    return argc > 1 && (qstrcmp(argv[1], "--stress") == 0 || qstrcmp(argv[1], "--stress-worker") == 0);
+}
+
+/**
+ * @brief LedgerStress::run
+ *        Runs the stress test, or one of its child processes.
+ * @param arguments application arguments
+ * @return process exit code; 0 if every balance matched its model
+ */
+int LedgerStress::run(const QStringList &arguments)
+{
+    // keep the scratch ledger away from real ledgers
+    QStandardPaths::setTestModeEnabled(true);
+    if (arguments.value(1) == "--stress-worker") {
+        return runChild(arguments.value(2).toInt(), arguments.value(3).toInt(),
+                        arguments.value(4).toUInt());
+    }
+
+    int seconds = arguments.value(2).toInt();
+    if (seconds <= 0)
+        seconds = DefaultSeconds;
+    bool hasSeed = false;
+    quint32 seed = arguments.value(3).toUInt(&hasSeed);
+    if (!hasSeed)
+        seed = QRandomGenerator::global()->generate();
+    return runParent(seconds, seed);
+}
+
+/**
+ * @brief LedgerStress::runParent
+ *        Creates the scratch ledger, runs writers here and in the child
+ *        processes, then checks balances and prints the results.
+ * @param seconds run time
+ * @param seed seed of the writers' random choices
+ * @return 0 if every balance matched its model, 1 otherwise
+ */
+int LedgerStress::runParent(int seconds, quint32 seed)
+{
+    QTextStream out(stdout);
+    QString path = LedgerCipher::ledgerPath(StressUser);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    for (const QString &file : {path, LedgerCipher::logPath(StressUser)}) {
+        QFile::remove(file);
+        QFile::remove(file + "-wal");
+        QFile::remove(file + "-shm");
+    }
+
+    int writers = Threads * (Processes + 1);
+    auto session = std::make_unique<LedgerSession>(std::make_shared<User>(0, StressUser, StressPassword));
+    for (int worker = 0; worker < writers; ++worker) {
+        if (session->addAccount(accountName(worker)) == 0) {
+            out << "Stress: accounts could not be added to " << path << "\n";
+            return 1;
+        }
+    }
+    out << QString("Stress: %1 writers (%2 processes x %3 threads) for %4 s, seed %5, ledger %6%7\n")
+               .arg(writers).arg(Processes + 1).arg(Threads).arg(seconds).arg(seed).arg(path)
+               .arg(session->ledgerKey().isEmpty() ? "" : " (encrypted)");
+    out.flush();
+
+    QElapsedTimer clock;
+    clock.start();
+    QList<QProcess *> children;
+    for (int process = 1; process <= Processes; ++process) {
+        QProcess *child = new QProcess;
+        child->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        child->start(QCoreApplication::applicationFilePath(),
+                     {"--stress-worker", QString::number(process * Threads),
+                      QString::number(seconds), QString::number(seed)});
+        children.append(child);
+    }
+    QVector<WorkerResult> results = runWriters(0, seed, seconds, session->ledgerKey());
+    bool complete = true;
+    for (QProcess *child : children) {
+        if (!child->waitForFinished(seconds * 1000 + ChildGraceMs)
+            || child->exitStatus() != QProcess::NormalExit) {
+            complete = false;
+            child->kill();
+            child->waitForFinished();
+        }
+        for (const QString &line : QString::fromUtf8(child->readAllStandardOutput()).split('\n')) {
+            WorkerResult result;
+            if (fromLine(line.trimmed(), &result))
+                results.append(result);
+        }
+    }
+    qDeleteAll(children);
+    double elapsed = clock.elapsed() / 1000.0;
+
+    // stored balance of each writer's account
+    QHash<qint64, qint64> storedCents;
+    QSqlQuery query(session->database());
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT accountID, SUM(amount) "
+                    "FROM budget "
+                    "GROUP BY accountID")) {
+        out << "Stress: balances could not be read: " << query.lastError().text() << "\n";
+        return 1;
+    }
+    while (query.next())
+        storedCents.insert(query.value(0).toLongLong(), cents(query.value(1).toDouble()));
+    query.finish();
+
+    WorkerResult total;
+    int matching = 0;
+    for (const WorkerResult &result : results) {
+        qint64 accountID = session->accounts()->accountID(accountName(result.worker));
+        qint64 stored = storedCents.value(accountID);
+        if (stored == result.expectedCents) {
+            ++matching;
+        } else {
+            out << QString("Stress: %1 has balance %2, expected %3\n")
+                       .arg(accountName(result.worker)).arg(stored / 100.0, 0, 'f', 2)
+                       .arg(result.expectedCents / 100.0, 0, 'f', 2);
+        }
+        total.operations += result.operations;
+        total.submits += result.submits;
+        total.imports += result.imports;
+        total.exports += result.exports;
+        total.busy += result.busy;
+        total.failures += result.failures;
+        total.mismatches += result.mismatches;
+        total.maxSubmitMs = std::max(total.maxSubmitMs, result.maxSubmitMs);
+    }
+    if (results.size() != writers)
+        complete = false;
+
+    out << QString("Stress: %1 operations in %2 s, %3 ops/s\n")
+               .arg(total.operations).arg(elapsed, 0, 'f', 1)
+               .arg(total.operations / std::max(elapsed, 0.001), 0, 'f', 0);
+    out << QString("Stress: %1 batches submitted, %2 files imported, %3 exports checked\n")
+               .arg(total.submits).arg(total.imports).arg(total.exports);
+    out << QString("Stress: %1 SQLITE_BUSY, %2 other failures, slowest submit %3 ms\n")
+               .arg(total.busy).arg(total.failures).arg(total.maxSubmitMs);
+    out << QString("Stress: %1 of %2 balances match, %3 reads or imports disagreed%4\n")
+               .arg(matching).arg(writers).arg(total.mismatches)
+               .arg(complete ? "" : ", some writers did not report");
+    return complete && matching == writers && total.mismatches == 0 ? 0 : 1;
+}
+
+/**
+ * @brief LedgerStress::runChild
+ *        Runs Threads writers on the scratch ledger created by the parent
+ *        and reports their results on standard output.
+ * @param firstWorker index of the first writer
+ * @param seconds run time
+ * @param seed seed of the whole run
+ * @return 0
+ */
+int LedgerStress::runChild(int firstWorker, int seconds, quint32 seed)
+{
+    QByteArray key;
+    if (LedgerCipher::isAvailable())
+        key = LedgerCipher::deriveKey(StressUser, StressPassword);
+    QTextStream out(stdout);
+    for (const WorkerResult &result : runWriters(firstWorker, seed, seconds, key))
+        out << toLine(result) << "\n";
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QStringList>
+
+/**
+ * @brief The LedgerStress class
+ *        Randomized concurrent writer stress test of one ledger, run as
+ *        "BudgetTracker --stress [seconds] [seed]" instead of logging in.
+ *
+ *        A scratch ledger (in QStandardPaths test mode, so no real ledger
+ *        is touched) is opened through a LedgerSession, which gives it the
+ *        current schema and encryption. Threads writer threads in this
+ *        process and in each of Processes child processes then write to it
+ *        at once until the time is up, each on its own connection and its
+ *        own account, picking at random between:
+ *        - journal batches of adds, edits, removes and undos, submitted
+ *          through EntryJournal;
+ *        - CSV imports through EntryImporter, with fresh entries and
+ *          entries of the previous import that must be found as duplicates;
+ *        - exports of the account's rows, read with the exporter's
+ *          statement, checked against the model and imported again, which
+ *          must find every row a duplicate.
+ *        Every writer keeps an in-memory model of its account's balance.
+ *        At the end each account's stored balance is checked against its
+ *        model, and throughput and SQLITE_BUSY counts are printed. Submits
+ *        and imports failing with SQLITE_BUSY are retried up to MaxAttempts
+ *        times.
+ */
+class LedgerStress
+{
+public:
+    static const int Threads = 4;           // writer threads per process
+    static const int Processes = 2;         // child processes besides this one
+    static const int DefaultSeconds = 20;   // run time without a seconds argument
+    static const int MaxAttempts = 5;       // tries of a submit or import that hit SQLITE_BUSY
+
+    static bool isRequested(int argc, char *argv[]);
+    static int run(const QStringList &arguments);
+
+private:
+    static int runParent(int seconds, quint32 seed);
+    static int runChild(int firstWorker, int seconds, quint32 seed);
+};
@@ -0,0 +1,136 @@
+#include "LoginAudit.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+namespace {
+const char *EventNames[] = {
+    "login succeeded",
+    "login failed",
+    "login throttled",
+    "registered",
+    "registration failed",
+    "password reset",
+    "password reset failed"
+};
+
+/**
+ * @brief The Queue struct
+ *        Lines waiting for the writer; pool is declared last so it is
+ *        destroyed first, waiting for the writer before the rest goes.
+ */
+struct Queue {
+    QMutex mutex;
+    QByteArray lines;           // queued JSON lines
+    int queued = 0;             // lines in lines
+    int dropped = 0;            // events not queued since the last batch
+    bool writing = false;       // a writer task is draining lines
+    QThreadPool pool;           // one writer thread, so appends stay in order
+
+    Queue() { pool.setMaxThreadCount(1); }
+};
+
+Queue &queue()
+{
+    static Queue instance;
+    return instance;
+}
+}
+
+/**
+ * @brief LoginAudit::record
+ *        Queues an event for the audit log and starts the writer if it is
+ *        idle. Never touches the disk itself.
+ * @param event what happened
+ * @param username username the event concerns
+ * @param userID userID the event concerns; -1 if unknown
+ */
+void LoginAudit::record(Event event, const QString &username, int userID)
+{
+    QJsonObject object;
+    object.insert("time", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+    object.insert("event", EventNames[event]);
+    object.insert("username", username);
+    if (userID >= 0)
+        object.insert("userID", userID);
+    QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n';
+
+    Queue &q = queue();
+    QMutexLocker locker(&q.mutex);
+    if (q.queued >= MaxQueued) {
+        ++q.dropped;
+        return;
+    }
+    q.lines += line;
+    ++q.queued;
+    if (!q.writing) {
+        q.writing = true;
+        q.pool.start(&LoginAudit::writeQueued);
+    }
+}
+
+/**
+ * @brief LoginAudit::flush
+ *        Waits until every queued event is written, e.g. before exit.
+ */
+void LoginAudit::flush()
+{
+    queue().pool.waitForDone();
+}
+
+/**
+ * @brief LoginAudit::logPath
+ * @return path of the audit log in AppData, next to the login database
+ */
+QString LoginAudit::logPath()
+{
+    QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return path + QDir::separator() + "login-audit.jsonl";
+}
+
+/**
+ * @brief LoginAudit::writeQueued
+ *        Writer task: appends queued lines batch by batch until none are
+ *        left. Runs on the queue's pool only.
+ */
+void LoginAudit::writeQueued()
+{
+    Queue &q = queue();
+    QFile file(logPath());
+    for (;;) {
+        QByteArray lines;
+        int dropped = 0;
+        {
+            QMutexLocker locker(&q.mutex);
+            if (q.queued == 0 && q.dropped == 0) {
+                q.writing = false;
+                break;
+            }
+            lines.swap(q.lines);
+            dropped = q.dropped;
+            q.queued = 0;
+            q.dropped = 0;
+        }
+        if (dropped > 0) {
+            QJsonObject object;
+            object.insert("time", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+            object.insert("event", "events dropped");
+            object.insert("count", dropped);
+            lines += QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n';
+        }
+        if (!file.isOpen() && !file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning() << "Login audit log not written:" << file.errorString();
+            continue;
+        }
+        if (file.write(lines) != lines.size())
+            qWarning() << "Login audit log not written:" << file.errorString();
+        file.flush();
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QString>
+
+/**
+ * @brief The LoginAudit class
+ *        Append-only audit log of login, registration and password reset
+ *        events, written off the GUI thread.
+ *
+ *        record() only queues a JSON line in memory; a single writer task
+ *        appends whatever is queued to the log file in one write and keeps
+ *        draining until the queue is empty, so a burst of attempts costs
+ *        one file append per batch and never waits for the disk. Beyond
+ *        MaxQueued unwritten lines, events are counted instead of queued,
+ *        and the count is logged with the next batch.
+ */
+class LoginAudit
+{
+public:
+    enum Event {
+        LoginSucceeded,
+        LoginFailed,
+        LoginThrottled,
+        Registered,
+        RegistrationFailed,
+        PasswordReset,
+        PasswordResetFailed
+    };
+
+    static const int MaxQueued = 10000;     // unwritten lines before events are dropped
+
+    static void record(Event event, const QString &username, int userID = -1);
+    static void flush();
+    static QString logPath();
+
+private:
+    static void writeQueued();
+};
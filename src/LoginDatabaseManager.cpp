@@ -1,10 +1,122 @@
 #include "LoginDatabaseManager.h"
+#include "LedgerCipher.h"
+#include "LoginAudit.h"
+#include "LoginThrottle.h"
+#include "SchemaMigrator.h"
 
 #include <QDebug>
 #include <QDir>
+#include <QPair>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QStandardPaths>
+#include <QVector>
+
+#include <algorithm>
+
+namespace {
+// named, so it never replaces a ledger connection of an open session
+const char *ConnectionName = "login";
+
+/**
+ * @brief createUserTable
+ *        Migration 1: creates user table with the default admin user.
+ * @param query query on the login database
+ * @return true on success
+ */
+bool createUserTable(QSqlQuery &query)
+{
+    if (!query.exec("CREATE TABLE IF NOT EXISTS user ("
+                    "userID INTEGER PRIMARY KEY, "
+                    "username VARCHAR(20), "
+                    "password VARCHAR(20))"))
+        return false;
+    query.prepare("INSERT OR IGNORE INTO user "
+                  "(userID, username, password) "
+                  "VALUES (?, ?, ?)");
+    query.bindValue(0, 0);
+    query.bindValue(1, "admin");
+    query.bindValue(2, "admin");
+    return query.exec();
+}
+
+/**
+ * @brief indexUsernames
+ *        Migration 2: users are looked up by username through a unique
+ *        index.
+ *
+ *        Registration always refused taken usernames, so duplicates can
+ *        only come from concurrent registrations. No user is dropped: the
+ *        first registered user keeps the name, and later ones are renamed
+ *        to "name#userID" (or "name#userID-2" and so on, if that is taken
+ *        too), keeping their passwords. The renamed users are logged, as
+ *        they must log in under their new names; their ledgers are found
+ *        by username, so they start with new, empty ones.
+ * @param query query on the login database
+ * @return true on success
+ */
+bool indexUsernames(QSqlQuery &query)
+{
+    if (!query.exec("SELECT userID, username "
+                    "FROM user "
+                    "WHERE userID NOT IN (SELECT MIN(userID) FROM user GROUP BY username)"))
+        return false;
+    QVector<QPair<qint64, QString>> duplicates;
+    while (query.next())
+        duplicates.append({query.value(0).toLongLong(), query.value(1).toString()});
+
+    for (const auto &duplicate : duplicates) {
+        QString base = QString("%1#%2").arg(duplicate.second).arg(duplicate.first);
+        QString renamed = base;
+        for (int suffix = 2; ; ++suffix) {
+            query.prepare("SELECT COUNT(*) "
+                          "FROM user "
+                          "WHERE username = ?");
+            query.bindValue(0, renamed);
+            if (!query.exec() || !query.next())
+                return false;
+            if (query.value(0).toInt() == 0)
+                break;
+            renamed = QString("%1-%2").arg(base).arg(suffix);
+        }
+        query.prepare("UPDATE user "
+                      "SET username = ? "
+                      "WHERE userID = ?");
+        query.bindValue(0, renamed);
+        query.bindValue(1, duplicate.first);
+        if (!query.exec())
+            return false;
+        qWarning().noquote() << QString("Duplicate user %1 (userID %2) renamed to %3; its ledger "
+                                        "file and key are derived from the new name, so it "
+                                        "starts with a new, empty ledger")
+                                    .arg(duplicate.second).arg(duplicate.first).arg(renamed);
+    }
+    return query.exec("CREATE UNIQUE INDEX IF NOT EXISTS user_username "
+                      "ON user (username)");
+}
+
+/**
+ * @brief equalPasswords
+ *        Compares passwords in time that depends only on their lengths,
+ *        not on how many leading characters match.
+ * @param a first password
+ * @param b second password
+ * @return true if equal
+ */
+bool equalPasswords(const QString &a, const QString &b)
+{
+    QByteArray left = a.toUtf8();
+    QByteArray right = b.toUtf8();
+    int length = int(std::max(left.size(), right.size()));
+    unsigned difference = unsigned(left.size() ^ right.size());
+    for (int i = 0; i < length; ++i) {
+        quint8 l = i < left.size() ? quint8(left.at(i)) : 0;
+        quint8 r = i < right.size() ? quint8(right.at(i)) : 0;
+        difference |= l ^ r;
+    }
+    return difference == 0;
+}
+}
 
 /**
  * @brief LoginDatabaseManager::LoginDatabaseManager
@@ -34,7 +146,7 @@ LoginDatabaseManager::~LoginDatabaseManager()
 void LoginDatabaseManager::openDatabase()
 {
     m_database = new QSqlDatabase;
-    *m_database = QSqlDatabase::addDatabase("QSQLITE");
+    *m_database = QSqlDatabase::addDatabase("QSQLITE", ConnectionName);
     QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir dir;
     if (!dir.exists(path))
@@ -53,65 +165,81 @@ void LoginDatabaseManager::closeDatabase()
 {
     m_database->close();
     delete m_database;
-    QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+    QSqlDatabase::removeDatabase(ConnectionName);
 }
 
 /**
  * @brief LoginDatabaseManager::createTable
- *        Creates login table.
+ *        Creates or migrates login table to the current schema version.
  *
  * Inserts default admin user into table.
  */
 void LoginDatabaseManager::createTable()
 {
-    QSqlQuery query;
-    query.prepare("CREATE TABLE IF NOT EXISTS user ("
-                  "userID INTEGER PRIMARY KEY, "
-                  "username VARCHAR(20), "
-                  "password VARCHAR(20))");
-    query.exec();
-    query.prepare("INSERT INTO user "
-                  "(userID, username, password) "
-                  "VALUES (?, ?, ?)");
-    query.bindValue(0, 0);
-    query.bindValue(1, "admin");
-    query.bindValue(2, "admin");
-    query.exec();
+    SchemaMigrator migrator(*m_database);
+    migrator.add(1, "create user table", createUserTable);
+    migrator.add(2, "index usernames", indexUsernames);
+    if (!migrator.migrate())
+        qWarning() << "Login schema not up to date:" << migrator.lastError();
 }
 
 /**
  * @brief LoginDatabaseManager::loginUser
  *        Attemps to login user.
+ *
+ *        Attempts are throttled per username by LoginThrottle; throttled
+ *        ones are rejected without querying the database. Every attempt is
+ *        recorded in the LoginAudit log.
  * @param username user's username
  * @param password user's password
  * @return shared_ptr to user object; nullptr if unsuccessful
  */
 std::shared_ptr<User> LoginDatabaseManager::loginUser(const QString& username, const QString& password)
 {
-    QSqlQuery query;
-    query.prepare("SELECT COUNT(*), userID "
+    if (LoginThrottle::retryAfterMs(username) > 0) {
+        LoginAudit::record(LoginAudit::LoginThrottled, username);
+        return nullptr;
+    }
+
+    QSqlQuery query(*m_database);
+    query.prepare("SELECT userID, password "
                   "FROM user "
-                  "WHERE username = ? "
-                  "AND password = ?");
+                  "WHERE username = ?");
     query.bindValue(0, username);
-    query.bindValue(1, password);
     query.exec();
 
-    int match = 0;
-    int userID = 0;
+    int userID = -1;
+    QString storedPassword;
     if (query.next()) {
-        match = query.value(0).toInt();
-        userID = query.value(1).toInt();
+        userID = query.value(0).toInt();
+        storedPassword = query.value(1).toString();
     }
+    // compare for unknown usernames too, so both take the same time
+    bool match = equalPasswords(password, storedPassword) && userID >= 0;
 
-    if (match > 0) {
+    if (match) {
+        LoginThrottle::recordSuccess(username);
+        LoginAudit::record(LoginAudit::LoginSucceeded, username, userID);
         return std::make_shared<User>(userID, username, password);
     }
     else {
+        LoginThrottle::recordFailure(username);
+        LoginAudit::record(LoginAudit::LoginFailed, username);
         return nullptr;
     }
 }
 
+/**
+ * @brief LoginDatabaseManager::loginDelay
+ * @param username username about to log in
+ * @return seconds until username may attempt a login again; 0 if it may now
+ */
+int LoginDatabaseManager::loginDelay(const QString& username)
+{
+    qint64 delay = LoginThrottle::retryAfterMs(username);
+    return int((delay + 999) / 1000);
+}
+
 /**
  * @brief LoginDatabaseManager::verifyUsername
  *        Verifies if username already exists in database.
@@ -120,7 +248,7 @@ std::shared_ptr<User> LoginDatabaseManager::loginUser(const QString& username, c
  */
 bool LoginDatabaseManager::verifyUsername(const QString& username)
 {
-    QSqlQuery query;
+    QSqlQuery query(*m_database);
     query.prepare("SELECT COUNT(*) "
                   "FROM user "
                   "WHERE username = ?");
@@ -143,16 +271,22 @@ bool LoginDatabaseManager::verifyUsername(const QString& username)
  *        Registers new user information into database.
  * @param username new user's username
  * @param password new user's password
+ * @return true if registered; false if e.g. username was taken meanwhile
  */
-void LoginDatabaseManager::registerUser(const QString& username, const QString &password)
+bool LoginDatabaseManager::registerUser(const QString& username, const QString &password)
 {
-    QSqlQuery query;
+    QSqlQuery query(*m_database);
     query.prepare("INSERT INTO user "
                   "(userID, username, password) "
                   "VALUES (NULL, ?, ?)");
     query.bindValue(0, username);
     query.bindValue(1, password);
-    query.exec();
+    if (!query.exec()) {
+        LoginAudit::record(LoginAudit::RegistrationFailed, username);
+        return false;
+    }
+    LoginAudit::record(LoginAudit::Registered, username, query.lastInsertId().toInt());
+    return true;
 }
 
 /**
@@ -163,7 +297,7 @@ void LoginDatabaseManager::registerUser(const QString& username, const QString &
  */
 bool LoginDatabaseManager::verifyUserID(const int userID)
 {
-    QSqlQuery query;
+    QSqlQuery query(*m_database);
     query.prepare("SELECT COUNT(*) "
                   "FROM user "
                   "WHERE userID = ?");
@@ -184,16 +318,49 @@ bool LoginDatabaseManager::verifyUserID(const int userID)
 /**
  * @brief LoginDatabaseManager::changePassword
  *        Changes existing user's password.
+ *
+ *        An encrypted ledger and its entry log are re-encrypted under the
+ *        new password first; the password is left unchanged if that fails,
+ *        so the ledger stays readable.
  * @param userID userID of user changing their password
  * @param newPassword user's new password
+ * @return true if password was changed
  */
-void LoginDatabaseManager::changePassword(const int userID, const QString& newPassword)
+bool LoginDatabaseManager::changePassword(const int userID, const QString& newPassword)
 {
-    QSqlQuery query;
+    QSqlQuery query(*m_database);
+    query.prepare("SELECT username, password "
+                  "FROM user "
+                  "WHERE userID = ?");
+    query.bindValue(0, userID);
+    query.exec();
+    if (!query.next())
+        return false;
+    QString username = query.value(0).toString();
+    QString oldPassword = query.value(1).toString();
+
+    if (LedgerCipher::isAvailable()) {
+        QByteArray oldKey = LedgerCipher::deriveKey(username, oldPassword);
+        QByteArray newKey = LedgerCipher::deriveKey(username, newPassword);
+        // entry log first, so it can be put back if the ledger fails
+        if (!LedgerCipher::rekeyFile(LedgerCipher::logPath(username), oldKey, newKey)) {
+            LoginAudit::record(LoginAudit::PasswordResetFailed, username, userID);
+            return false;
+        }
+        if (!LedgerCipher::rekeyFile(LedgerCipher::ledgerPath(username), oldKey, newKey)) {
+            LedgerCipher::rekeyFile(LedgerCipher::logPath(username), newKey, oldKey);
+            LoginAudit::record(LoginAudit::PasswordResetFailed, username, userID);
+            return false;
+        }
+    }
+
     query.prepare("UPDATE user "
                   "SET password = ? "
                   "WHERE userID = ?");
     query.bindValue(0, newPassword);
     query.bindValue(1, userID);
-    query.exec();
+    bool changed = query.exec();
+    LoginAudit::record(changed ? LoginAudit::PasswordReset : LoginAudit::PasswordResetFailed,
+                       username, userID);
+    return changed;
 }
@@ -27,8 +27,9 @@ public:
 
     // SQLite query functions
     std::shared_ptr<User> loginUser(const QString& username, const QString& password);
+    int loginDelay(const QString& username);
     bool verifyUsername(const QString& username);
-    void registerUser(const QString& username, const QString &password);
+    bool registerUser(const QString& username, const QString &password);
     bool verifyUserID(const int userID);
-    void changePassword(const int userID, const QString& newPassword);
+    bool changePassword(const int userID, const QString& newPassword);
 };
@@ -46,6 +46,17 @@ std::shared_ptr<User> LoginDialog::user()
     return m_currentUser;
 }
 
+/**
+ * @brief LoginDialog::setLoggedInUsers
+ *        Setter for users already logged in, whose passwords cannot be
+ *        reset while their ledgers are open.
+ * @param userIDs userIDs with an open session
+ */
+void LoginDialog::setLoggedInUsers(const QList<int> &userIDs)
+{
+    m_loggedInUsers = userIDs;
+}
+
 /**
  * @brief LoginDialog::login
  *        Attemps to login, accepting QDialog if successful.
@@ -56,6 +67,12 @@ void LoginDialog::login()
     QString password = ui->passwordLineEdit->text();
 
     LoginDatabaseManager db;
+    int delay = db.loginDelay(username);
+    if (delay > 0) {
+        ui->statusLabel->setStyleSheet("color: red");
+        ui->statusLabel->setText(QString("Too many failed attempts, try again in %1 s").arg(delay));
+        return;
+    }
     // attempt login
     m_currentUser = db.loginUser(username, password);
     if (m_currentUser == nullptr) {
@@ -87,6 +104,7 @@ void LoginDialog::registration()
 void LoginDialog::forgotLogin()
 {
     ForgotLoginDialog fDialog;
+    fDialog.setLoggedInUsers(m_loggedInUsers);
     if (fDialog.exec() == QDialog::Accepted) {
         ui->statusLabel->setStyleSheet("color: green");
         ui->statusLabel->setText("Password reset successfully");
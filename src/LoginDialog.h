@@ -11,7 +11,7 @@ QT_END_NAMESPACE
  * @brief The LoginDialog class
  *        Manages user login for BudgetTracker.
  *
- *        Used in main function to specify user for BudgetTracker.
+ *        Used by SessionManager to specify user for BudgetTracker.
  */
 class LoginDialog : public QDialog
 {
@@ -22,8 +22,9 @@ public:
     LoginDialog(QWidget *parent = nullptr);
     ~LoginDialog();
 
-    // getter
+    // getter and setter
     std::shared_ptr<User> user();
+    void setLoggedInUsers(const QList<int> &userIDs);
 
 private slots:
     void login();
@@ -34,4 +35,5 @@ private slots:
 private:
     Ui::LoginDialog *ui;
     std::shared_ptr<User> m_currentUser;  // current user to pass to BudgetTracker
+    QList<int> m_loggedInUsers;           // userIDs with an open session, whose passwords cannot be reset
 };
@@ -0,0 +1,97 @@
+#include "LoginThrottle.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+
+#include <algorithm>
+
+namespace {
+/**
+ * @brief The Failures struct
+ *        Failed attempts of one username.
+ */
+struct Failures {
+    int count = 0;              // consecutive failures
+    qint64 blockedUntil = 0;    // clock time before which attempts are turned away
+};
+
+QElapsedTimer clock;                    // monotonic time base of blockedUntil
+QHash<QString, Failures> failures;      // by username
+
+/**
+ * @brief now
+ * @return milliseconds since the throttle was first used
+ */
+qint64 now()
+{
+    if (!clock.isValid())
+        clock.start();
+    return clock.elapsed();
+}
+
+/**
+ * @brief prune
+ *        Drops usernames whose wait ended at least MaxDelayMs ago.
+ */
+void prune()
+{
+    qint64 cutoff = now() - LoginThrottle::MaxDelayMs;
+    for (auto it = failures.begin(); it != failures.end();) {
+        if (it->blockedUntil < cutoff)
+            it = failures.erase(it);
+        else
+            ++it;
+    }
+}
+}
+
+/**
+ * @brief LoginThrottle::retryAfterMs
+ * @param username username of the attempt
+ * @return milliseconds until username may try again; 0 if it may now
+ */
+qint64 LoginThrottle::retryAfterMs(const QString &username)
+{
+    auto it = failures.constFind(username);
+    if (it == failures.constEnd())
+        return 0;
+    return std::max<qint64>(0, it->blockedUntil - now());
+}
+
+/**
+ * @brief LoginThrottle::recordFailure
+ *        Counts a failed attempt and extends username's wait.
+ * @param username username of the attempt
+ */
+void LoginThrottle::recordFailure(const QString &username)
+{
+    if (!failures.contains(username) && failures.size() >= MaxTracked) {
+        prune();
+        // under a flood of fresh usernames, stop tracking new ones
+        if (failures.size() >= MaxTracked)
+            return;
+    }
+
+    Failures &entry = failures[username];
+    // failures long after the last wait ended start over
+    if (entry.count > 0 && entry.blockedUntil < now() - MaxDelayMs)
+        entry.count = 0;
+    ++entry.count;
+    if (entry.count <= FreeAttempts) {
+        entry.blockedUntil = now();
+        return;
+    }
+    int doublings = std::min(entry.count - FreeAttempts - 1, 30);
+    qint64 delay = BaseDelayMs << doublings;
+    entry.blockedUntil = now() + (delay < MaxDelayMs ? delay : MaxDelayMs);
+}
+
+/**
+ * @brief LoginThrottle::recordSuccess
+ *        Forgets username's failed attempts.
+ * @param username username of the attempt
+ */
+void LoginThrottle::recordSuccess(const QString &username)
+{
+    failures.remove(username);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QString>
+
+/**
+ * @brief The LoginThrottle class
+ *        Per-username exponential backoff of failed logins, in memory.
+ *
+ *        The first FreeAttempts failures of a username cost nothing; every
+ *        further failure doubles the wait before the next attempt, from
+ *        BaseDelayMs up to MaxDelayMs. A successful login clears it.
+ *        Throttled attempts are turned away before the login database is
+ *        queried and do not extend the wait. Usernames are tracked exactly
+ *        as the login database matches them, whether or not they exist, so
+ *        the throttle does not reveal which do. At
+ *        most MaxTracked usernames are kept; ones whose wait has long
+ *        passed are dropped first, and failures that long after the last
+ *        wait start the count over.
+ */
+class LoginThrottle
+{
+public:
+    static const int FreeAttempts = 3;              // failures before any wait
+    static const qint64 BaseDelayMs = 1000;         // wait after the first counted failure
+    static const qint64 MaxDelayMs = 15 * 60000;    // longest wait
+    static const int MaxTracked = 10000;            // usernames kept in memory
+
+    static qint64 retryAfterMs(const QString &username);
+    static void recordFailure(const QString &username);
+    static void recordSuccess(const QString &username);
+};
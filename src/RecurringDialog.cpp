@@ -0,0 +1,186 @@
+#include "RecurringDialog.h"
+#include "ui_RecurringDialog.h"
+
+#include "ExchangeRates.h"
+
+/**
+ * @brief RecurringDialog::RecurringDialog
+ *        Sets up UI and connects signals & slots.
+ * @param schedule recurring schedule to edit
+ * @param accounts accounts rules can belong to
+ * @param parent pointer to QWidget parent object
+ */
+RecurringDialog::RecurringDialog(RecurringSchedule *schedule, const AccountList *accounts,
+                                 QWidget *parent)
+    : QDialog(parent)
+    , ui(new Ui::RecurringDialog)
+    , m_schedule(schedule)
+    , m_accounts(accounts)
+{
+    ui->setupUi(this);
+
+    // manual ui setup
+    ui->startDateEdit->setDate(QDate::currentDate());
+    ui->endDateEdit->setDate(QDate::currentDate().addYears(1));
+    ui->intervalUnitComboBox->setCurrentIndex(RecurringRule::Month);
+    ui->currencyLineEdit->setText(ExchangeRates::homeCurrency());
+    for (const Account &account : m_accounts->accounts())
+        ui->accountComboBox->addItem(account.name, account.accountID);
+    ui->ruleTableWidget->setColumnCount(7);
+    ui->ruleTableWidget->setHorizontalHeaderLabels({"Category", "Subcategory", "Amount",
+                                                    "Starts", "Every", "Ends", "Account"});
+    ui->ruleTableWidget->horizontalHeader()->setStretchLastSection(true);
+    drawRules();
+
+    connect(ui->categoryLineEdit, &QLineEdit::textChanged,
+            this, &RecurringDialog::verifyRule);
+    connect(ui->subcategoryLineEdit, &QLineEdit::textChanged,
+            this, &RecurringDialog::verifyRule);
+    connect(ui->amountLineEdit, &QLineEdit::textChanged,
+            this, &RecurringDialog::verifyRule);
+    connect(ui->currencyLineEdit, &QLineEdit::textChanged,
+            this, &RecurringDialog::verifyRule);
+    connect(ui->addButton, &QPushButton::clicked,
+            this, &RecurringDialog::addRule);
+    connect(ui->removeButton, &QPushButton::clicked,
+            this, &RecurringDialog::removeRule);
+    connect(ui->closeButton, &QPushButton::clicked,
+            this, &QDialog::accept);
+    connect(ui->ruleTableWidget, &QTableWidget::itemSelectionChanged,
+            this, &RecurringDialog::verifyRemove);
+}
+
+/**
+ * @brief RecurringDialog::~RecurringDialog
+ *        Deallocates UI memory.
+ */
+RecurringDialog::~RecurringDialog()
+{
+    delete ui;
+}
+
+/**
+ * @brief RecurringDialog::rulesChanged
+ * @return true if any rule was added or removed
+ */
+bool RecurringDialog::rulesChanged() const
+{
+    return m_rulesChanged;
+}
+
+/**
+ * @brief RecurringDialog::drawRules
+ *        Fills rule table from schedule.
+ */
+void RecurringDialog::drawRules()
+{
+    const QStringList unitNames = {"day(s)", "week(s)", "month(s)", "year(s)"};
+    QVector<RecurringRule> rules = m_schedule->rules();
+
+    ui->ruleTableWidget->setRowCount(rules.size());
+    for (int row = 0; row < rules.size(); ++row) {
+        const RecurringRule &rule = rules.at(row);
+        QTableWidgetItem *categoryItem = new QTableWidgetItem(rule.category);
+        categoryItem->setData(Qt::UserRole, rule.ruleID);
+        ui->ruleTableWidget->setItem(row, 0, categoryItem);
+        ui->ruleTableWidget->setItem(row, 1, new QTableWidgetItem(rule.subcategory));
+        ui->ruleTableWidget->setItem(row, 2, new QTableWidgetItem(QString("%1 %2")
+                                                                      .arg(rule.amount)
+                                                                      .arg(rule.currency)));
+        ui->ruleTableWidget->setItem(row, 3, new QTableWidgetItem(rule.startDate.toString("yyyy/MM/dd")));
+        ui->ruleTableWidget->setItem(row, 4, new QTableWidgetItem(QString("%1 %2")
+                                                                      .arg(rule.intervalCount)
+                                                                      .arg(unitNames.at(rule.intervalUnit))));
+        ui->ruleTableWidget->setItem(row, 5, new QTableWidgetItem(rule.endDate.isValid()
+                                                                      ? rule.endDate.toString("yyyy/MM/dd")
+                                                                      : QString("never")));
+        ui->ruleTableWidget->setItem(row, 6, new QTableWidgetItem(m_accounts->name(rule.accountID)));
+    }
+    ui->ruleTableWidget->resizeColumnsToContents();
+}
+
+/**
+ * @brief RecurringDialog::addRule
+ *        Stores rule from input fields and redraws rule table.
+ */
+void RecurringDialog::addRule()
+{
+    RecurringRule rule;
+    rule.category = ui->categoryLineEdit->text();
+    rule.subcategory = ui->subcategoryLineEdit->text();
+    rule.amount = ui->amountLineEdit->text().toDouble();
+    rule.currency = ui->currencyLineEdit->text().trimmed().toUpper();
+    rule.accountID = ui->accountComboBox->currentData().toLongLong();
+    rule.startDate = ui->startDateEdit->date();
+    rule.intervalCount = ui->intervalSpinBox->value();
+    rule.intervalUnit = RecurringRule::Unit(ui->intervalUnitComboBox->currentIndex());
+    if (ui->endDateCheckBox->isChecked())
+        rule.endDate = ui->endDateEdit->date();
+
+    if (rule.endDate.isValid() && rule.endDate < rule.startDate) {
+        ui->statusLabel->setStyleSheet("color: red");
+        ui->statusLabel->setText("Rule ends before it starts");
+        return;
+    }
+    if (!m_schedule->addRule(rule)) {
+        ui->statusLabel->setStyleSheet("color: red");
+        ui->statusLabel->setText("Rule could not be saved");
+        return;
+    }
+
+    m_rulesChanged = true;
+    drawRules();
+    ui->statusLabel->setStyleSheet("color: green");
+    ui->statusLabel->setText("Rule added");
+    ui->categoryLineEdit->clear();
+    ui->subcategoryLineEdit->clear();
+    ui->amountLineEdit->clear();
+    ui->categoryLineEdit->setFocus();
+}
+
+/**
+ * @brief RecurringDialog::removeRule
+ *        Deletes selected rule and redraws rule table.
+ */
+void RecurringDialog::removeRule()
+{
+    int row = ui->ruleTableWidget->currentRow();
+    if (row < 0)
+        return;
+
+    qint64 ruleID = ui->ruleTableWidget->item(row, 0)->data(Qt::UserRole).toLongLong();
+    if (!m_schedule->removeRule(ruleID)) {
+        ui->statusLabel->setStyleSheet("color: red");
+        ui->statusLabel->setText("Rule could not be removed");
+        return;
+    }
+
+    m_rulesChanged = true;
+    drawRules();
+    ui->statusLabel->clear();
+}
+
+/**
+ * @brief RecurringDialog::verifyRule
+ *        Enables add button if category and subcategory are not empty,
+ *        amount is not 0 and currency is a 3-letter code,
+ *        disables button otherwise.
+ */
+void RecurringDialog::verifyRule()
+{
+    ui->statusLabel->clear();
+    bool valid = ui->categoryLineEdit->text() != ""
+                 && ui->subcategoryLineEdit->text() != ""
+                 && ui->amountLineEdit->text().toDouble() != 0
+                 && ui->currencyLineEdit->text().trimmed().size() == 3;
+    ui->addButton->setEnabled(valid);
+}
+
+/**
+ * @brief RecurringDialog::verifyRemove
+ *        Enables remove button if a rule is selected.
+ */
+void RecurringDialog::verifyRemove()
+{
+    ui->removeButton->setEnabled(!ui->ruleTableWidget->selectedItems().isEmpty());
+}
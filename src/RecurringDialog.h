@@ -0,0 +1,44 @@
+#pragma once
+
+#include "AccountList.h"
+#include "RecurringSchedule.h"
+
+#include <QDialog>
+
+namespace Ui {
+class RecurringDialog;
+}
+
+/**
+ * @brief The RecurringDialog class
+ *        Lists, adds and removes recurring transaction rules.
+ *
+ *        Used in BudgetTracker; rule changes are stored immediately.
+ */
+class RecurringDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    // constructor and destructor
+    RecurringDialog(RecurringSchedule *schedule, const AccountList *accounts,
+                    QWidget *parent = nullptr);
+    ~RecurringDialog();
+
+    // getter
+    bool rulesChanged() const;
+
+private slots:
+    void addRule();
+    void removeRule();
+    void verifyRule();
+    void verifyRemove();
+
+private:
+    Ui::RecurringDialog *ui;
+    RecurringSchedule *m_schedule;  // schedule being edited
+    const AccountList *m_accounts;  // accounts rules can belong to
+    bool m_rulesChanged = false;    // whether views need to be redrawn
+
+    void drawRules();
+};
@@ -0,0 +1,272 @@
+#include "RecurringSchedule.h"
+
+#include <QSqlQuery>
+
+#include <algorithm>
+
+namespace {
+const int ProjectionMonths = 3;     // how far past today projected entries are shown
+}
+
+/**
+ * @brief RecurringRule::occurrence
+ *        Date of the nth occurrence (0 is startDate).
+ *
+ *        Always offsets from startDate, so monthly rules starting on the
+ *        31st return to the 31st after shorter months.
+ * @param n occurrence number
+ * @return occurrence date
+ */
+QDate RecurringRule::occurrence(int n) const
+{
+    switch (intervalUnit) {
+    case Day:
+        return startDate.addDays(qint64(n) * intervalCount);
+    case Week:
+        return startDate.addDays(qint64(n) * intervalCount * 7);
+    case Month:
+        return startDate.addMonths(n * intervalCount);
+    case Year:
+        return startDate.addYears(n * intervalCount);
+    }
+    return startDate;
+}
+
+/**
+ * @brief RecurringRule::unitToString
+ * @param unit interval unit
+ * @return unit as stored in recurring table
+ */
+QString RecurringRule::unitToString(Unit unit)
+{
+    switch (unit) {
+    case Day:
+        return "day";
+    case Week:
+        return "week";
+    case Month:
+        return "month";
+    case Year:
+        return "year";
+    }
+    return "month";
+}
+
+/**
+ * @brief RecurringRule::unitFromString
+ * @param unit unit as stored in recurring table
+ * @return interval unit; Month if unrecognized
+ */
+RecurringRule::Unit RecurringRule::unitFromString(const QString &unit)
+{
+    if (unit == "day")
+        return Day;
+    if (unit == "week")
+        return Week;
+    if (unit == "year")
+        return Year;
+    return Month;
+}
+
+/**
+ * @brief RecurringSchedule::RecurringSchedule
+ *        Default constructor. Schedule is empty until load() is called.
+ */
+RecurringSchedule::RecurringSchedule() {}
+
+/**
+ * @brief RecurringSchedule::load
+ *        Loads all rules from recurring table.
+ *
+ *        Rules added or removed afterwards are stored on the same database.
+ * @param database open user database
+ */
+void RecurringSchedule::load(const QSqlDatabase &database)
+{
+    m_database = database;
+    m_rules.clear();
+
+    QSqlQuery query(m_database);
+    query.setForwardOnly(true);
+    query.exec("SELECT ruleID, category, subcategory, amount, "
+               "startDate, intervalCount, intervalUnit, endDate, currency, accountID "
+               "FROM recurring "
+               "ORDER BY ruleID");
+    while (query.next()) {
+        RecurringRule rule;
+        rule.ruleID = query.value(0).toLongLong();
+        rule.category = query.value(1).toString();
+        rule.subcategory = query.value(2).toString();
+        rule.amount = query.value(3).toDouble();
+        rule.startDate = QDate::fromString(query.value(4).toString(), "yyyy/MM/dd");
+        rule.intervalCount = std::max(1, query.value(5).toInt());
+        rule.intervalUnit = RecurringRule::unitFromString(query.value(6).toString());
+        rule.endDate = QDate::fromString(query.value(7).toString(), "yyyy/MM/dd");
+        rule.currency = query.value(8).toString();
+        rule.accountID = query.value(9).toLongLong();
+        if (rule.startDate.isValid())
+            m_rules.append(rule);
+    }
+}
+
+/**
+ * @brief RecurringSchedule::addRule
+ *        Stores new rule.
+ * @param rule rule to store; receives its ruleID
+ * @return true if rule was stored
+ */
+bool RecurringSchedule::addRule(RecurringRule &rule)
+{
+    QSqlQuery query(m_database);
+    query.prepare("INSERT INTO recurring "
+                  "(ruleID, category, subcategory, amount, "
+                  "startDate, intervalCount, intervalUnit, endDate, currency, accountID) "
+                  "VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    query.bindValue(0, rule.category);
+    query.bindValue(1, rule.subcategory);
+    query.bindValue(2, rule.amount);
+    query.bindValue(3, rule.startDate.toString("yyyy/MM/dd"));
+    query.bindValue(4, rule.intervalCount);
+    query.bindValue(5, RecurringRule::unitToString(rule.intervalUnit));
+    query.bindValue(6, rule.endDate.isValid() ? QVariant(rule.endDate.toString("yyyy/MM/dd"))
+                                              : QVariant());
+    query.bindValue(7, rule.currency);
+    query.bindValue(8, rule.accountID);
+    if (!query.exec())
+        return false;
+
+    rule.ruleID = query.lastInsertId().toLongLong();
+    m_rules.append(rule);
+    return true;
+}
+
+/**
+ * @brief RecurringSchedule::removeRule
+ *        Deletes rule; its projected entries disappear with it.
+ * @param ruleID ID of rule to delete
+ * @return true if rule was deleted
+ */
+bool RecurringSchedule::removeRule(qint64 ruleID)
+{
+    QSqlQuery query(m_database);
+    query.prepare("DELETE FROM recurring "
+                  "WHERE ruleID = ?");
+    query.bindValue(0, ruleID);
+    if (!query.exec())
+        return false;
+
+    m_rules.erase(std::remove_if(m_rules.begin(), m_rules.end(),
+                                 [ruleID](const RecurringRule &rule) {
+                                     return rule.ruleID == ruleID;
+                                 }),
+                  m_rules.end());
+    return true;
+}
+
+/**
+ * @brief RecurringSchedule::rules
+ * @return all loaded rules
+ */
+QVector<RecurringRule> RecurringSchedule::rules() const
+{
+    return m_rules;
+}
+
+/**
+ * @brief RecurringSchedule::occurrences
+ *        Generates projected entries within [from, to] for rules matching filter.
+ *
+ *        Each rule jumps straight to its first occurrence in range, so the
+ *        cost depends only on the number of occurrences returned.
+ * @param from first date of range
+ * @param to last date of range
+ * @param category category filter; empty for all rules
+ * @param subcategory subcategory filter; ignored if category is empty
+ * @return projected entries ordered by date and ruleID
+ */
+QVector<Transaction> RecurringSchedule::occurrences(const QDate &from, const QDate &to,
+                                                    const QString &category,
+                                                    const QString &subcategory) const
+{
+    QVector<Transaction> entries;
+    for (const RecurringRule &rule : m_rules) {
+        if (!category.isEmpty() && rule.category != category)
+            continue;
+        if (!category.isEmpty() && !subcategory.isEmpty() && rule.subcategory != subcategory)
+            continue;
+
+        QDate first = std::max(from, rule.startDate);
+        QDate last = rule.endDate.isValid() ? std::min(to, rule.endDate) : to;
+        if (first > last)
+            continue;
+
+        // estimate occurrence number at first, then correct for uneven months/years
+        int n = 0;
+        switch (rule.intervalUnit) {
+        case RecurringRule::Day:
+            n = rule.startDate.daysTo(first) / rule.intervalCount;
+            break;
+        case RecurringRule::Week:
+            n = rule.startDate.daysTo(first) / (7 * rule.intervalCount);
+            break;
+        case RecurringRule::Month:
+            n = ((first.year() - rule.startDate.year()) * 12
+                 + first.month() - rule.startDate.month()) / rule.intervalCount;
+            break;
+        case RecurringRule::Year:
+            n = (first.year() - rule.startDate.year()) / rule.intervalCount;
+            break;
+        }
+        n = std::max(0, n);
+        while (n > 0 && rule.occurrence(n - 1) >= first)
+            --n;
+        while (rule.occurrence(n) < first)
+            ++n;
+
+        for (QDate date = rule.occurrence(n); date <= last; date = rule.occurrence(++n)) {
+            Transaction entry;
+            entry.transactionID = n;
+            entry.date = date.toString("yyyy/MM/dd");
+            entry.category = rule.category;
+            entry.subcategory = rule.subcategory;
+            entry.amount = rule.amount;
+            entry.currency = rule.currency;
+            entry.accountID = rule.accountID;
+            entry.ruleID = rule.ruleID;
+            entries.append(entry);
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Transaction &a, const Transaction &b) {
+                  if (a.date != b.date)
+                      return a.date < b.date;
+                  if (a.ruleID != b.ruleID)
+                      return a.ruleID < b.ruleID;
+                  return a.transactionID < b.transactionID;
+              });
+    return entries;
+}
+
+/**
+ * @brief RecurringSchedule::earliestStart
+ * @return earliest rule start date; invalid if there are no rules
+ */
+QDate RecurringSchedule::earliestStart() const
+{
+    QDate earliest;
+    for (const RecurringRule &rule : m_rules) {
+        if (!earliest.isValid() || rule.startDate < earliest)
+            earliest = rule.startDate;
+    }
+    return earliest;
+}
+
+/**
+ * @brief RecurringSchedule::projectionHorizon
+ * @return last date projected entries are shown for in the table
+ */
+QDate RecurringSchedule::projectionHorizon()
+{
+    return QDate::currentDate().addMonths(ProjectionMonths);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Transaction.h"
+
+#include <QDate>
+#include <QSqlDatabase>
+#include <QVector>
+
+/**
+ * @brief The RecurringRule struct
+ *        One row of the recurring table: an entry repeated every
+ *        intervalCount intervalUnits from startDate until endDate.
+ */
+struct RecurringRule {
+    enum Unit { Day, Week, Month, Year };
+
+    qint64 ruleID = 0;
+    qint64 accountID = 0;
+    QString category;
+    QString subcategory;
+    double amount = 0;
+    QString currency;           // ISO 4217 code of amount
+    QDate startDate;
+    int intervalCount = 1;
+    Unit intervalUnit = Month;
+    QDate endDate;              // invalid if rule never ends
+
+    QDate occurrence(int n) const;
+
+    static QString unitToString(Unit unit);
+    static Unit unitFromString(const QString &unit);
+};
+
+/**
+ * @brief The RecurringSchedule class
+ *        Recurring transaction rules and lazy occurrence generation.
+ *
+ *        Rules are stored in the recurring table next to budget, but their
+ *        occurrences are never inserted: views ask for the occurrences
+ *        within the date range they show, and get projected entries
+ *        (ruleID set) that are generated on demand.
+ */
+class RecurringSchedule {
+public:
+    // constructor
+    RecurringSchedule();
+
+    // rule management
+    void load(const QSqlDatabase &database);
+    bool addRule(RecurringRule &rule);
+    bool removeRule(qint64 ruleID);
+    QVector<RecurringRule> rules() const;
+
+    // occurrence generation
+    QVector<Transaction> occurrences(const QDate &from, const QDate &to,
+                                     const QString &category = QString(),
+                                     const QString &subcategory = QString()) const;
+    QDate earliestStart() const;
+
+    static QDate projectionHorizon();
+
+private:
+    QSqlDatabase m_database;
+    QVector<RecurringRule> m_rules;
+};
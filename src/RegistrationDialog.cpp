@@ -51,8 +51,8 @@ void RegistrationDialog::registration()
     QString confirmPassword = ui->confirmPasswordLineEdit->text();
 
     if (verifyPassword(password, confirmPassword)) {
-        if (!db.verifyUsername(username)) {
-            db.registerUser(username, password);
+        // the unique username index also refuses one registered meanwhile
+        if (!db.verifyUsername(username) && db.registerUser(username, password)) {
             QDialog::accept();
         } else {
             ui->statusLabel->setStyleSheet("color: red");
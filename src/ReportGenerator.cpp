@@ -0,0 +1,329 @@
+#include "ReportGenerator.h"
+
+#include <QDate>
+#include <QFontMetrics>
+#include <QMap>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+namespace {
+const int MarginMm = 15;                    // page margin on every side
+const int BodyPointSize = 8;                // statement and summary rows
+const int HeadingPointSize = 12;            // report, month and section headings
+
+/**
+ * @brief The PageWriter class
+ *        Single-pass layout cursor over a paged paint device.
+ *
+ *        Keeps the vertical position on the current page and starts a new
+ *        page whenever the next block does not fit.
+ */
+class PageWriter
+{
+public:
+    PageWriter(QPainter &painter, QPagedPaintDevice &device, QPromise<QString> &promise)
+        : m_device(device)
+        , m_promise(promise)
+        , m_width(painter.viewport().width())
+        , m_height(painter.viewport().height())
+    {
+    }
+
+    // makes room for a block of height, breaking the page if needed
+    bool reserve(int height)
+    {
+        if (m_y + height <= m_height)
+            return true;
+        return newPage();
+    }
+
+    bool newPage()
+    {
+        if (m_promise.isCanceled() || !m_device.newPage())
+            return false;
+        ++m_pages;
+        m_promise.setProgressValue(m_pages);
+        m_y = 0;
+        return true;
+    }
+
+    int y() const { return m_y; }
+    void advance(int height) { m_y += height; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int pages() const { return m_pages; }
+
+private:
+    QPagedPaintDevice &m_device;
+    QPromise<QString> &m_promise;
+    int m_width;
+    int m_height;
+    int m_y = 0;
+    int m_pages = 1;
+};
+
+/**
+ * @brief drawRow
+ *        Draws one table row of cells at the current position.
+ * @param painter painter on the report
+ * @param page layout cursor
+ * @param columns left edge of each column
+ * @param cells text of each column
+ * @param rowHeight height of the row
+ */
+void drawRow(QPainter &painter, PageWriter &page, const QVector<int> &columns,
+             const QStringList &cells, int rowHeight)
+{
+    for (int i = 0; i < cells.size(); ++i) {
+        int right = i + 1 < columns.size() ? columns.at(i + 1) : page.width();
+        QRect cell(columns.at(i), page.y(), right - columns.at(i) - rowHeight / 4, rowHeight);
+        // amounts and balances are right-aligned
+        Qt::Alignment alignment = i >= cells.size() - 2 ? Qt::AlignRight : Qt::AlignLeft;
+        painter.drawText(cell, alignment | Qt::AlignVCenter,
+                         painter.fontMetrics().elidedText(cells.at(i), Qt::ElideRight, cell.width()));
+    }
+    page.advance(rowHeight);
+}
+}
+
+/**
+ * @brief ReportGenerator::ReportGenerator
+ *        Creates idle report generator.
+ * @param parent pointer to QObject parent object
+ */
+ReportGenerator::ReportGenerator(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcher<QString>::progressValueChanged,
+            this, &ReportGenerator::progress);
+    connect(&m_watcher, &QFutureWatcher<QString>::finished,
+            this, &ReportGenerator::done);
+}
+
+/**
+ * @brief ReportGenerator::~ReportGenerator
+ *        Cancels running report and waits for it.
+ */
+ReportGenerator::~ReportGenerator()
+{
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+}
+
+/**
+ * @brief ReportGenerator::startPdf
+ *        Starts rendering report to a PDF file.
+ * @param snapshot report data
+ * @param path PDF file path
+ * @return false if a report is already running
+ */
+bool ReportGenerator::startPdf(const ReportSnapshot &snapshot, const QString &path)
+{
+    if (m_watcher.isRunning())
+        return false;
+    m_watcher.setFuture(QtConcurrent::run(&ReportGenerator::run, snapshot, path,
+                                          std::shared_ptr<QPrinter>()));
+    return true;
+}
+
+/**
+ * @brief ReportGenerator::startPrint
+ *        Starts rendering report to a printer set up on the GUI thread.
+ * @param snapshot report data
+ * @param printer configured printer; only used by the worker until finished
+ * @return false if a report is already running
+ */
+bool ReportGenerator::startPrint(const ReportSnapshot &snapshot, std::shared_ptr<QPrinter> printer)
+{
+    if (m_watcher.isRunning())
+        return false;
+    m_watcher.setFuture(QtConcurrent::run(&ReportGenerator::run, snapshot, QString(), printer));
+    return true;
+}
+
+/**
+ * @brief ReportGenerator::cancel
+ *        Stops running report after the current page.
+ */
+void ReportGenerator::cancel()
+{
+    m_watcher.cancel();
+}
+
+/**
+ * @brief ReportGenerator::isRunning
+ * @return true while a report is rendering
+ */
+bool ReportGenerator::isRunning() const
+{
+    return m_watcher.isRunning();
+}
+
+/**
+ * @brief ReportGenerator::done
+ *        Reports finished (or cancelled) report.
+ */
+void ReportGenerator::done()
+{
+    if (m_watcher.isCanceled()) {
+        emit finished(0, "Report cancelled");
+        return;
+    }
+    emit finished(m_watcher.progressValue(), m_watcher.result());
+}
+
+/**
+ * @brief ReportGenerator::run
+ *        Worker: lays out and paints the report page by page.
+ *
+ *        PDF output goes to a QSaveFile, so a failed or cancelled report
+ *        leaves no partial file behind.
+ * @param promise reports pages painted and observes cancellation;
+ *        receives an error message, empty on success
+ * @param snapshot report data
+ * @param path PDF file path; ignored if printer is set
+ * @param printer printer to paint on; null to write path
+ */
+void ReportGenerator::run(QPromise<QString> &promise, const ReportSnapshot &snapshot,
+                          const QString &path, std::shared_ptr<QPrinter> printer)
+{
+    QSaveFile file(path);
+    std::unique_ptr<QPdfWriter> writer;
+    QPagedPaintDevice *device = printer.get();
+    if (!device) {
+        if (!file.open(QIODevice::WriteOnly)) {
+            promise.addResult(file.errorString());
+            return;
+        }
+        writer = std::make_unique<QPdfWriter>(&file);
+        writer->setTitle(QString("BudgetTracker Report: %1").arg(snapshot.title));
+        writer->setPageSize(QPageSize(QPageSize::A4));
+        device = writer.get();
+    }
+    device->setPageMargins(QMarginsF(MarginMm, MarginMm, MarginMm, MarginMm),
+                           QPageLayout::Millimeter);
+
+    QPainter painter;
+    if (!painter.begin(device)) {
+        promise.addResult(QString("Report could not be written to %1")
+                              .arg(printer ? printer->printerName() : path));
+        return;
+    }
+    PageWriter page(painter, *device, promise);
+    promise.setProgressValue(1);
+
+    QFont bodyFont = painter.font();
+    bodyFont.setPointSize(BodyPointSize);
+    QFont headingFont = bodyFont;
+    headingFont.setPointSize(HeadingPointSize);
+    headingFont.setBold(true);
+    painter.setFont(headingFont);
+    const int headingHeight = painter.fontMetrics().height() * 2;
+    painter.setFont(bodyFont);
+    const int rowHeight = painter.fontMetrics().height() * 5 / 4;
+
+    // chart page
+    painter.setFont(headingFont);
+    painter.drawText(QRect(0, 0, page.width(), headingHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                     QString("Report: %1 (%2)").arg(snapshot.title, snapshot.currency));
+    page.advance(headingHeight);
+    if (!snapshot.chart.isNull()) {
+        QSize size = snapshot.chart.size().scaled(page.width(), page.height() - page.y(),
+                                                  Qt::KeepAspectRatio);
+        painter.drawImage(QRect(QPoint(0, page.y()), size), snapshot.chart);
+        page.advance(size.height());
+    }
+
+    // monthly statements, laid out row by row
+    const QVector<int> columns{0, page.width() * 12 / 100, page.width() * 26 / 100,
+                               page.width() * 44 / 100, page.width() * 62 / 100,
+                               page.width() * 80 / 100};
+    const QStringList header{"Date", "Account", "Category", "Subcategory",
+                             "Amount", QString("Balance (%1)").arg(snapshot.currency)};
+    QMap<QString, double> categoryTotals;
+    QString month;
+    double monthTotal = 0;
+    bool ok = page.newPage();
+    for (int i = 0; ok && i <= snapshot.entries.size(); ++i) {
+        bool last = i == snapshot.entries.size();
+        QString entryMonth = last ? QString() : snapshot.entries.at(i).date.left(7);
+        if (entryMonth != month && !month.isEmpty()) {
+            painter.setFont(bodyFont);
+            ok = page.reserve(rowHeight);
+            if (!ok)
+                break;
+            drawRow(painter, page, columns,
+                    {"", "", "", "Month total", QString::number(monthTotal, 'f', 2), ""},
+                    rowHeight);
+        }
+        if (last)
+            break;
+
+        const Transaction &entry = snapshot.entries.at(i);
+        if (entryMonth != month) {
+            month = entryMonth;
+            monthTotal = 0;
+            // keep month heading together with its column header and first row
+            ok = page.reserve(headingHeight + 2 * rowHeight);
+            if (!ok)
+                break;
+            painter.setFont(headingFont);
+            painter.drawText(QRect(0, page.y(), page.width(), headingHeight),
+                             Qt::AlignLeft | Qt::AlignBottom,
+                             QDate::fromString(entry.date, "yyyy/MM/dd").toString("MMMM yyyy"));
+            page.advance(headingHeight);
+            painter.setFont(bodyFont);
+            drawRow(painter, page, columns, header, rowHeight);
+            painter.drawLine(0, page.y(), page.width(), page.y());
+        }
+        ok = page.reserve(rowHeight);
+        if (!ok)
+            break;
+        drawRow(painter, page, columns,
+                {entry.date, snapshot.accountNames.value(entry.accountID), entry.category,
+                 entry.subcategory,
+                 QString("%1 %2").arg(QString::number(entry.amount, 'f', 2), entry.currency),
+                 QString::number(snapshot.balances.at(i), 'f', 2)},
+                rowHeight);
+        monthTotal += snapshot.converted.at(i);
+        categoryTotals[entry.category] += snapshot.converted.at(i);
+    }
+
+    // category summary
+    ok = ok && page.newPage();
+    if (ok) {
+        painter.setFont(headingFont);
+        painter.drawText(QRect(0, 0, page.width(), headingHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                         QString("Category Summary (%1)").arg(snapshot.currency));
+        page.advance(headingHeight);
+        painter.setFont(bodyFont);
+        const QVector<int> summaryColumns{0, page.width() / 2};
+        for (auto it = categoryTotals.constBegin(); ok && it != categoryTotals.constEnd(); ++it) {
+            ok = page.reserve(rowHeight);
+            if (ok) {
+                drawRow(painter, page, summaryColumns,
+                        {it.key(), QString::number(it.value(), 'f', 2)}, rowHeight);
+            }
+        }
+    }
+    ok = painter.end() && ok;
+
+    if (promise.isCanceled()) {
+        if (!printer)
+            file.cancelWriting();
+        return;
+    }
+    if (!ok) {
+        if (!printer)
+            file.cancelWriting();
+        promise.addResult(QString("Report could not be completed"));
+        return;
+    }
+    if (!printer && !file.commit()) {
+        promise.addResult(file.errorString());
+        return;
+    }
+    promise.addResult(QString());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Transaction.h"
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPrinter>
+#include <QPromise>
+#include <QVector>
+
+#include <memory>
+
+/**
+ * @brief The ReportSnapshot struct
+ *        Copy of everything a report shows, taken on the GUI thread.
+ */
+struct ReportSnapshot {
+    QString title;                          // filter description, e.g. "All Transactions"
+    QString currency;                       // display currency of converted amounts and balances
+    QVector<Transaction> entries;           // stored entries, ordered by date
+    QVector<double> converted;              // amount of each entry in display currency
+    QVector<double> balances;               // running balance after each entry
+    QHash<qint64, QString> accountNames;    // account name by accountID
+    QImage chart;                           // rendered plot; may be null
+};
+
+/**
+ * @brief The ReportGenerator class
+ *        Renders multi-page statement reports to PDF or a printer on a
+ *        worker thread.
+ *
+ *        A report is a chart page, one statement per month with its
+ *        entries and running balance, and a category summary. Pages are
+ *        laid out in a single pass while painting: row height is measured
+ *        once and a new page starts whenever the next row would not fit,
+ *        so the cost is linear in the number of entries. The chart has to
+ *        be grabbed on the GUI thread and is passed in as an image.
+ */
+class ReportGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    // constructor and destructor
+    explicit ReportGenerator(QObject *parent = nullptr);
+    ~ReportGenerator();
+
+    // report requests
+    bool startPdf(const ReportSnapshot &snapshot, const QString &path);
+    bool startPrint(const ReportSnapshot &snapshot, std::shared_ptr<QPrinter> printer);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void progress(int pages);
+    void finished(int pages, const QString &error);
+
+private slots:
+    void done();
+
+private:
+    QFutureWatcher<QString> m_watcher;
+
+    static void run(QPromise<QString> &promise, const ReportSnapshot &snapshot,
+                    const QString &path, std::shared_ptr<QPrinter> printer);
+};
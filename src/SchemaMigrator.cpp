@@ -0,0 +1,221 @@
+#include "SchemaMigrator.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSqlError>
+
+#include <algorithm>
+
+/**
+ * @brief SchemaMigrator::SchemaMigrator
+ *        Creates migrator without migrations.
+ * @param database open database to migrate, without a transaction in progress
+ */
+SchemaMigrator::SchemaMigrator(const QSqlDatabase &database)
+    : m_database(database)
+{
+}
+
+/**
+ * @brief SchemaMigrator::add
+ *        Registers a migration applied in a single transaction.
+ * @param version schema version after the migration
+ * @param description what the migration changes
+ * @param step migration; returns false on failure, with query holding the error
+ */
+void SchemaMigrator::add(int version, const QString &description, Step step)
+{
+    Migration migration;
+    migration.version = version;
+    migration.description = description;
+    migration.step = step;
+    m_migrations.append(migration);
+}
+
+/**
+ * @brief SchemaMigrator::addChunked
+ *        Registers a migration applied a chunk at a time.
+ *
+ *        The step gets the cursor of the previous chunk (0 at first), works
+ *        on at most rows rows after it and advances it. The cursor is
+ *        committed with the chunk, which makes the migration resumable.
+ * @param version schema version after the migration
+ * @param description what the migration changes
+ * @param step chunk of the migration
+ */
+void SchemaMigrator::addChunked(int version, const QString &description, ChunkStep step)
+{
+    Migration migration;
+    migration.version = version;
+    migration.description = description;
+    migration.chunkStep = step;
+    m_migrations.append(migration);
+}
+
+/**
+ * @brief SchemaMigrator::migrate
+ *        Applies all migrations newer than the database's version, in
+ *        version order, stopping at the first failure.
+ * @return true if database is at the latest version
+ */
+bool SchemaMigrator::migrate()
+{
+    std::sort(m_migrations.begin(), m_migrations.end(),
+              [](const Migration &a, const Migration &b) { return a.version < b.version; });
+
+    int current = version();
+    if (!m_migrations.isEmpty() && current > m_migrations.last().version) {
+        qWarning() << "Schema version" << current << "is newer than this program's"
+                   << m_migrations.last().version;
+    }
+    for (const Migration &migration : m_migrations) {
+        if (migration.version <= current)
+            continue;
+
+        QElapsedTimer timer;
+        timer.start();
+        int chunks = 1;
+        bool applied = migration.chunkStep ? applyChunked(migration, &chunks) : apply(migration);
+        if (!applied)
+            return false;
+        qDebug().noquote() << QString("Schema: migration %1 (%2) took %3 ms in %4 transaction(s)")
+                                  .arg(migration.version).arg(migration.description)
+                                  .arg(timer.elapsed()).arg(chunks);
+        current = migration.version;
+    }
+    return true;
+}
+
+/**
+ * @brief SchemaMigrator::version
+ * @return schema version of the database; 0 if never migrated
+ */
+int SchemaMigrator::version() const
+{
+    QSqlQuery query(m_database);
+    if (!query.exec("PRAGMA user_version") || !query.next())
+        return 0;
+    return query.value(0).toInt();
+}
+
+/**
+ * @brief SchemaMigrator::lastError
+ * @return description of the last failed migration
+ */
+QString SchemaMigrator::lastError() const
+{
+    return m_lastError;
+}
+
+/**
+ * @brief SchemaMigrator::apply
+ *        Applies migration and its version bump in one transaction.
+ * @param migration single-transaction migration
+ * @return true if committed
+ */
+bool SchemaMigrator::apply(const Migration &migration)
+{
+    if (!m_database.transaction())
+        return fail(migration, m_database.lastError().text());
+
+    QSqlQuery query(m_database);
+    if (!migration.step(query) || !setVersion(query, migration.version)) {
+        QString error = query.lastError().text();
+        m_database.rollback();
+        return fail(migration, error);
+    }
+    if (!m_database.commit()) {
+        QString error = m_database.lastError().text();
+        m_database.rollback();
+        return fail(migration, error);
+    }
+    return true;
+}
+
+/**
+ * @brief SchemaMigrator::applyChunked
+ *        Applies migration one chunk per transaction, committing its cursor
+ *        with each chunk. The version is bumped with the last chunk.
+ * @param migration chunked migration
+ * @param chunks receives number of transactions committed
+ * @return true if all chunks are committed
+ */
+bool SchemaMigrator::applyChunked(const Migration &migration, int *chunks)
+{
+    QSqlQuery query(m_database);
+    if (!query.exec("CREATE TABLE IF NOT EXISTS schema_progress ("
+                    "version INTEGER PRIMARY KEY, "
+                    "cursor INTEGER)"))
+        return fail(migration, query.lastError().text());
+
+    // resume after the last committed chunk
+    qint64 cursor = 0;
+    query.prepare("SELECT cursor "
+                  "FROM schema_progress "
+                  "WHERE version = ?");
+    query.bindValue(0, migration.version);
+    if (query.exec() && query.next())
+        cursor = query.value(0).toLongLong();
+
+    *chunks = 0;
+    while (true) {
+        if (!m_database.transaction())
+            return fail(migration, m_database.lastError().text());
+
+        int rows = migration.chunkStep(query, &cursor, ChunkRows);
+        bool ok = rows >= 0;
+        if (ok && rows > 0) {
+            query.prepare("INSERT OR REPLACE INTO schema_progress "
+                          "(version, cursor) "
+                          "VALUES (?, ?)");
+            query.bindValue(0, migration.version);
+            query.bindValue(1, cursor);
+            ok = query.exec();
+        } else if (ok) {
+            query.prepare("DELETE FROM schema_progress "
+                          "WHERE version = ?");
+            query.bindValue(0, migration.version);
+            ok = query.exec() && setVersion(query, migration.version);
+        }
+        if (!ok) {
+            QString error = query.lastError().text();
+            m_database.rollback();
+            return fail(migration, error);
+        }
+        if (!m_database.commit()) {
+            QString error = m_database.lastError().text();
+            m_database.rollback();
+            return fail(migration, error);
+        }
+        ++*chunks;
+        if (rows == 0)
+            return true;
+    }
+}
+
+/**
+ * @brief SchemaMigrator::setVersion
+ *        Sets PRAGMA user_version; part of the surrounding transaction.
+ * @param query query on the migrated database
+ * @param version new schema version
+ * @return true on success
+ */
+bool SchemaMigrator::setVersion(QSqlQuery &query, int version)
+{
+    return query.exec(QString("PRAGMA user_version = %1").arg(version));
+}
+
+/**
+ * @brief SchemaMigrator::fail
+ *        Records and logs failed migration.
+ * @param migration failed migration
+ * @param error database error
+ * @return false
+ */
+bool SchemaMigrator::fail(const Migration &migration, const QString &error)
+{
+    m_lastError = QString("Migration %1 (%2) failed: %3")
+                      .arg(migration.version).arg(migration.description, error);
+    qWarning().noquote() << "Schema:" << m_lastError;
+    return false;
+}
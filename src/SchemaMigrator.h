@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The SchemaMigrator class
+ *        Ordered, versioned schema migrations of an SQLite database.
+ *
+ *        The schema version is kept in PRAGMA user_version. Pending
+ *        migrations are applied in version order, each in its own
+ *        transaction together with its version bump, so a failed step
+ *        leaves the database at the previous version.
+ *
+ *        Chunked migrations rewrite large tables a chunk at a time, each
+ *        chunk in its own short transaction, so the write lock is never held
+ *        for long. Their cursor is stored with each chunk, and an interrupted
+ *        migration resumes after the last committed chunk. Time taken per
+ *        migration is logged.
+ */
+class SchemaMigrator
+{
+public:
+    typedef bool (*Step)(QSqlQuery &query);
+    typedef int (*ChunkStep)(QSqlQuery &query, qint64 *cursor, int rows);
+
+    static const int ChunkRows = 20000;     // rows rewritten per chunk transaction
+
+    // constructor
+    explicit SchemaMigrator(const QSqlDatabase &database);
+
+    // migrations
+    void add(int version, const QString &description, Step step);
+    void addChunked(int version, const QString &description, ChunkStep step);
+    bool migrate();
+
+    // getters
+    int version() const;
+    QString lastError() const;
+
+private:
+    /**
+     * @brief The Migration struct
+     *        One schema change and the version it leads to.
+     */
+    struct Migration {
+        int version = 0;
+        QString description;
+        Step step = nullptr;            // single-transaction migration
+        ChunkStep chunkStep = nullptr;  // chunked migration; returns rows visited, 0 when done, -1 on error
+    };
+
+    QSqlDatabase m_database;
+    QVector<Migration> m_migrations;
+    QString m_lastError;
+
+    bool apply(const Migration &migration);
+    bool applyChunked(const Migration &migration, int *chunks);
+    bool setVersion(QSqlQuery &query, int version);
+    bool fail(const Migration &migration, const QString &error);
+};
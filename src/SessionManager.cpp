@@ -0,0 +1,108 @@
+#include "SessionManager.h"
+#include "BudgetTracker.h"
+#include "LoginDialog.h"
+#include "StartupProfile.h"
+
+#include <QApplication>
+
+/**
+ * @brief SessionManager::SessionManager
+ *        Creates manager without sessions. Call login() to open the first.
+ * @param parent pointer to QObject parent object
+ */
+SessionManager::SessionManager(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief SessionManager::~SessionManager
+ *        Closes sessions that are still open.
+ */
+SessionManager::~SessionManager()
+{
+    qDeleteAll(sessions);
+}
+
+/**
+ * @brief SessionManager::login
+ *        Shows LoginDialog and opens a window for the logged in user.
+ *
+ *        A user who is already logged in gets another window on their
+ *        open session, so the ledger is not opened or loaded again. Their
+ *        password cannot be reset from the dialog, as the open session
+ *        keeps reading the ledger with the key of the old one.
+ * @param parent parent of the login dialog
+ * @return true if a user logged in
+ */
+bool SessionManager::login(QWidget *parent)
+{
+    LoginDialog loginDialog(parent);
+    loginDialog.setLoggedInUsers(sessions.keys());
+    if (loginDialog.exec() != QDialog::Accepted)
+        return false;
+    StartupProfile::start();
+
+    std::shared_ptr<User> user = loginDialog.user();
+    LedgerSession *session = sessions.value(user->getUserID());
+    if (!session) {
+        session = new LedgerSession(user, this);
+        sessions.insert(user->getUserID(), session);
+        connect(session, &LedgerSession::lastWindowDetached,
+                this, &SessionManager::closeSession);
+    }
+    openWindow(session);
+    return true;
+}
+
+/**
+ * @brief SessionManager::openWindow
+ *        Opens a new BudgetTracker window on session.
+ *
+ *        Connected to BudgetTracker newWindowRequested signal.
+ * @param session session to show
+ */
+void SessionManager::openWindow(LedgerSession *session)
+{
+    StartupProfile::start();
+    BudgetTracker *window = new BudgetTracker(session);
+    window->setAttribute(Qt::WA_DeleteOnClose);
+    connect(window, &BudgetTracker::newWindowRequested,
+            this, &SessionManager::openWindow);
+    connect(window, &BudgetTracker::switchUserRequested,
+            this, &SessionManager::switchUser);
+    window->show();
+}
+
+/**
+ * @brief SessionManager::switchUser
+ *        Logs in another user and closes window once their window is open.
+ *
+ *        The window stays open if the login is cancelled, or if it refuses
+ *        to close because of pending entries.
+ *        Connected to BudgetTracker switchUserRequested signal.
+ * @param window window to replace
+ */
+void SessionManager::switchUser(QWidget *window)
+{
+    if (login(window))
+        window->close();
+}
+
+/**
+ * @brief SessionManager::closeSession
+ *        Closes session whose last window was closed, and quits once no
+ *        session is left.
+ *
+ *        Connected to LedgerSession lastWindowDetached signal.
+ */
+void SessionManager::closeSession()
+{
+    LedgerSession *session = qobject_cast<LedgerSession*>(sender());
+    if (!session)
+        return;
+    sessions.remove(session->user()->getUserID());
+    session->deleteLater();
+    if (sessions.isEmpty())
+        QApplication::quit();
+}
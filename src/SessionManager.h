@@ -0,0 +1,38 @@
+#pragma once
+
+#include "LedgerSession.h"
+
+#include <QHash>
+#include <QObject>
+
+class BudgetTracker;
+
+/**
+ * @brief The SessionManager class
+ *        Logs users in and keeps one LedgerSession per logged-in user.
+ *
+ *        Windows of the same user share that user's session; a session is
+ *        closed with its last window. Switching users logs in another user
+ *        and opens their window before closing the current one, all in the
+ *        same process. The application quits once no session is left.
+ */
+class SessionManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    // constructor and destructor
+    explicit SessionManager(QObject *parent = nullptr);
+    ~SessionManager();
+
+    // sessions
+    bool login(QWidget *parent = nullptr);
+
+private slots:
+    void openWindow(LedgerSession *session);
+    void switchUser(QWidget *window);
+    void closeSession();
+
+private:
+    QHash<int, LedgerSession*> sessions;    // open session per userID
+};
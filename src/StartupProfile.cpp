@@ -0,0 +1,65 @@
+#include "StartupProfile.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+namespace {
+QElapsedTimer startupTimer;     // runs from start() to finish()
+qint64 lastMarkMs = 0;          // elapsed time at the previous mark
+}
+
+/**
+ * @brief StartupProfile::start
+ *        Starts timing a window startup. Does nothing if one is already
+ *        being timed, so nested entry points share one profile.
+ */
+void StartupProfile::start()
+{
+    if (startupTimer.isValid())
+        return;
+    startupTimer.start();
+    lastMarkMs = 0;
+}
+
+/**
+ * @brief StartupProfile::mark
+ *        Logs the end of a startup phase. Ignored when not profiling.
+ * @param phase phase description
+ */
+void StartupProfile::mark(const QString &phase)
+{
+    if (!startupTimer.isValid())
+        return;
+    qint64 elapsed = startupTimer.elapsed();
+    qDebug().noquote() << QString("Startup: %1 at %2 ms (+%3 ms)")
+                              .arg(phase).arg(elapsed).arg(elapsed - lastMarkMs);
+    lastMarkMs = elapsed;
+}
+
+/**
+ * @brief StartupProfile::markFirstPaint
+ *        Logs first paint of the window and warns if it missed its target.
+ */
+void StartupProfile::markFirstPaint()
+{
+    if (!startupTimer.isValid())
+        return;
+    mark("first paint");
+    if (startupTimer.elapsed() > FirstPaintTargetMs) {
+        qWarning().noquote() << QString("Startup: first paint took %1 ms, target is %2 ms")
+                                    .arg(startupTimer.elapsed()).arg(FirstPaintTargetMs);
+    }
+}
+
+/**
+ * @brief StartupProfile::finish
+ *        Logs the last startup phase and stops profiling.
+ * @param phase phase description
+ */
+void StartupProfile::finish(const QString &phase)
+{
+    if (!startupTimer.isValid())
+        return;
+    mark(phase);
+    startupTimer.invalidate();
+}
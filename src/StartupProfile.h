@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QString>
+
+/**
+ * @brief The StartupProfile class
+ *        Wall-clock profile of opening a ledger window.
+ *
+ *        Timing starts once a login is accepted (or a window is requested)
+ *        and each startup phase is logged with its time since start and
+ *        since the previous phase. The profile ends when the window has
+ *        painted and its data is fully loaded; time to first paint is
+ *        checked against FirstPaintTargetMs.
+ */
+class StartupProfile
+{
+public:
+    static const qint64 FirstPaintTargetMs = 300;   // first paint budget, including opening the ledger
+
+    static void start();
+    static void mark(const QString &phase);
+    static void markFirstPaint();
+    static void finish(const QString &phase);
+};
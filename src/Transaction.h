@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QString>
+
+/**
+ * @brief The Transaction struct
+ *        Plain copy of one row of the budget table.
+ *
+ *        Passed between the entry journal and the views so they
+ *        can update in place without re-querying the database.
+ */
+struct Transaction {
+    qint64 transactionID = 0;   // budget table primary key; 0 if not yet inserted
+                                // (occurrence number for projected entries)
+    qint64 accountID = 0;       // account the entry belongs to
+    QString date;               // "yyyy/MM/dd"
+    QString category;
+    QString subcategory;
+    double amount = 0;
+    QString currency;           // ISO 4217 code of amount
+    qint64 ruleID = 0;          // recurring rule that projected this entry; 0 for stored entries
+};
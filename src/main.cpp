@@ -1,18 +1,33 @@
-#include "LoginDialog.h"
-#include "BudgetTracker.h"
+#include "LedgerBench.h"
+#include "LedgerStress.h"
+#include "LoginAudit.h"
+#include "SessionManager.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
-    LoginDialog login;
-    login.show();
-    if (login.exec() == QDialog::Accepted) {
-        BudgetTracker tracker(login.user());
-        tracker.show();
-        return app.exec();
+    // encrypted against unencrypted ledger throughput, without login or windows
+    if (LedgerBench::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return LedgerBench::run(app.arguments());
+    }
+    // stress test of concurrent ledger writers, without login or windows
+    if (LedgerStress::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return LedgerStress::run(app.arguments());
     }
-    else
+
+    QApplication app(argc, argv);
+    // windows come and go while switching users; sessions decide when to quit
+    app.setQuitOnLastWindowClosed(false);
+    SessionManager sessions;
+    if (!sessions.login()) {
+        LoginAudit::flush();
         return 0;
+    }
+    int result = app.exec();
+    // audit events are written in the background; let them reach the disk
+    LoginAudit::flush();
+    return result;
 }